@@ -0,0 +1,309 @@
+#ifndef EC_BenchmarkHarness_Hpp
+#define EC_BenchmarkHarness_Hpp
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include "../include/CpuFeatures.hpp"
+
+
+namespace EC
+{
+	/// \brief Helpers shared by the benchmark executables: timing and JSON output.
+	namespace Bench
+	{
+		/// \brief Wall-clock stopwatch
+		class Stopwatch
+		{
+		public:
+			Stopwatch() : m_start(std::chrono::steady_clock::now())
+			{ }
+
+			inline void Restart()
+			{
+				m_start = std::chrono::steady_clock::now();
+			}
+
+			/// \return Seconds since construction or the last Restart
+			inline double Seconds() const
+			{
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+			}
+
+		private:
+			std::chrono::steady_clock::time_point m_start;
+		};
+
+
+		/// \brief Result of a microbenchmark
+		struct Measurement
+		{
+			std::string        name;
+			unsigned long long calls;          // Calls in the fastest repetition
+			double             seconds;        // Duration of the fastest repetition
+			double             itemsPerCall;   // e.g. draws, genes or individuals per call
+
+			inline double NanosecondsPerItem() const
+			{
+				return 1e9 * seconds / (calls * itemsPerCall);
+			}
+
+			inline double ItemsPerSecond() const
+			{
+				return calls * itemsPerCall / seconds;
+			}
+		};
+
+
+		/// \brief Time a function. The number of calls per repetition doubles until a repetition
+		///        lasts minSeconds; the fastest of the repetitions is kept.
+		/// \param[in] name. Name of the benchmark
+		/// \param[in] func. Function to time, called without argument
+		/// \param[in] itemsPerCall. Work done by one call, for the per-item figures
+		/// \param[in] minSeconds. Minimum duration of a repetition
+		/// \param[in] repetitions. Number of repetitions
+		/// \return The measurement
+		template<typename Func>
+		Measurement Measure(
+			const std::string& name,
+			Func func,
+			double itemsPerCall,
+			double minSeconds = 0.1,
+			unsigned int repetitions = 5)
+		{
+			// Warm up caches, lazily created thread pools and buffers
+			func();
+
+			unsigned long long calls = 1;
+			double seconds = 0;
+			while (true)
+			{
+				Stopwatch stopwatch;
+				for (unsigned long long i = 0; i < calls; i++)
+				{
+					func();
+				}
+				seconds = stopwatch.Seconds();
+				if (seconds >= minSeconds)
+				{
+					break;
+				}
+				calls *= 2;
+			}
+
+			Measurement result = { name, calls, seconds, itemsPerCall };
+			for (unsigned int r = 1; r < repetitions; r++)
+			{
+				Stopwatch stopwatch;
+				for (unsigned long long i = 0; i < calls; i++)
+				{
+					func();
+				}
+				result.seconds = std::min(result.seconds, stopwatch.Seconds());
+			}
+			return result;
+		}
+
+
+		/// \brief Minimal streaming JSON writer. Commas are inserted automatically.
+		class JsonWriter
+		{
+		public:
+			/// \param[in] stream. Destination
+			JsonWriter(std::ostream& stream) : m_stream(stream), m_needComma(false), m_afterKey(false), m_depth(0)
+			{ }
+
+			inline JsonWriter& BeginObject()
+			{
+				Open('{');
+				return *this;
+			}
+
+			inline JsonWriter& EndObject()
+			{
+				Close('}');
+				return *this;
+			}
+
+			inline JsonWriter& BeginArray()
+			{
+				Open('[');
+				return *this;
+			}
+
+			inline JsonWriter& EndArray()
+			{
+				Close(']');
+				return *this;
+			}
+
+			/// \brief Write an object key; the next call writes its value
+			inline JsonWriter& Key(const std::string& key)
+			{
+				Separate();
+				WriteString(key);
+				m_stream << ": ";
+				m_needComma = false;
+				m_afterKey = true;
+				return *this;
+			}
+
+			inline JsonWriter& Value(const std::string& value)
+			{
+				Separate();
+				WriteString(value);
+				m_needComma = true;
+				return *this;
+			}
+
+			inline JsonWriter& Value(const char* value)
+			{
+				return Value(std::string(value));
+			}
+
+			inline JsonWriter& Value(double value)
+			{
+				Separate();
+				if (value != value || value - value != 0)
+				{
+					m_stream << "null";   // NaN and infinities are not valid JSON
+				}
+				else
+				{
+					char buffer[32];
+					std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+					m_stream << buffer;
+				}
+				m_needComma = true;
+				return *this;
+			}
+
+			inline JsonWriter& Value(unsigned long long value)
+			{
+				Separate();
+				m_stream << value;
+				m_needComma = true;
+				return *this;
+			}
+
+			inline JsonWriter& Value(unsigned int value)
+			{
+				return Value(static_cast<unsigned long long>(value));
+			}
+
+			inline JsonWriter& Value(bool value)
+			{
+				Separate();
+				m_stream << (value ? "true" : "false");
+				m_needComma = true;
+				return *this;
+			}
+
+		private:
+			inline void Separate()
+			{
+				if (m_afterKey)
+				{
+					m_afterKey = false;
+					return;
+				}
+				if (m_needComma)
+				{
+					m_stream << ',';
+				}
+				if (m_depth > 0)
+				{
+					m_stream << '\n' << std::string(2 * m_depth, ' ');
+				}
+			}
+
+			inline void Open(char bracket)
+			{
+				Separate();
+				m_stream << bracket;
+				m_needComma = false;
+				m_depth++;
+			}
+
+			inline void Close(char bracket)
+			{
+				m_depth--;
+				m_stream << '\n' << std::string(2 * m_depth, ' ') << bracket;
+				m_needComma = true;
+				if (m_depth == 0)
+				{
+					m_stream << '\n';
+				}
+			}
+
+			void WriteString(const std::string& value)
+			{
+				m_stream << '"';
+				for (size_t i = 0; i < value.size(); i++)
+				{
+					char c = value[i];
+					if (c == '"' || c == '\\')
+					{
+						m_stream << '\\' << c;
+					}
+					else if (static_cast<unsigned char>(c) < 0x20)
+					{
+						char buffer[8];
+						std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+						m_stream << buffer;
+					}
+					else
+					{
+						m_stream << c;
+					}
+				}
+				m_stream << '"';
+			}
+
+		private:
+			std::ostream& m_stream;
+			bool          m_needComma;
+			bool          m_afterKey;     // A key was written, its value comes next
+			unsigned int  m_depth;
+		};
+
+
+		/// \brief Write the fields describing the machine and the run, inside an open object
+		/// \param[in] json. Writer
+		/// \param[in] suite. Name of the benchmark suite
+		inline void WriteContext(JsonWriter& json, const std::string& suite)
+		{
+			char date[32];
+			std::time_t now = std::time(NULL);
+			std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+			json.Key("suite").Value(suite);
+			json.Key("date").Value(date);
+			json.Key("simd_level").Value(GetSimdLevelName(GetSimdLevel()));
+#if defined(__VERSION__)
+			json.Key("compiler").Value(__VERSION__);
+#endif
+		}
+
+
+		/// \brief Write a measurement as a JSON object
+		/// \param[in] json. Writer
+		/// \param[in] measurement. Measurement
+		inline void WriteMeasurement(JsonWriter& json, const Measurement& measurement)
+		{
+			json.BeginObject();
+			json.Key("name").Value(measurement.name);
+			json.Key("calls").Value(measurement.calls);
+			json.Key("seconds").Value(measurement.seconds);
+			json.Key("items_per_call").Value(measurement.itemsPerCall);
+			json.Key("ns_per_item").Value(measurement.NanosecondsPerItem());
+			json.Key("items_per_second").Value(measurement.ItemsPerSecond());
+			json.EndObject();
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,205 @@
+// Per-component microbenchmarks: random number generation, trial generation, population
+// evaluation and elite bookkeeping. Results are written as JSON.
+//
+// Build: compile with every file of EC/src except DemoDE.cpp, e.g.
+//   g++ -std=c++11 -O2 -pthread EC/bench/MicroBenchmarks.cpp <EC/src sources> -o bench_micro
+// Usage: bench_micro [output.json]     (standard output by default)
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdint.h>
+#include <vector>
+#include "BenchmarkHarness.hpp"
+#include "../include/BenchmarkFunctions.hpp"
+#include "../include/ContiguousPopulation.hpp"
+#include "../include/CpuFeatures.hpp"
+#include "../include/DifferentialEvolution.hpp"
+#include "../include/RandomGenerator.hpp"
+#include "../include/SimdKernels.hpp"
+
+using namespace EC;
+
+
+namespace
+{
+	/// Gives the benchmarks access to the phases of a generation
+	class ExposedDifferentialEvolution : public DifferentialEvolution
+	{
+	public:
+		using DifferentialEvolution::Breed;
+		using DifferentialEvolution::SaveElite;
+
+		void EvaluatePopulation()
+		{
+			Evaluate(m_pPopulation);
+		}
+	};
+
+	// Results are accumulated here so the compiler cannot drop the benchmarked work
+	volatile double g_sink = 0;
+
+	std::string Name(const std::string& base, unsigned int dim)
+	{
+		std::ostringstream name;
+		name << base << "/dim:" << dim;
+		return name.str();
+	}
+
+	void RandomBenchmarks(std::vector<Bench::Measurement>& results)
+	{
+		const size_t count = 4096;
+		RandomGenerator randomGenerator(1);
+		std::vector<double> values(count);
+		std::vector<int> integers(count);
+		std::vector<uint64_t> mask(count / 64);
+
+		results.push_back(Bench::Measure("rng/next", [&]() {
+			uint64_t sum = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				sum += randomGenerator.Next();
+			}
+			g_sink = g_sink + static_cast<double>(sum & 1);
+		}, count));
+		results.push_back(Bench::Measure("rng/fill_uniform", [&]() {
+			randomGenerator.FillUniform(&values[0], count, -1, 1);
+			g_sink = g_sink + values[count - 1];
+		}, count));
+		results.push_back(Bench::Measure("rng/fill_normal", [&]() {
+			randomGenerator.FillNormal(&values[0], count, 0, 1);
+			g_sink = g_sink + values[count - 1];
+		}, count));
+		results.push_back(Bench::Measure("rng/fill_int", [&]() {
+			randomGenerator.FillInt(&integers[0], count, 0, 100);
+			g_sink = g_sink + integers[count - 1];
+		}, count));
+		results.push_back(Bench::Measure("rng/fill_bernoulli_mask", [&]() {
+			randomGenerator.FillBernoulliMask(&mask[0], count, 0.2);
+			g_sink = g_sink + static_cast<double>(mask[0] & 1);
+		}, count));
+	}
+
+	void TrialBenchmarks(std::vector<Bench::Measurement>& results, const std::vector<unsigned int>& dims)
+	{
+		const SimdLevel detected = DetectSimdLevel();
+		for (size_t d = 0; d < dims.size(); d++)
+		{
+			unsigned int dim = dims[d];
+			RandomGenerator randomGenerator(2);
+			std::vector<double> vectors(5 * dim);
+			randomGenerator.FillUniform(&vectors[0], vectors.size(), -1, 1);
+			std::vector<uint64_t> mask((dim + 63) / 64);
+			randomGenerator.FillBernoulliMask(&mask[0], dim, 0.5);
+			const double* pTarget = &vectors[0];
+			double* pTrial = &vectors[4 * dim];
+
+			for (int level = SIMD_NONE; level <= detected; level++)
+			{
+				SetMaxSimdLevel(static_cast<SimdLevel>(level));
+				std::string name = Name("trial", dim) + "/" + GetSimdLevelName(static_cast<SimdLevel>(level));
+				results.push_back(Bench::Measure(name, [&]() {
+					SimdKernels::DifferentialTrial(pTarget, pTarget + dim, pTarget + 2 * dim, pTarget + 3 * dim,
+						&mask[0], dim, 0.7, pTrial);
+					g_sink = g_sink + pTrial[0];
+				}, dim));
+			}
+			SetMaxSimdLevel(detected);
+		}
+	}
+
+	void EvaluationBenchmarks(std::vector<Bench::Measurement>& results, const std::vector<unsigned int>& dims)
+	{
+		const unsigned int populationSize = 256;
+		for (size_t d = 0; d < dims.size(); d++)
+		{
+			unsigned int dim = dims[d];
+			ContiguousPopulation<double, double> population(populationSize, dim);
+			RandomGenerator randomGenerator(3);
+			for (unsigned int i = 0; i < populationSize; i++)
+			{
+				randomGenerator.FillUniform(population.GetChromosome(i), dim, -5, 5);
+			}
+
+			SphereFunctor sphere(dim);
+			RastriginFunctor rastrigin(dim);
+			RosenbrockFunctor rosenbrock(dim);
+			BenchmarkFunctor* functions[] = { &sphere, &rastrigin, &rosenbrock };
+			const char* names[] = { "evaluate/sphere", "evaluate/rastrigin", "evaluate/rosenbrock" };
+			for (int f = 0; f < 3; f++)
+			{
+				BenchmarkFunctor* pFunc = functions[f];
+				results.push_back(Bench::Measure(Name(names[f], dim), [&]() {
+					pFunc->EvaluateBatch(population.GetChromosomeData(), populationSize, dim,
+						population.GetStride(), population.GetFitnessData());
+					g_sink = g_sink + population.GetFitnessData()[0];
+				}, populationSize));
+			}
+		}
+	}
+
+	void GenerationBenchmarks(std::vector<Bench::Measurement>& results, const std::vector<unsigned int>& dims)
+	{
+		const unsigned int populationSize = 100;
+		for (size_t d = 0; d < dims.size(); d++)
+		{
+			unsigned int dim = dims[d];
+			RastriginFunctor rastrigin(dim);
+			ExposedDifferentialEvolution de;
+			de.SetSeed(4);
+			de.SetNumThreads(1);
+			de.Initialize(populationSize, rastrigin.GetDomainLowerBound(), rastrigin.GetDomainUpperBound(), &rastrigin);
+			de.Start(false);
+
+			results.push_back(Bench::Measure(Name("evolver/evaluate_population", dim), [&]() {
+				de.EvaluatePopulation();
+			}, populationSize));
+			results.push_back(Bench::Measure(Name("evolver/breed", dim), [&]() {
+				de.Breed();
+			}, populationSize));
+			results.push_back(Bench::Measure(Name("evolver/save_elite", dim), [&]() {
+				de.SaveElite();
+			}, populationSize));
+			results.push_back(Bench::Measure(Name("evolver/step", dim), [&]() {
+				de.Step();
+			}, populationSize));
+		}
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	std::vector<unsigned int> dims;
+	dims.push_back(10);
+	dims.push_back(30);
+	dims.push_back(100);
+
+	std::vector<Bench::Measurement> results;
+	RandomBenchmarks(results);
+	TrialBenchmarks(results, dims);
+	EvaluationBenchmarks(results, dims);
+	GenerationBenchmarks(results, dims);
+
+	std::ofstream file;
+	if (argc > 1)
+	{
+		file.open(argv[1]);
+		if (!file)
+		{
+			std::cerr << "Can't open " << argv[1] << std::endl;
+			return 1;
+		}
+	}
+	Bench::JsonWriter json(argc > 1 ? static_cast<std::ostream&>(file) : std::cout);
+	json.BeginObject();
+	Bench::WriteContext(json, "micro");
+	json.Key("results").BeginArray();
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		Bench::WriteMeasurement(json, results[i]);
+	}
+	json.EndArray();
+	json.EndObject();
+	return 0;
+}
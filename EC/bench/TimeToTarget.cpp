@@ -0,0 +1,215 @@
+// End-to-end benchmark: evaluation throughput and time to reach a target fitness, for several
+// test functions, dimensions and population sizes. Results are written as JSON.
+// The dimension 10, population 50 runs are repeated with a KrigingSurrogate screening the
+// trials, to compare the evaluations needed to reach the target.
+//
+// Build: compile with every file of EC/src except DemoDE.cpp, e.g.
+//   g++ -std=c++11 -O2 -pthread EC/bench/TimeToTarget.cpp <EC/src sources> -o bench_target
+// Usage: bench_target [--output file.json] [--threads N] [--repeats N] [--max-generation N]
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "BenchmarkHarness.hpp"
+#include "../include/BenchmarkFunctions.hpp"
+#include "../include/DifferentialEvolution.hpp"
+#include "../include/Surrogate.hpp"
+
+using namespace EC;
+
+
+namespace
+{
+	/// One optimization run
+	struct Run
+	{
+		std::string        function;
+		unsigned int       dim;
+		unsigned int       populationSize;
+		unsigned long long seed;
+		bool               surrogate;          // Trials screened by a KrigingSurrogate
+		double             target;
+		bool               reached;
+		unsigned int       generations;
+		unsigned long long evaluations;
+		double             seconds;            // Until the target, or the whole run
+		double             bestFitness;
+		double             evaluationsPerSecond;
+		unsigned long long screenedOut;        // Trials rejected by the surrogate
+	};
+
+	/// Run DE until the elite reaches the target or maxGeneration is hit
+	Run TimeToTarget(
+		const std::string& name,
+		BenchmarkFunctor* pFunc,
+		unsigned int populationSize,
+		unsigned long long seed,
+		double target,
+		unsigned int numThreads,
+		unsigned int maxGeneration,
+		bool useSurrogate)
+	{
+		DifferentialEvolution de;
+		de.SetSeed(seed);
+		de.SetNumThreads(numThreads);
+		KrigingSurrogate surrogate;
+		if (useSurrogate)
+		{
+			de.SetSurrogate(&surrogate);
+		}
+
+		Bench::Stopwatch stopwatch;
+		de.Initialize(populationSize, pFunc->GetDomainLowerBound(), pFunc->GetDomainUpperBound(), pFunc);
+		de.Start(false);
+		// The elite exists after the first generation
+		do
+		{
+			de.Step();
+		} while (de.GetGeneration() < maxGeneration && de.GetElite()->GetFitness() > target);
+
+		Run run;
+		run.seconds = stopwatch.Seconds();
+		run.function = name;
+		run.dim = pFunc->GetProblemDim();
+		run.populationSize = populationSize;
+		run.seed = seed;
+		run.surrogate = useSurrogate;
+		run.target = target;
+		run.bestFitness = de.GetElite()->GetFitness();
+		run.reached = run.bestFitness <= target;
+		run.generations = de.GetGeneration();
+		run.evaluations = de.GetNumEvaluations();
+		run.evaluationsPerSecond = run.evaluations / run.seconds;
+		run.screenedOut = de.GetNumScreenedOut();
+		return run;
+	}
+
+	void WriteRun(Bench::JsonWriter& json, const Run& run)
+	{
+		json.BeginObject();
+		json.Key("function").Value(run.function);
+		json.Key("dim").Value(run.dim);
+		json.Key("population_size").Value(run.populationSize);
+		json.Key("seed").Value(run.seed);
+		json.Key("surrogate").Value(run.surrogate);
+		json.Key("target").Value(run.target);
+		json.Key("reached").Value(run.reached);
+		json.Key("generations").Value(run.generations);
+		json.Key("evaluations").Value(run.evaluations);
+		json.Key("seconds").Value(run.seconds);
+		json.Key("best_fitness").Value(run.bestFitness);
+		json.Key("evaluations_per_second").Value(run.evaluationsPerSecond);
+		json.Key("screened_out").Value(run.screenedOut);
+		json.EndObject();
+	}
+
+	bool ParseUnsigned(const char* text, unsigned int& value)
+	{
+		char* pEnd = NULL;
+		unsigned long parsed = std::strtoul(text, &pEnd, 10);
+		if (pEnd == text || *pEnd != '\0')
+		{
+			return false;
+		}
+		value = static_cast<unsigned int>(parsed);
+		return true;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	unsigned int numThreads = 1;
+	unsigned int repeats = 3;
+	unsigned int maxGeneration = 5000;
+	for (int i = 1; i < argc; i++)
+	{
+		bool valid = i + 1 < argc;
+		if (valid && std::strcmp(argv[i], "--output") == 0)
+		{
+			output = argv[++i];
+		}
+		else if (valid && std::strcmp(argv[i], "--threads") == 0)
+		{
+			valid = ParseUnsigned(argv[++i], numThreads);
+		}
+		else if (valid && std::strcmp(argv[i], "--repeats") == 0)
+		{
+			valid = ParseUnsigned(argv[++i], repeats);
+		}
+		else if (valid && std::strcmp(argv[i], "--max-generation") == 0)
+		{
+			valid = ParseUnsigned(argv[++i], maxGeneration);
+		}
+		else
+		{
+			valid = false;
+		}
+		if (!valid)
+		{
+			std::cerr << "Usage: " << argv[0]
+				<< " [--output file.json] [--threads N] [--repeats N] [--max-generation N]" << std::endl;
+			return 1;
+		}
+	}
+
+	unsigned int dims[] = { 10, 30 };
+	unsigned int populationSizes[] = { 50, 100 };
+	std::vector<Run> runs;
+	for (int d = 0; d < 2; d++)
+	{
+		SphereFunctor sphere(dims[d]);
+		RastriginFunctor rastrigin(dims[d]);
+		RosenbrockFunctor rosenbrock(dims[d]);
+		AckleyFunctor ackley(dims[d]);
+		BenchmarkFunctor* functions[] = { &sphere, &rastrigin, &rosenbrock, &ackley };
+		const char* names[] = { "sphere", "rastrigin", "rosenbrock", "ackley" };
+
+		for (int f = 0; f < 4; f++)
+		{
+			double target = functions[f]->GetOptimalFitness() + 1e-8;
+			for (int p = 0; p < 2; p++)
+			{
+				for (unsigned int r = 0; r < repeats; r++)
+				{
+					runs.push_back(TimeToTarget(names[f], functions[f], populationSizes[p], r + 1,
+						target, numThreads, maxGeneration, false));
+				}
+			}
+			// Same seeds as the runs without surrogate
+			for (unsigned int r = 0; d == 0 && r < repeats; r++)
+			{
+				runs.push_back(TimeToTarget(names[f], functions[f], populationSizes[0], r + 1,
+					target, numThreads, maxGeneration, true));
+			}
+		}
+	}
+
+	std::ofstream file;
+	if (!output.empty())
+	{
+		file.open(output.c_str());
+		if (!file)
+		{
+			std::cerr << "Can't open " << output << std::endl;
+			return 1;
+		}
+	}
+	Bench::JsonWriter json(output.empty() ? std::cout : static_cast<std::ostream&>(file));
+	json.BeginObject();
+	Bench::WriteContext(json, "time_to_target");
+	json.Key("threads").Value(numThreads);
+	json.Key("max_generation").Value(maxGeneration);
+	json.Key("runs").BeginArray();
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		WriteRun(json, runs[i]);
+	}
+	json.EndArray();
+	json.EndObject();
+	return 0;
+}
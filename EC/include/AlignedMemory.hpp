@@ -0,0 +1,56 @@
+#ifndef EC_AlignedMemory_Hpp
+#define EC_AlignedMemory_Hpp
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+
+namespace EC
+{
+	/// \brief Default alignment (in bytes) of the buffers shared with vectorized kernels.
+	///        64 bytes covers a cache line and a full AVX-512 register.
+	const std::size_t SimdAlignment = 64;
+
+	/// \brief Allocate a block of memory aligned to a given boundary.
+	/// \param[in] size. Size of the block in bytes
+	/// \param[in] alignment. Desired alignment, a power of two multiple of sizeof(void*)
+	/// \return A pointer to the block. Must be released by AlignedFree.
+	inline void* AlignedMalloc(std::size_t size, std::size_t alignment = SimdAlignment)
+	{
+		void* ptr = NULL;
+		if (size == 0)
+		{
+			size = alignment;
+		}
+#ifdef _WIN32
+		ptr = _aligned_malloc(size, alignment);
+#else
+		if (posix_memalign(&ptr, alignment, size) != 0)
+		{
+			ptr = NULL;
+		}
+#endif
+		if (ptr == NULL)
+		{
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+
+	/// \brief Release a block allocated by AlignedMalloc
+	/// \param[in] ptr. Pointer returned by AlignedMalloc. NULL is ignored.
+	inline void AlignedFree(void* ptr)
+	{
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+}
+
+#endif
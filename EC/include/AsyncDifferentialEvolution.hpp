@@ -0,0 +1,62 @@
+#ifndef EC_AsyncDifferentialEvolution_Hpp
+#define EC_AsyncDifferentialEvolution_Hpp
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "DifferentialEvolution.hpp"
+
+
+namespace EC
+{
+	/// \brief Asynchronous steady-state differential evolution.
+	///
+	/// \details  There is no generation barrier. Every thread repeatedly takes the index of
+	///           a target from a shared round-robin cursor, builds a rand/1/bin trial from
+	///           the current population, evaluates it and replaces the target at once if the
+	///           trial is better. A target being worked on is skipped, so only one thread at
+	///           a time replaces it, and every target gets its turn whichever threads are
+	///           running. Slow evaluations never hold up the other threads, so all cores stay
+	///           busy however uneven the per-candidate cost is. The trials are
+	///           always rand/1/bin: SetStrategy has no effect. Of the stop criteria, only the
+	///           evaluation budget, deadline and cancellation token apply; they are polled
+	///           before every trial.
+	///
+	///           A "generation" is counted as population-size trial evaluations: Evolve with
+	///           maxGeneration runs maxGeneration * populationSize trials in total. The thread
+	///           count is set with SetNumThreads; the fitness functor must be thread-safe.
+	class AsyncDifferentialEvolution : public DifferentialEvolution
+	{
+	public:
+		AsyncDifferentialEvolution();
+		virtual ~AsyncDifferentialEvolution();
+
+		using DifferentialEvolution::Evolve;
+
+		/// \brief Evolve. The main loop, run by all threads without synchronization points
+		/// \param[in] maxGeneration. Budget, in units of population-size trial evaluations
+		/// \param[in] verbose. If true, show details after evolving
+		virtual void Evolve(unsigned int maxGeneration=100, bool verbose=false);
+
+		/// \brief Get how many trials a target received in the last run. Targets are served
+		///        in turn, so the counts differ by about the number of threads at most.
+		/// \param[in] target. Index of the individual
+		/// \return Number of trials
+		unsigned int GetNumTrials(unsigned int target) const;
+
+	protected:
+		/// \brief Loop of one worker thread
+		/// \param[in] threadIndex. Index of the thread in the pool
+		void WorkerLoop(unsigned int threadIndex);
+
+	private:
+		std::mutex*            m_pRowLocks;        // One lock per individual
+		std::atomic<bool>*     m_pIsTargetBusy;    // One flag per individual: a thread is on it
+		unsigned int           m_numRowLocks;
+		std::atomic<unsigned long long> m_nextTarget;  // Round-robin cursor over the targets
+		std::atomic<long long> m_remainingTrials;  // Budget left
+		std::vector<unsigned int> m_numTrials;     // Per target, written by the thread owning it
+	};
+}
+
+#endif
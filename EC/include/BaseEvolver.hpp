@@ -1,12 +1,22 @@
 #ifndef EC_BaseEvolver_Hpp
 #define EC_BaseEvolver_Hpp
 
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include <random>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
 #include "BasePopulation.hpp"
+#include "ContiguousPopulation.hpp"
 #include "BaseFitnessFunctor.hpp"
+#include "ThreadPool.hpp"
+#include "RandomGenerator.hpp"
+#include "StatisticsStream.hpp"
+#include "StopCriteria.hpp"
 
 namespace EC
 {
@@ -61,23 +71,182 @@ namespace EC
 			unsigned int maxGeneration=100,
 			bool verbose=false);
 		
-		/// \brief Set the population that will be evolved.
+		/// \brief Evaluate the initial population. Evolve calls it before the first
+		///        generation; call it once before driving the evolver with Step.
+		/// \param[in] verbose. If true and no statistics stream is set, the statistics of
+		///            every generation are written to std::cout as CSV
+		virtual void Start(bool verbose=false);
+
+		/// \brief Counterpart of Start for a population that is already evaluated, e.g.
+		///        restored by DifferentialEvolution::LoadCheckpoint: restarts the clock, the
+		///        stop criteria and the statistics without evaluating anything. Then drive the
+		///        evolver with ShouldStop and Step. Time limits count from Resume; generation
+		///        and evaluation counts go on from the restored ones.
+		/// \param[in] maxGeneration. Max generation allowed. 0 keeps the current one, e.g.
+		///            the one saved in the checkpoint.
+		/// \param[in] verbose. As Start
+		virtual void Resume(unsigned int maxGeneration=0, bool verbose=false);
+
+		/// \brief Run one generation: breed, select and save the elite.
+		virtual void Step();
+
+		/// \brief Check the evolver's own stop criterion (CheckStopCriteria), then the ones
+		///        set with GetStopCriteria. Evolve calls it before every generation; call it
+		///        between Steps when driving the evolver by hand.
+		/// \return True if the run should stop. GetStopReason tells why.
+		bool ShouldStop();
+
+		/// \brief Get the stop criteria checked by ShouldStop, to configure them
+		/// \return The stop criteria
+		inline StopCriteria& GetStopCriteria()
+		{
+			return m_stopCriteria;
+		}
+
+		/// \brief Get why the run stopped
+		/// \return Reason found by the last ShouldStop, STOP_NONE while running
+		inline StopReason GetStopReason() const
+		{
+			return m_stopReason;
+		}
+
+		/// \brief Get the number of generations done so far
+		/// \return Generation counter
+		inline unsigned int GetGeneration() const
+		{
+			return m_generation;
+		}
+
+		/// \brief Set the max generation of a run driven with Start, ShouldStop and Step.
+		///        Evolve sets it from its argument. It is also the horizon of schedules such
+		///        as the L-SHADE population reduction.
+		/// \param[in] maxGeneration. Max generation allowed. default 100
+		inline void SetMaxGeneration(unsigned int maxGeneration)
+		{
+			m_maxGeneration = maxGeneration;
+		}
+
+		/// \brief Set the population that will be evolved. Evolvers that allocate their own
+		///        population in Initialize take ownership of it, see theirs.
 		/// \param[in] pop. A pointer to an existing population
-		void SetPopulation(BasePopulation<ChromoType, FitnessType>* pop);
+		virtual void SetPopulation(BasePopulation<ChromoType, FitnessType>* pop);
 
 		/// \brief Get a pointer to the population that will be evolved.
 		/// \return The pointer to the population stored in the BaseEvolver
 		BasePopulation<ChromoType, FitnessType>* GetPopulation();
 
+		/// \brief Publish the statistics of every generation to a stream. Computing them
+		///        costs one pass over the population per generation.
+		/// \param[in] pStream. Stream, not owned. NULL disables the statistics.
+		inline void SetStatisticsStream(StatisticsStream* pStream)
+		{
+			m_pStatisticsStream = pStream;
+		}
+
+		/// \brief Set the number of threads used to evaluate a population.
+		///        WARNING: with more than one thread the fitness functor is called
+		///        concurrently and must be thread-safe.
+		/// \param[in] numThreads. 1 evaluates serially (default), 0 uses all cores
+		void SetNumThreads(unsigned int numThreads);
+
+		/// \brief Get the number of threads used to evaluate a population.
+		/// \return Number of threads. 0 means all cores.
+		inline unsigned int GetNumThreads() const
+		{
+			return m_numThreads;
+		}
+
+		/// \brief Set how many individuals a thread evaluates at a time.
+		/// \param[in] chunkSize. 0 chooses automatically (default)
+		inline void SetChunkSize(unsigned int chunkSize)
+		{
+			m_chunkSize = chunkSize;
+		}
+
+		/// \brief Get the number of fitness evaluations done so far
+		/// \return Number of evaluations
+		inline unsigned long long GetNumEvaluations() const
+		{
+			return m_numEvaluations;
+		}
+
+		/// \brief Get the number of evaluations stopped early by a bounded fitness functor,
+		///        i.e. the full evaluations avoided. They are included in GetNumEvaluations.
+		/// \return Number of aborted evaluations
+		inline unsigned long long GetNumAbortedEvaluations() const
+		{
+			return m_numAbortedEvaluations;
+		}
+
+		/// \brief Get the throughput achieved when evaluating populations
+		/// \return Evaluations per second of wall-clock time spent in Evaluate(BasePopulation*)
+		double GetEvaluationsPerSecond() const;
+
+		/// \brief Seed all random number generators of the evolver. Runs with the same seed
+		///        and settings are bit-reproducible. By default the seed comes from
+		///        std::random_device.
+		/// \param[in] seed. Seed
+		void SetSeed(unsigned long long seed);
+
+		/// \brief Get the seed of the random number generators
+		/// \return Seed
+		inline unsigned long long GetSeed() const
+		{
+			return m_seed;
+		}
+
 	protected:
 		/// \brief Evaluate an individual
 		/// \param[in,out] An individual. Fitness will be stored in the input individual
 		virtual void Evaluate(BaseIndividual<ChromoType, FitnessType>* pIndiv);
 
-		/// \brief Evaluate a population
+		/// \brief Evaluate a population, in parallel if more than one thread is set.
+		///        A ContiguousPopulation is handed to the functor's EvaluateBatch in blocks.
 		/// \param[in,out] A population. Fitness will be stored in each individual
 		virtual void Evaluate(BasePopulation<ChromoType, FitnessType>* pPopulation);
 
+		/// \brief Evaluate a population whose individuals are only kept if they beat a bound,
+		///        e.g. trials against their parents. If the fitness functor supports bounded
+		///        evaluation, the losers may be aborted early and get the worst possible fitness.
+		/// \param[in,out] pPopulation. A population
+		/// \param[in] pBounds. Acceptance threshold of each individual. NULL evaluates fully.
+		void Evaluate(BasePopulation<ChromoType, FitnessType>* pPopulation, const FitnessType* pBounds);
+
+		/// \brief Evaluate some individuals of a contiguous population, in parallel if more
+		///        than one thread is set. Interrupted like Evaluate(BasePopulation*).
+		/// \param[in,out] pPopulation. A contiguous population
+		/// \param[in] pRows. Indexes of the individuals to evaluate
+		/// \param[in] numRows. Number of indexes
+		/// \param[in] pBounds. Acceptance threshold of each individual, indexed by row. NULL
+		///            evaluates fully.
+		void Evaluate(ContiguousPopulation<ChromoType, FitnessType>* pPopulation,
+			const unsigned int* pRows, unsigned int numRows, const FitnessType* pBounds = NULL);
+
+		/// \brief Evaluate a block of rows of a contiguous population
+		/// \param[in,out] pPopulation. A contiguous population
+		/// \param[in] begin. First individual of the block
+		/// \param[in] end. One past the last individual of the block
+		/// \param[in] pBounds. Acceptance threshold of each individual, indexed by row. NULL
+		///            evaluates fully.
+		void EvaluateBatch(ContiguousPopulation<ChromoType, FitnessType>* pPopulation,
+			unsigned int begin, unsigned int end, const FitnessType* pBounds = NULL);
+
+		/// \brief Evaluate a block of individuals of a population, unless the stop criteria
+		///        interrupt the run: the block then gets the worst possible fitness, so that
+		///        selection discards it.
+		/// \param[in,out] pPopulation. A population
+		/// \param[in] begin. First individual of the block
+		/// \param[in] end. One past the last individual of the block
+		/// \param[in] pBounds. Acceptance threshold of each individual, indexed by row. NULL
+		///            evaluates fully.
+		void EvaluateRange(BasePopulation<ChromoType, FitnessType>* pPopulation,
+			unsigned int begin, unsigned int end, const FitnessType* pBounds = NULL);
+
+		/// \brief Fill the population statistics of a record: best, mean and std of the
+		///        fitness, and diversity
+		/// \param[in,out] record. Statistics of the current generation
+		virtual void ComputeStatistics(GenerationStatistics& record);
+
 		/// \brief Select the better ones from the current population.
 		virtual void Select() = 0;
 
@@ -102,6 +271,34 @@ namespace EC
 		/// \return      Random number
 		double RandNorm(const double mean, const double std);
 
+		/// \brief Get the generator behind RandUniform and RandNorm, for bulk draws
+		/// \return The main generator of the evolver
+		inline RandomGenerator& GetRandomGenerator()
+		{
+			return m_randomGenerator;
+		}
+
+		/// \brief Create a generator on an independent stream of the evolver's seed, e.g.
+		///        one per individual. The same id always gives the same sequence.
+		/// \param[in] streamId. Id of the stream
+		/// \return A new generator
+		inline RandomGenerator CreateRandomStream(unsigned long long streamId) const
+		{
+			return RandomGenerator(m_seed, streamId + 1);
+		}
+
+		/// \brief Get the generator owned by a thread of the thread pool
+		/// \param[in] threadIndex. Index passed to the loop body by ThreadPool::ParallelFor
+		/// \return The generator of that thread
+		inline RandomGenerator& GetThreadRandomGenerator(unsigned int threadIndex)
+		{
+			return m_threadRandomGenerators[threadIndex];
+		}
+
+		/// \brief Get the thread pool, created on first use with one generator per thread
+		/// \return The thread pool
+		ThreadPool* GetThreadPool();
+
 	protected:		
 		BasePopulation<ChromoType, FitnessType>* m_pPopulation;	
 		BasePopulation<ChromoType, FitnessType>* m_pOffsprings;	
@@ -116,11 +313,42 @@ namespace EC
 
 		bool m_verbose;
 
+		// Parallel evaluation
+		ThreadPool*   m_pThreadPool;
+		unsigned int  m_numThreads;
+		unsigned int  m_chunkSize;
+		const FitnessType*  m_pEvaluationBounds;  // Of the parallel Evaluate in progress
+		const unsigned int* m_pEvaluationRows;    // Of the parallel Evaluate in progress
+
+		// Evaluation statistics
+		std::atomic<unsigned long long> m_numEvaluations;
+		std::atomic<unsigned long long> m_numAbortedEvaluations;
+		unsigned long long m_numPopulationEvaluations;  // Evaluations done by Evaluate(BasePopulation*)
+		double        m_populationEvaluationTime;      // Seconds spent in Evaluate(BasePopulation*)
+
+		// Per-generation statistics
+		StatisticsStream* m_pStatisticsStream;
+		StatisticsStream* m_pConsoleStatistics;        // Owned, used when verbose
+		CsvStatisticsSink* m_pConsoleSink;
+		std::chrono::steady_clock::time_point m_startTime;
+		std::vector<double> m_centroid;
+		GenerationStatistics m_lastStatistics;         // Of the last generation, for the stop criteria
+
+		// Stop criteria
+		StopCriteria  m_stopCriteria;
+		StopReason    m_stopReason;
+
 	private:
-		// Random number generator
-		std::random_device          m_randDevice;
-		std::default_random_engine  m_RandNumberGenerator; 	
-	
+		/// \brief Bookkeeping of Start and Resume
+		/// \param[in] verbose. If true, write the statistics to std::cout
+		/// \param[in] evaluate. If true, evaluate the population first
+		void BeginRun(bool verbose, bool evaluate);
+
+		// Random number generators
+		unsigned long long            m_seed;
+		RandomGenerator               m_randomGenerator;
+		std::vector<RandomGenerator>  m_threadRandomGenerators;
+
 	};
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -128,15 +356,24 @@ namespace EC
 	///////////////////////////////////////////////////////////////////////////////////////////////////
 	template<typename ChromoType, typename FitnessType>
 	BaseEvolver<ChromoType, FitnessType>::BaseEvolver()
-		:m_pPopulation(NULL), m_generation(0), m_maxGeneration(100), m_pFitnessFunc(NULL), m_verbose(false)
+		:m_pPopulation(NULL), m_pOffsprings(NULL), m_generation(0), m_maxGeneration(100),
+		m_pFitnessFunc(NULL), m_verbose(false), m_pThreadPool(NULL), m_numThreads(1), m_chunkSize(0),
+		m_pEvaluationBounds(NULL), m_pEvaluationRows(NULL), m_numEvaluations(0), m_numAbortedEvaluations(0), m_numPopulationEvaluations(0), m_populationEvaluationTime(0.0),
+		m_pStatisticsStream(NULL), m_pConsoleStatistics(NULL), m_pConsoleSink(NULL), m_lastStatistics(),
+		m_stopReason(STOP_NONE)
 	{
-		m_RandNumberGenerator = std::default_random_engine(m_randDevice()); 
+		std::random_device randDevice;
+		SetSeed((static_cast<unsigned long long>(randDevice()) << 32) ^ randDevice());
 	}
 
 
 	template<typename ChromoType, typename FitnessType>
 	BaseEvolver<ChromoType, FitnessType>::~BaseEvolver()
-	{}
+	{
+		delete m_pConsoleStatistics;
+		delete m_pConsoleSink;
+		delete m_pThreadPool;
+	}
 
 
 	template<typename ChromoType, typename FitnessType>
@@ -153,19 +390,72 @@ namespace EC
 	}	
 
 
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::SetNumThreads(unsigned int numThreads)
+	{
+		if (numThreads != m_numThreads)
+		{
+			// The pool is created again on the next parallel evaluation
+			delete m_pThreadPool;
+			m_pThreadPool = NULL;
+			m_numThreads = numThreads;
+		}
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	double BaseEvolver<ChromoType, FitnessType>::GetEvaluationsPerSecond() const
+	{
+		if (m_populationEvaluationTime <= 0.0)
+		{
+			return 0.0;
+		}
+		return m_numPopulationEvaluations / m_populationEvaluationTime;
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::SetSeed(unsigned long long seed)
+	{
+		// Stream 0 is the main generator, thread streams are counted down from the top
+		// so that they never meet the streams of CreateRandomStream.
+		m_seed = seed;
+		m_randomGenerator.Seed(seed, 0);
+		for (unsigned int t = 0; t < m_threadRandomGenerators.size(); t++)
+		{
+			m_threadRandomGenerators[t].Seed(seed, ~static_cast<unsigned long long>(t));
+		}
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	ThreadPool* BaseEvolver<ChromoType, FitnessType>::GetThreadPool()
+	{
+		if (m_pThreadPool == NULL)
+		{
+			m_pThreadPool = new ThreadPool(m_numThreads);
+			unsigned int numThreads = m_pThreadPool->GetNumThreads();
+			m_threadRandomGenerators.resize(numThreads);
+			for (unsigned int t = 0; t < numThreads; t++)
+			{
+				m_threadRandomGenerators[t].Seed(m_seed, ~static_cast<unsigned long long>(t));
+			}
+		}
+		return m_pThreadPool;
+	}
+
+
 	template<typename ChromoType, typename FitnessType>
 	double BaseEvolver<ChromoType, FitnessType>::RandUniform(const double min, const double max)
 	{
-		std::uniform_real_distribution<double> distribution(min, max);
-		return distribution(m_RandNumberGenerator);
+		return m_randomGenerator.Uniform(min, max);
 	}
 
 
 	template<typename ChromoType, typename FitnessType>
 	double BaseEvolver<ChromoType, FitnessType>::RandNorm(const double mean, const double std)
 	{
-		std::normal_distribution<double> distribution(mean, std);
-		return distribution(m_RandNumberGenerator);	
+		return m_randomGenerator.Normal(mean, std);
 	}
 
 
@@ -210,40 +500,383 @@ namespace EC
 		}
 		double fitness = (*m_pFitnessFunc)(pIndiv);
 		pIndiv->SetFitness(fitness);
+		m_numEvaluations++;
 	}
 
 	template<typename ChromoType, typename FitnessType>
 	void BaseEvolver<ChromoType, FitnessType>::
 	Evaluate(BasePopulation<ChromoType, FitnessType>* pPopulation)
 	{
+		Evaluate(pPopulation, static_cast<const FitnessType*>(NULL));
+	}
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::
+	Evaluate(BasePopulation<ChromoType, FitnessType>* pPopulation, const FitnessType* pBounds)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		unsigned long long numEvaluations = m_numEvaluations;
+
 		unsigned int popSize = pPopulation->Size();
-		for (unsigned int i = 0; i < popSize; i++)
+		if (m_numThreads == 1)
+		{
+			// Interruptible criteria are polled every few individuals
+			unsigned int blockSize = popSize;
+			if (m_stopCriteria.IsInterruptible())
+			{
+				blockSize = m_chunkSize > 0 ? m_chunkSize : 8;
+			}
+			for (unsigned int begin = 0; begin < popSize; begin += blockSize)
+			{
+				EvaluateRange(pPopulation, begin, std::min(begin + blockSize, popSize), pBounds);
+			}
+		}
+		else
 		{
-			Evaluate((*pPopulation)[i]);
+			// Two captures fit in std::function's local buffer: no allocation per call.
+			// The bounds are passed through a member for the same reason.
+			m_pEvaluationBounds = pBounds;
+			GetThreadPool()->ParallelFor(popSize, m_chunkSize,
+				[this, pPopulation](unsigned int begin, unsigned int end, unsigned int)
+				{
+					EvaluateRange(pPopulation, begin, end, m_pEvaluationBounds);
+				});
+			m_pEvaluationBounds = NULL;
 		}
+
+		m_numPopulationEvaluations += m_numEvaluations - numEvaluations;
+		m_populationEvaluationTime += std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::Evaluate(
+		ContiguousPopulation<ChromoType, FitnessType>* pPopulation,
+		const unsigned int* pRows,
+		unsigned int numRows,
+		const FitnessType* pBounds)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		unsigned long long numEvaluations = m_numEvaluations;
+
+		if (m_numThreads == 1)
+		{
+			for (unsigned int r = 0; r < numRows; r++)
+			{
+				EvaluateRange(pPopulation, pRows[r], pRows[r] + 1, pBounds);
+			}
+		}
+		else
+		{
+			// As above: rows and bounds go through members, the lambda keeps two captures
+			m_pEvaluationRows = pRows;
+			m_pEvaluationBounds = pBounds;
+			GetThreadPool()->ParallelFor(numRows, m_chunkSize,
+				[this, pPopulation](unsigned int begin, unsigned int end, unsigned int)
+				{
+					for (unsigned int r = begin; r < end; r++)
+					{
+						EvaluateRange(pPopulation, m_pEvaluationRows[r], m_pEvaluationRows[r] + 1, m_pEvaluationBounds);
+					}
+				});
+			m_pEvaluationRows = NULL;
+			m_pEvaluationBounds = NULL;
+		}
+
+		m_numPopulationEvaluations += m_numEvaluations - numEvaluations;
+		m_populationEvaluationTime += std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::EvaluateRange(
+		BasePopulation<ChromoType, FitnessType>* pPopulation,
+		unsigned int begin,
+		unsigned int end,
+		const FitnessType* pBounds)
+	{
+		FitnessType worst = std::numeric_limits<FitnessType>::has_infinity ?
+			std::numeric_limits<FitnessType>::infinity() : std::numeric_limits<FitnessType>::max();
+		if (m_stopCriteria.IsInterruptible() && m_stopCriteria.Poll(m_numEvaluations))
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				(*pPopulation)[i]->SetFitness(worst);
+			}
+			return;
+		}
+
+		ContiguousPopulation<ChromoType, FitnessType>* pContiguous =
+			dynamic_cast<ContiguousPopulation<ChromoType, FitnessType>*>(pPopulation);
+		if (pContiguous != NULL)
+		{
+			EvaluateBatch(pContiguous, begin, end, pBounds);
+			return;
+		}
+		if (pBounds == NULL || m_pFitnessFunc == NULL || !m_pFitnessFunc->SupportsBoundedEvaluation())
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				Evaluate((*pPopulation)[i]);
+			}
+			return;
+		}
+		for (unsigned int i = begin; i < end; i++)
+		{
+			bool isAborted = false;
+			double fitness = m_pFitnessFunc->EvaluateBounded((*pPopulation)[i], pBounds[i], isAborted);
+			(*pPopulation)[i]->SetFitness(isAborted ? worst : fitness);
+			m_numEvaluations++;
+			if (isAborted)
+			{
+				m_numAbortedEvaluations++;
+			}
+		}
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::EvaluateBatch(
+		ContiguousPopulation<ChromoType, FitnessType>* pPopulation,
+		unsigned int begin,
+		unsigned int end,
+		const FitnessType* pBounds)
+	{
+		if (m_pFitnessFunc == NULL)
+		{
+			throw std::invalid_argument("Invalid fitness function");
+		}
+		if (begin >= end)
+		{
+			return;
+		}
+		if (pBounds != NULL && m_pFitnessFunc->SupportsBoundedEvaluation())
+		{
+			m_numAbortedEvaluations += m_pFitnessFunc->EvaluateBatchBounded(
+				pPopulation->GetChromosome(begin),
+				end - begin,
+				pPopulation->GetChromosomeLength(),
+				pPopulation->GetStride(),
+				pBounds + begin,
+				pPopulation->GetFitnessData() + begin);
+			m_numEvaluations += end - begin;
+			return;
+		}
+		m_pFitnessFunc->EvaluateBatch(
+			pPopulation->GetChromosome(begin),
+			end - begin,
+			pPopulation->GetChromosomeLength(),
+			pPopulation->GetStride(),
+			pPopulation->GetFitnessData() + begin);
+		m_numEvaluations += end - begin;
 	}
 
 	template<typename ChromoType, typename FitnessType>
 	void BaseEvolver<ChromoType, FitnessType>::Evolve(unsigned int maxGeneration, bool verbose)
 	{
-		m_verbose = verbose;
 		m_maxGeneration = maxGeneration;
-		Evaluate(m_pPopulation);
-		while(CheckStopCriteria() == false)
+		Start(verbose);
+		while(ShouldStop() == false)
+		{
+			Step();
+		}
+		if (m_pStatisticsStream != NULL)
 		{
-			if (verbose)
+			m_pStatisticsStream->Flush();
+		}
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::Start(bool verbose)
+	{
+		BeginRun(verbose, true);
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::Resume(unsigned int maxGeneration, bool verbose)
+	{
+		if (m_pPopulation == NULL)
+		{
+			throw std::runtime_error("Empty population. Nothing to resume");
+		}
+		if (maxGeneration > 0)
+		{
+			m_maxGeneration = maxGeneration;
+		}
+		BeginRun(verbose, false);
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::BeginRun(bool verbose, bool evaluate)
+	{
+		m_verbose = verbose;
+		if (m_verbose && m_pStatisticsStream == NULL)
+		{
+			if (m_pConsoleStatistics == NULL)
 			{
-				std::cout << "Generation: " << m_generation << std::endl;
+				m_pConsoleSink = new CsvStatisticsSink(std::cout);
+				m_pConsoleStatistics = new StatisticsStream();
+				m_pConsoleStatistics->AddSink(m_pConsoleSink);
 			}
+			m_pStatisticsStream = m_pConsoleStatistics;
+		}
+		else if (!m_verbose && m_pStatisticsStream == m_pConsoleStatistics)
+		{
+			m_pStatisticsStream = NULL;
+		}
+		m_startTime = std::chrono::steady_clock::now();
+		m_stopReason = STOP_NONE;
+		m_stopCriteria.Start(m_startTime);
+		if (evaluate)
+		{
+			Evaluate(m_pPopulation);
+		}
+
+		// The initial population can already meet a criterion
+		GenerationStatistics& record = m_lastStatistics;
+		record = GenerationStatistics();
+		record.generation = m_generation;
+		record.numEvaluations = m_numEvaluations;
+		if (m_stopCriteria.NeedsStatistics())
+		{
+			ComputeStatistics(record);
+		}
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	bool BaseEvolver<ChromoType, FitnessType>::ShouldStop()
+	{
+		// An interrupted generation has already latched its reason
+		StopReason reason = m_stopCriteria.GetReason();
+		if (reason == STOP_NONE && CheckStopCriteria())
+		{
+			reason = STOP_MAX_GENERATION;
+		}
+		if (reason == STOP_NONE)
+		{
+			reason = m_stopCriteria.Check(m_lastStatistics);
+		}
+		m_stopReason = reason;
+		return reason != STOP_NONE;
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::Step()
+	{
+		typedef std::chrono::steady_clock Clock;
+		Clock::time_point breedTime = Clock::now();
+		double evaluationTime = m_populationEvaluationTime;
 
-			Breed();     // Generate offsprings
+		Breed();     // Generate offsprings
 
-			Select();    // Select better ones
+		Clock::time_point selectTime = Clock::now();
 
-			SaveElite(); // Save the best one
+		Select();    // Select better ones
 
-			m_generation++;
+		Clock::time_point saveEliteTime = Clock::now();
+
+		SaveElite(); // Save the best one
+
+		m_generation++;
+
+		// Kept for the stop criteria
+		Clock::time_point endTime = Clock::now();
+		GenerationStatistics& record = m_lastStatistics;
+		record.generation = m_generation;
+		record.numEvaluations = m_numEvaluations;
+		record.breedSeconds = std::chrono::duration<double>(selectTime - breedTime).count();
+		record.evaluationSeconds = m_populationEvaluationTime - evaluationTime;
+		record.selectSeconds = std::chrono::duration<double>(saveEliteTime - selectTime).count();
+		record.saveEliteSeconds = std::chrono::duration<double>(endTime - saveEliteTime).count();
+		record.elapsedSeconds = std::chrono::duration<double>(endTime - m_startTime).count();
+		if (m_pStatisticsStream != NULL || m_stopCriteria.NeedsStatistics())
+		{
+			ComputeStatistics(record);
+		}
+		if (m_pStatisticsStream != NULL)
+		{
+			m_pStatisticsStream->Publish(record);
+		}
+	}
+
+
+	template<typename ChromoType, typename FitnessType>
+	void BaseEvolver<ChromoType, FitnessType>::ComputeStatistics(GenerationStatistics& record)
+	{
+		unsigned int popSize = m_pPopulation != NULL ? m_pPopulation->Size() : 0;
+		if (popSize == 0)
+		{
+			record.bestFitness = record.meanFitness = record.stdFitness = record.diversity = 0;
+			return;
+		}
+
+		// Fitness: smaller, better
+		double best = static_cast<double>((*m_pPopulation)[0]->GetFitness());
+		double sum = 0;
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			double fitness = static_cast<double>((*m_pPopulation)[i]->GetFitness());
+			best = fitness < best ? fitness : best;
+			sum += fitness;
+		}
+		double mean = sum / popSize;
+		double sumSquares = 0;
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			double deviation = static_cast<double>((*m_pPopulation)[i]->GetFitness()) - mean;
+			sumSquares += deviation * deviation;
+		}
+		record.bestFitness = best;
+		record.meanFitness = mean;
+		record.stdFitness = std::sqrt(sumSquares / popSize);
+
+		// Diversity: mean Euclidean distance to the centroid
+		ContiguousPopulation<ChromoType, FitnessType>* pContiguous =
+			dynamic_cast<ContiguousPopulation<ChromoType, FitnessType>*>(m_pPopulation);
+		unsigned int length = (*m_pPopulation)[0]->Size();
+		m_centroid.assign(length, 0);
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			if (pContiguous != NULL)
+			{
+				const ChromoType* pGenes = pContiguous->GetChromosome(i);
+				for (unsigned int k = 0; k < length; k++)
+				{
+					m_centroid[k] += static_cast<double>(pGenes[k]);
+				}
+			}
+			else
+			{
+				for (unsigned int k = 0; k < length; k++)
+				{
+					m_centroid[k] += static_cast<double>((*(*m_pPopulation)[i])[k]);
+				}
+			}
+		}
+		for (unsigned int k = 0; k < length; k++)
+		{
+			m_centroid[k] /= popSize;
+		}
+		double sumDistances = 0;
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			double squaredDistance = 0;
+			for (unsigned int k = 0; k < length; k++)
+			{
+				double gene = pContiguous != NULL ? static_cast<double>(pContiguous->GetChromosome(i)[k])
+					: static_cast<double>((*(*m_pPopulation)[i])[k]);
+				double deviation = gene - m_centroid[k];
+				squaredDistance += deviation * deviation;
+			}
+			sumDistances += std::sqrt(squaredDistance);
 		}
+		record.diversity = sumDistances / popSize;
 	}
 
 
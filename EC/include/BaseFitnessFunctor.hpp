@@ -2,6 +2,8 @@
 #define EC_BaseFitnessFunctor_Hpp
 
 #include "BaseIndividual.hpp"
+#include "IndividualView.hpp"
+#include <limits>
 #include <vector>
 
 
@@ -20,6 +22,92 @@ namespace EC
 		/// \brief Calculate fitness of an individual. For single-objective optimization only.
 		/// \param[in] pIndiv. An individual that will be evaluated
 		virtual double operator() (BaseIndividual<ChromoType, FitnessType>* pIndiv) = 0;
+
+		/// \brief Calculate fitness of a block of individuals stored row by row in contiguous
+		///        memory. The default implementation calls operator() on each row through an
+		///        IndividualView; override it to vectorize cheap objectives.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[out] pFitness. Fitness of each individual
+		virtual void EvaluateBatch(
+			const ChromoType* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			FitnessType* pFitness)
+		{
+			for (unsigned int i = 0; i < numIndiv; i++)
+			{
+				// The view never writes the genes unless operator() does
+				ChromoType* pGenes = const_cast<ChromoType*>(pChromosomes) + static_cast<size_t>(i) * stride;
+				IndividualView<ChromoType, FitnessType> indiv(pGenes, pFitness + i, length);
+				pFitness[i] = (*this)(&indiv);
+			}
+		}
+
+		/// \brief Check whether the functor implements EvaluateBounded. Evolvers only pass
+		///        acceptance thresholds to functors that do.
+		virtual bool SupportsBoundedEvaluation() const
+		{
+			return false;
+		}
+
+		/// \brief Calculate fitness of an individual that is only useful if it is smaller than
+		///        a bound, e.g. a trial that must beat its parent. Objectives accumulated term by
+		///        term (sums over data points, time steps...) can stop as soon as the partial
+		///        result exceeds the bound. The default implementation calls operator().
+		/// \param[in] pIndiv. An individual that will be evaluated
+		/// \param[in] bound. Acceptance threshold: the individual is discarded unless its
+		///            fitness is smaller
+		/// \param[out] isAborted. Set to true if the evaluation stopped early
+		/// \return The fitness, or any value if aborted
+		virtual double EvaluateBounded(BaseIndividual<ChromoType, FitnessType>* pIndiv, double /*bound*/, bool& isAborted)
+		{
+			isAborted = false;
+			return (*this)(pIndiv);
+		}
+
+		/// \brief Bounded version of EvaluateBatch. The default implementation calls
+		///        EvaluateBounded on each row through an IndividualView.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[in] pBounds. Acceptance threshold of each individual
+		/// \param[out] pFitness. Fitness of each individual. Aborted ones get the worst
+		///             possible fitness.
+		/// \return Number of aborted evaluations
+		virtual unsigned int EvaluateBatchBounded(
+			const ChromoType* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			const FitnessType* pBounds,
+			FitnessType* pFitness)
+		{
+			FitnessType worst = std::numeric_limits<FitnessType>::has_infinity ?
+				std::numeric_limits<FitnessType>::infinity() : std::numeric_limits<FitnessType>::max();
+			unsigned int numAborted = 0;
+			for (unsigned int i = 0; i < numIndiv; i++)
+			{
+				ChromoType* pGenes = const_cast<ChromoType*>(pChromosomes) + static_cast<size_t>(i) * stride;
+				IndividualView<ChromoType, FitnessType> indiv(pGenes, pFitness + i, length);
+				bool isAborted = false;
+				double fitness = EvaluateBounded(&indiv, pBounds[i], isAborted);
+				if (isAborted)
+				{
+					pFitness[i] = worst;
+					numAborted++;
+				}
+				else
+				{
+					pFitness[i] = fitness;
+				}
+			}
+			return numAborted;
+		}
 	};
 }
 #endif
@@ -8,17 +8,49 @@
 
 namespace EC
 {
-	/// \brief Sphere functor
-	class SphereFunctor : public BaseFitnessFunctor <double, double>
+	/// \brief Base class of the test functions. A test function has a configurable dimension,
+	///        a box domain and a known global minimum.
+	///
+	///        Subclasses implement Evaluate on a raw chromosome. operator() and the default
+	///        EvaluateBatch are built on it; cheap functions override EvaluateBatch with
+	///        vectorized kernels.
+	class BenchmarkFunctor : public BaseFitnessFunctor<double, double>
 	{
 	public:
-		SphereFunctor();
-		virtual ~SphereFunctor();
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension
+		/// \param[in] lowerBound. Domain lower bound, the same for every dimension
+		/// \param[in] upperBound. Domain upper bound, the same for every dimension
+		BenchmarkFunctor(unsigned int problemDim, double lowerBound, double upperBound);
+		virtual ~BenchmarkFunctor();
 
 		/// \brief Calculate fitness of an individual. For single-objective optimization only.
 		/// \param[in] pIndiv. Individual that is to be evaluated
 		virtual double operator() (BaseIndividual<double, double>* pIndiv);
 
+		/// \brief Calculate fitness of a block of contiguous individuals, row by row.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[out] pFitness. Fitness of each individual
+		virtual void EvaluateBatch(
+			const double* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			double* pFitness);
+
+		/// \brief Calculate fitness of one chromosome of GetProblemDim() genes
+		/// \param[in] x. First gene
+		/// \return Fitness
+		virtual double Evaluate(const double* x) const = 0;
+
+		/// \brief Change the domain. The optimum must stay inside.
+		/// \param[in] lowerBound. Domain lower bound, the same for every dimension
+		/// \param[in] upperBound. Domain upper bound, the same for every dimension
+		void SetDomain(double lowerBound, double upperBound);
+
 		/// \brief Get the domain lower bound
 		/// \return the domain lower bound
 		inline std::vector<double>& GetDomainLowerBound()
@@ -33,14 +65,205 @@ namespace EC
 			return m_upperBound;
 		}
 
-	protected:		
+		/// \brief Get the problem dimension
+		/// \return Number of genes
+		inline unsigned int GetProblemDim() const
+		{
+			return m_problemDim;
+		}
+
+		/// \brief Get the location of the global minimum
+		/// \return The optimal chromosome
+		inline const std::vector<double>& GetOptimum() const
+		{
+			return m_optimum;
+		}
+
+		/// \brief Get the value of the global minimum
+		/// \return The optimal fitness
+		inline double GetOptimalFitness() const
+		{
+			return m_optimalFitness;
+		}
+
+	protected:
+		/// \brief Throw if a chromosome length is not the problem dimension
+		/// \param[in] length. Chromosome length
+		void CheckLength(unsigned int length) const;
+
+	protected:
 		std::vector<double> m_lowerBound;
 		std::vector<double> m_upperBound;
+		std::vector<double> m_optimum;
+		double m_optimalFitness;
 		unsigned int m_problemDim;
 	};
 
+
+	/// \brief Sphere function: sum x_i^2. Minimum 0 at the origin. Domain [-5.12, 5.12].
+	class SphereFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor. 10 dimensions.
+		SphereFunctor();
+
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension
+		SphereFunctor(unsigned int problemDim);
+		virtual ~SphereFunctor();
+
+		virtual double Evaluate(const double* x) const;
+
+		/// \brief Calculate fitness of a block of contiguous individuals. Vectorized.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[out] pFitness. Fitness of each individual
+		virtual void EvaluateBatch(
+			const double* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			double* pFitness);
+	};
+
+
+	/// \brief Rastrigin function: 10 n + sum (x_i^2 - 10 cos(2 pi x_i)). Highly multimodal.
+	///        Minimum 0 at the origin. Domain [-5.12, 5.12].
+	class RastriginFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension
+		RastriginFunctor(unsigned int problemDim = 10);
+		virtual ~RastriginFunctor();
+
+		virtual double Evaluate(const double* x) const;
+	};
+
+
+	/// \brief Rosenbrock function: sum 100 (x_{i+1} - x_i^2)^2 + (1 - x_i)^2. A narrow curved
+	///        valley. Minimum 0 at (1, ..., 1). Domain [-2.048, 2.048].
+	class RosenbrockFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension, at least 2
+		RosenbrockFunctor(unsigned int problemDim = 10);
+		virtual ~RosenbrockFunctor();
+
+		virtual double Evaluate(const double* x) const;
+
+		/// \brief Calculate fitness of a block of contiguous individuals. Vectorized.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[out] pFitness. Fitness of each individual
+		virtual void EvaluateBatch(
+			const double* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			double* pFitness);
+	};
+
+
+	/// \brief Ackley function: -20 exp(-0.2 sqrt(mean x_i^2)) - exp(mean cos(2 pi x_i)) + 20 + e.
+	///        Minimum 0 at the origin. Domain [-32.768, 32.768].
+	class AckleyFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension
+		AckleyFunctor(unsigned int problemDim = 10);
+		virtual ~AckleyFunctor();
+
+		virtual double Evaluate(const double* x) const;
+	};
+
+
+	/// \brief Griewank function: 1 + sum x_i^2 / 4000 - prod cos(x_i / sqrt(i + 1)).
+	///        Minimum 0 at the origin. Domain [-600, 600].
+	class GriewankFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension
+		GriewankFunctor(unsigned int problemDim = 10);
+		virtual ~GriewankFunctor();
+
+		virtual double Evaluate(const double* x) const;
+	};
+
+
+	/// \brief Schwefel function 2.26: 418.9829 n - sum x_i sin(sqrt(|x_i|)). Deceptive: the
+	///        second best minimum is far from the best one. Minimum 0 at (420.9687, ..., 420.9687).
+	///        Domain [-500, 500].
+	class SchwefelFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] problemDim. Problem dimension
+		SchwefelFunctor(unsigned int problemDim = 10);
+		virtual ~SchwefelFunctor();
+
+		virtual double Evaluate(const double* x) const;
+	};
+
+
+	/// \brief Shifted and rotated variant of a test function: f(M (x - o) + z*) where z* is the
+	///        optimum of the base function, o a random shift and M a random orthogonal matrix.
+	///        The optimum moves to o, rotation makes the function non-separable.
+	///
+	///        The shift is drawn in the central 80% of the domain. The base function is not
+	///        owned and must outlive the wrapper. The optimum holds for base functions whose
+	///        minimum is global over the whole space, i.e. all of the above except Schwefel,
+	///        which has better values outside its domain.
+	class ShiftedRotatedFunctor : public BenchmarkFunctor
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] pBase. Base test function
+		/// \param[in] seed. Seed of the shift and of the rotation
+		/// \param[in] rotate. False for a shift only
+		ShiftedRotatedFunctor(BenchmarkFunctor* pBase, unsigned long long seed, bool rotate = true);
+		virtual ~ShiftedRotatedFunctor();
+
+		virtual double Evaluate(const double* x) const;
+
+		/// \brief Transform a block of individuals, then evaluate them with the base function's
+		///        EvaluateBatch.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[out] pFitness. Fitness of each individual
+		virtual void EvaluateBatch(
+			const double* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			double* pFitness);
+
+		/// \brief Get the rotation matrix, row-major
+		/// \return Rotation matrix, identity if not rotated
+		inline const std::vector<double>& GetRotation() const
+		{
+			return m_rotation;
+		}
+
+	private:
+		/// \brief z = M (x - o) + z*
+		void Transform(const double* x, double* z) const;
+
+	private:
+		BenchmarkFunctor*   m_pBase;
+		std::vector<double> m_shift;
+		std::vector<double> m_rotation;
+	};
 }
 
 
 #endif
-
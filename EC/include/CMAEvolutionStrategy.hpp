@@ -0,0 +1,167 @@
+#ifndef EC_CMAEvolutionStrategy_Hpp
+#define EC_CMAEvolutionStrategy_Hpp
+
+#include <vector>
+#include "BaseEvolver.hpp"
+#include "BaseFitnessFunctor.hpp"
+#include "ContiguousPopulation.hpp"
+#include "RealCodedIndividual.hpp"
+
+
+namespace EC
+{
+	/// \brief Covariance matrix adaptation evolution strategy, (mu/mu_w, lambda)-CMA-ES.
+	///
+	///  Hansen, N. and Ostermeier, A. "Completely Derandomized Self-Adaptation in Evolution
+	///  Strategies." Evolutionary Computation 9(2), 159-195, 2001.
+	///  Ros, R. and Hansen, N. "A Simple Modification in CMA-ES Achieving Linear Time and
+	///  Space Complexity." PPSN X, 296-305, 2008.
+	///
+	///  The search distribution lives in the unit box of the domain, so that every variable
+	///  starts with the same relative step size. The initial population is uniform in the
+	///  domain, like DifferentialEvolution's; the mean starts at its best individual. Every
+	///  generation samples the offsprings into a contiguous buffer in one pass, evaluates
+	///  them, and updates the mean, the evolution paths, the covariance matrix and the step
+	///  size from the best half. Samples outside the domain are mirrored back into it.
+	///
+	///  The eigendecomposition of the covariance matrix, needed to sample, is recomputed with
+	///  cyclic Jacobi rotations, only once the covariance has moved enough: every
+	///  lambda / ((c1 + cmu) n 10) evaluations, which amortizes it to O(n^2) per sample. The
+	///  rotations start from the previous eigenbasis, where the matrix is nearly diagonal.
+	///  The separable mode (SetSeparable) keeps a diagonal covariance with larger learning
+	///  rates: O(n) time and memory per sample, for high dimensions.
+	///
+	///  Besides the maximum generation, a run stops when the step size has collapsed, the
+	///  covariance matrix became numerically singular, a step no longer moves a coordinate
+	///  of the mean, or the best fitness has stalled over the last 10 + 30 n / lambda
+	///  generations: the run has converged, e.g. to restart it (RestartPortfolio).
+	class CMAEvolutionStrategy : public BaseEvolver<double, double>
+	{
+	public:
+		CMAEvolutionStrategy();
+		virtual ~CMAEvolutionStrategy();
+
+		/// \brief Get the best individual
+		/// \return the best individual
+		BaseIndividual<double, double>* GetElite();
+
+		/// \brief Use a diagonal covariance matrix (sep-CMA-ES). Takes effect at Initialize.
+		/// \param[in] isSeparable. True for the diagonal mode, false for the full matrix (default)
+		void SetSeparable(bool isSeparable);
+
+		inline bool IsSeparable() const
+		{
+			return m_isSeparable;
+		}
+
+		/// \brief Set the initial step size. Takes effect at Initialize.
+		/// \param[in] stepSize. Standard deviation, relative to the width of the domain. default 0.3
+		void SetInitialStepSize(double stepSize);
+
+		/// \brief Get the current step size
+		/// \return Sigma, relative to the width of the domain
+		inline double GetStepSize() const
+		{
+			return m_stepSize;
+		}
+
+		/// \brief Get the condition number of the covariance matrix, as of its last decomposition
+		/// \return Ratio of the largest to the smallest eigenvalue
+		double GetConditionNumber() const;
+
+		/// \brief Get the number of eigendecompositions done in the run
+		/// \return Number of decompositions
+		inline unsigned int GetNumDecompositions() const
+		{
+			return m_numDecompositions;
+		}
+
+		/// \brief Create the population and the distribution. Overridden.
+		///	       WARNING: MUST BE CALLED BY OVERRIDDEN FUNCTION.
+		/// \param[in] populationSize. Offsprings per generation, lambda. 0 chooses the
+		///            default 4 + 3 ln(n).
+		/// \param[in] lowerBound. Domain lower bound.
+		/// \param[in] upperBound. Domain upper bound.
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation.
+		virtual void Initialize(
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc
+			);
+
+		/// \brief Eigendecomposition of a symmetric matrix by cyclic Jacobi rotations
+		/// \param[in] n. Order of the matrix
+		/// \param[in,out] pMatrix. Row-major n x n matrix, destroyed
+		/// \param[in,out] pEigenvectors. Row-major n x n orthogonal matrix: on input, a basis
+		///                where the matrix is expected to be nearly diagonal (e.g. the
+		///                identity); on output, the eigenvectors as columns
+		/// \param[out] pEigenvalues. n eigenvalues, in the order of the eigenvectors
+		/// \return Number of sweeps done
+		static unsigned int JacobiEigen(unsigned int n, double* pMatrix, double* pEigenvectors, double* pEigenvalues);
+
+	protected:
+		/// \brief Rank the offsprings, update the distribution, and make the offsprings
+		///        the population: (mu, lambda) selection.
+		virtual void Select();
+
+		/// \brief Sample the offsprings from the distribution and evaluate them.
+		virtual void Breed();
+
+		/// \brief Check the maximum generation and the state of the distribution.
+		virtual bool CheckStopCriteria();
+
+		/// \brief Save elite
+		virtual void SaveElite();
+
+		/// \brief Set the strategy parameters for the dimension and population size
+		/// \param[in] dimension. Number of variables
+		/// \param[in] populationSize. Offsprings per generation
+		void SetStrategyParameters(unsigned int dimension, unsigned int populationSize);
+
+		/// \brief Recompute the eigendecomposition of the covariance matrix
+		void UpdateEigenSystem();
+
+	protected:
+		RealCodedIndividual* m_pElite;
+		bool                 m_isSeparable;
+		double               m_initialStepSize;
+
+		// Domain, x = lower + width * y
+		std::vector<double>  m_width;
+
+		// Strategy parameters
+		unsigned int         m_numParents;       // mu
+		std::vector<double>  m_weights;          // Recombination weights, summing to 1
+		double               m_effectiveMu;      // mu_eff
+		double               m_cumulationC;      // cc
+		double               m_cumulationSigma;  // cs
+		double               m_rankOneRate;      // c1
+		double               m_rankMuRate;       // cmu
+		double               m_damping;          // damps
+		double               m_expectedNorm;     // E||N(0, I)||
+
+		// Distribution, in the unit box
+		bool                 m_isMeanSet;        // False until the first generation
+		unsigned int         m_numUpdates;       // Generations since Initialize
+		std::vector<double>  m_bestHistory;      // Best fitness of the last generations, circular
+		std::vector<double>  m_mean;
+		double               m_stepSize;         // sigma
+		std::vector<double>  m_pathC;            // pc
+		std::vector<double>  m_pathSigma;        // ps
+		std::vector<double>  m_covariance;       // n x n, or its diagonal when separable
+		std::vector<double>  m_eigenvectors;     // B, n x n; unused when separable
+		std::vector<double>  m_axisLengths;      // D, square roots of the eigenvalues
+		unsigned long long   m_evaluationsAtDecomposition;
+		unsigned int         m_numDecompositions;
+
+		// Work buffers, allocated at Initialize
+		std::vector<double>        m_normals;    // lambda x n standard normal draws
+		std::vector<double>        m_steps;      // mu x n selected steps (x - m) / sigma
+		std::vector<double>        m_work;       // 2 n x n when the matrix is full
+		std::vector<double>        m_vector;     // n
+		std::vector<unsigned int>  m_rankOrder;
+	};
+}
+
+#endif
@@ -0,0 +1,437 @@
+#ifndef EC_CachedFitnessFunctor_Hpp
+#define EC_CachedFitnessFunctor_Hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+#include "BaseFitnessFunctor.hpp"
+
+
+namespace EC
+{
+	/// \brief Fitness functor that memoizes another functor. Duplicate chromosomes cost a hash
+	///        lookup instead of an evaluation, which pays off for expensive objectives.
+	///
+	/// \details  The cache is a bounded, two-way set-associative table split into shards, each
+	///           protected by its own mutex, so it can be shared by the evaluation threads of an
+	///           evolver. Chromosomes are keyed on their bytes, or on their genes rounded to a
+	///           multiple of the quantization step. The key is stored and compared in full, so
+	///           a hash collision never returns a wrong fitness. The wrapped functor is called
+	///           outside the locks. Storage is allocated on the first insertion; afterwards
+	///           the batch path does not allocate.
+	template<typename ChromoType, typename FitnessType>
+	class CachedFitnessFunctor : public BaseFitnessFunctor<ChromoType, FitnessType>
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] pFitnessFunc. Functor to memoize. Not owned.
+		/// \param[in] capacity. Maximum number of cached chromosomes
+		/// \param[in] quantization. Genes closer than this step share a cache entry. 0 keys
+		///            on the exact bytes. Floating-point genes only.
+		CachedFitnessFunctor(
+			BaseFitnessFunctor<ChromoType, FitnessType>* pFitnessFunc,
+			unsigned int capacity,
+			double quantization = 0);
+		virtual ~CachedFitnessFunctor();
+
+		/// \brief Calculate fitness of an individual, or fetch it from the cache
+		/// \param[in] pIndiv. An individual that will be evaluated
+		virtual double operator() (BaseIndividual<ChromoType, FitnessType>* pIndiv);
+
+		/// \brief Calculate fitness of a block of individuals. Misses are handed to the wrapped
+		///        functor's EvaluateBatch in runs of consecutive rows.
+		/// \param[in] pChromosomes. First gene of the first individual
+		/// \param[in] numIndiv. Number of individuals
+		/// \param[in] length. Length of every chromosome
+		/// \param[in] stride. Distance, in genes, between two consecutive rows
+		/// \param[out] pFitness. Fitness of each individual
+		virtual void EvaluateBatch(
+			const ChromoType* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			FitnessType* pFitness);
+
+		/// \brief Forget every cached chromosome and reset the counters
+		void Clear();
+
+		/// \brief Get the number of lookups answered by the cache
+		/// \return Number of hits
+		inline unsigned long long GetNumHits() const
+		{
+			return m_numHits.load();
+		}
+
+		/// \brief Get the number of lookups forwarded to the wrapped functor
+		/// \return Number of misses
+		inline unsigned long long GetNumMisses() const
+		{
+			return m_numMisses.load();
+		}
+
+		/// \brief Get the fraction of lookups answered by the cache
+		/// \return Hit rate in [0, 1], 0 before the first lookup
+		inline double GetHitRate() const
+		{
+			double hits = static_cast<double>(m_numHits.load());
+			double total = hits + static_cast<double>(m_numMisses.load());
+			return total > 0 ? hits / total : 0;
+		}
+
+		/// \brief Get the maximum number of cached chromosomes
+		/// \return Capacity
+		inline unsigned int GetCapacity() const
+		{
+			return m_numShards * m_slotsPerShard;
+		}
+
+	private:
+		CachedFitnessFunctor(const CachedFitnessFunctor&);
+		CachedFitnessFunctor& operator =(const CachedFitnessFunctor&);
+
+		/// Genes of an individual, read through its virtual subscript
+		struct IndividualGenes
+		{
+			BaseIndividual<ChromoType, FitnessType>* pIndiv;
+			inline ChromoType operator[](unsigned int index) const
+			{
+				return (*pIndiv)[index];
+			}
+		};
+
+		/// Two-way set-associative table. Way 0 of a set holds the most recent entry.
+		struct Shard
+		{
+			std::mutex                 mutex;
+			std::vector<uint64_t>      hashes;   // 0 marks an empty slot
+			std::vector<FitnessType>   fitness;
+			std::vector<unsigned char> keys;     // keyBytes per slot
+			unsigned int               keyBytes;
+		};
+
+		/// Bytes of the key of one gene
+		inline unsigned int GeneKeyBytes() const
+		{
+			return m_quantization > 0 ? sizeof(double) : sizeof(ChromoType);
+		}
+
+		/// Write the key of one gene
+		inline void EncodeGene(const ChromoType& gene, unsigned char* pKey) const
+		{
+			if (m_quantization > 0)
+			{
+				double step = Quantize(gene, std::is_floating_point<ChromoType>());
+				std::memcpy(pKey, &step, sizeof(double));
+			}
+			else
+			{
+				std::memcpy(pKey, &gene, sizeof(ChromoType));
+			}
+		}
+
+		inline double Quantize(const ChromoType& gene, std::true_type) const
+		{
+			return std::floor(static_cast<double>(gene) / m_quantization + 0.5);
+		}
+
+		inline double Quantize(const ChromoType&, std::false_type) const
+		{
+			return 0;
+		}
+
+		template<typename Genes>
+		uint64_t Hash(const Genes& genes, unsigned int length) const;
+
+		template<typename Genes>
+		bool Matches(const Genes& genes, unsigned int length, const unsigned char* pKey) const;
+
+		template<typename Genes>
+		bool Lookup(const Genes& genes, unsigned int length, uint64_t hash, FitnessType& fitness);
+
+		template<typename Genes>
+		void Insert(const Genes& genes, unsigned int length, uint64_t hash, FitnessType fitness);
+
+		inline Shard& GetShard(uint64_t hash)
+		{
+			return m_shards[(hash >> 48) % m_numShards];
+		}
+
+	private:
+		BaseFitnessFunctor<ChromoType, FitnessType>* m_pFitnessFunc;
+		double       m_quantization;
+		unsigned int m_numShards;
+		unsigned int m_slotsPerShard;   // Always even: sets of two ways
+		std::vector<Shard> m_shards;
+
+		std::atomic<unsigned long long> m_numHits;
+		std::atomic<unsigned long long> m_numMisses;
+	};
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename ChromoType, typename FitnessType>
+EC::CachedFitnessFunctor<ChromoType, FitnessType>::CachedFitnessFunctor(
+	BaseFitnessFunctor<ChromoType, FitnessType>* pFitnessFunc,
+	unsigned int capacity,
+	double quantization)
+	: m_pFitnessFunc(pFitnessFunc), m_quantization(quantization), m_numShards(16), m_slotsPerShard(2),
+	m_numHits(0), m_numMisses(0)
+{
+	if (pFitnessFunc == NULL)
+	{
+		throw std::invalid_argument("received NULL fitness functor");
+	}
+	if (capacity == 0)
+	{
+		throw std::invalid_argument("received non-positive capacity");
+	}
+	if (!(quantization >= 0))
+	{
+		throw std::invalid_argument("received negative quantization");
+	}
+	if (quantization > 0 && !std::is_floating_point<ChromoType>::value)
+	{
+		throw std::invalid_argument("Quantization needs floating-point genes");
+	}
+
+	// Small caches use fewer shards rather than fewer ways
+	while (m_numShards > 1 && capacity < m_numShards * 2)
+	{
+		m_numShards /= 2;
+	}
+	m_slotsPerShard = (capacity + m_numShards - 1) / m_numShards;
+	m_slotsPerShard += m_slotsPerShard % 2;
+	m_shards = std::vector<Shard>(m_numShards);
+	for (unsigned int s = 0; s < m_numShards; s++)
+	{
+		m_shards[s].keyBytes = 0;
+	}
+}
+
+
+template<typename ChromoType, typename FitnessType>
+EC::CachedFitnessFunctor<ChromoType, FitnessType>::~CachedFitnessFunctor()
+{ }
+
+
+template<typename ChromoType, typename FitnessType>
+double EC::CachedFitnessFunctor<ChromoType, FitnessType>::operator() (
+	BaseIndividual<ChromoType, FitnessType>* pIndiv)
+{
+	IndividualGenes genes = { pIndiv };
+	unsigned int length = pIndiv->Size();
+	uint64_t hash = Hash(genes, length);
+
+	FitnessType fitness;
+	if (Lookup(genes, length, hash, fitness))
+	{
+		m_numHits++;
+		return fitness;
+	}
+	m_numMisses++;
+	fitness = (*m_pFitnessFunc)(pIndiv);
+	Insert(genes, length, hash, fitness);
+	return fitness;
+}
+
+
+template<typename ChromoType, typename FitnessType>
+void EC::CachedFitnessFunctor<ChromoType, FitnessType>::EvaluateBatch(
+	const ChromoType* pChromosomes,
+	unsigned int numIndiv,
+	unsigned int length,
+	unsigned int stride,
+	FitnessType* pFitness)
+{
+	unsigned int i = 0;
+	while (i < numIndiv)
+	{
+		const ChromoType* pRow = pChromosomes + static_cast<size_t>(i) * stride;
+		if (Lookup(pRow, length, Hash(pRow, length), pFitness[i]))
+		{
+			m_numHits++;
+			i++;
+			continue;
+		}
+
+		// Gather the run of consecutive misses starting at row i
+		unsigned int end = i + 1;
+		while (end < numIndiv)
+		{
+			const ChromoType* pNext = pChromosomes + static_cast<size_t>(end) * stride;
+			if (Lookup(pNext, length, Hash(pNext, length), pFitness[end]))
+			{
+				break;
+			}
+			end++;
+		}
+		m_numMisses += end - i;
+		m_pFitnessFunc->EvaluateBatch(pRow, end - i, length, stride, pFitness + i);
+		for (unsigned int k = i; k < end; k++)
+		{
+			const ChromoType* pMiss = pChromosomes + static_cast<size_t>(k) * stride;
+			Insert(pMiss, length, Hash(pMiss, length), pFitness[k]);
+		}
+		i = end;
+	}
+}
+
+
+template<typename ChromoType, typename FitnessType>
+void EC::CachedFitnessFunctor<ChromoType, FitnessType>::Clear()
+{
+	for (unsigned int s = 0; s < m_numShards; s++)
+	{
+		std::lock_guard<std::mutex> lock(m_shards[s].mutex);
+		std::fill(m_shards[s].hashes.begin(), m_shards[s].hashes.end(), 0);
+	}
+	m_numHits = 0;
+	m_numMisses = 0;
+}
+
+
+template<typename ChromoType, typename FitnessType>
+template<typename Genes>
+uint64_t EC::CachedFitnessFunctor<ChromoType, FitnessType>::Hash(
+	const Genes& genes,
+	unsigned int length) const
+{
+	const unsigned int geneKeyBytes = GeneKeyBytes();
+	unsigned char key[sizeof(ChromoType) > sizeof(double) ? sizeof(ChromoType) : sizeof(double)];
+	uint64_t hash = 0x9E3779B97F4A7C15ULL ^ length;
+	for (unsigned int i = 0; i < length; i++)
+	{
+		EncodeGene(genes[i], key);
+		for (unsigned int b = 0; b < geneKeyBytes; b += 8)
+		{
+			uint64_t word = 0;
+			std::memcpy(&word, key + b, geneKeyBytes - b < 8 ? geneKeyBytes - b : 8);
+			hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+			hash ^= hash >> 31;
+		}
+	}
+
+	// SplitMix64 finalizer; 0 is reserved for empty slots
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9ULL;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBULL;
+	hash ^= hash >> 31;
+	return hash == 0 ? 1 : hash;
+}
+
+
+template<typename ChromoType, typename FitnessType>
+template<typename Genes>
+bool EC::CachedFitnessFunctor<ChromoType, FitnessType>::Matches(
+	const Genes& genes,
+	unsigned int length,
+	const unsigned char* pKey) const
+{
+	const unsigned int geneKeyBytes = GeneKeyBytes();
+	unsigned char key[sizeof(ChromoType) > sizeof(double) ? sizeof(ChromoType) : sizeof(double)];
+	for (unsigned int i = 0; i < length; i++)
+	{
+		EncodeGene(genes[i], key);
+		if (std::memcmp(key, pKey + static_cast<size_t>(i) * geneKeyBytes, geneKeyBytes) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+template<typename ChromoType, typename FitnessType>
+template<typename Genes>
+bool EC::CachedFitnessFunctor<ChromoType, FitnessType>::Lookup(
+	const Genes& genes,
+	unsigned int length,
+	uint64_t hash,
+	FitnessType& fitness)
+{
+	Shard& shard = GetShard(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	if (shard.keyBytes != length * GeneKeyBytes())
+	{
+		return false;
+	}
+
+	size_t set = (hash % (m_slotsPerShard / 2)) * 2;
+	for (size_t way = 0; way < 2; way++)
+	{
+		size_t slot = set + way;
+		if (shard.hashes[slot] != hash || !Matches(genes, length, &shard.keys[slot * shard.keyBytes]))
+		{
+			continue;
+		}
+		fitness = shard.fitness[slot];
+		if (way == 1)
+		{
+			// Move the hit to the most recent way
+			std::swap(shard.hashes[set], shard.hashes[set + 1]);
+			std::swap(shard.fitness[set], shard.fitness[set + 1]);
+			std::swap_ranges(
+				shard.keys.begin() + set * shard.keyBytes,
+				shard.keys.begin() + (set + 1) * shard.keyBytes,
+				shard.keys.begin() + (set + 1) * shard.keyBytes);
+		}
+		return true;
+	}
+	return false;
+}
+
+
+template<typename ChromoType, typename FitnessType>
+template<typename Genes>
+void EC::CachedFitnessFunctor<ChromoType, FitnessType>::Insert(
+	const Genes& genes,
+	unsigned int length,
+	uint64_t hash,
+	FitnessType fitness)
+{
+	Shard& shard = GetShard(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	unsigned int keyBytes = length * GeneKeyBytes();
+	if (shard.keyBytes != keyBytes)
+	{
+		// First insertion, or the chromosome length changed: start over
+		shard.keyBytes = keyBytes;
+		shard.hashes.assign(m_slotsPerShard, 0);
+		shard.fitness.assign(m_slotsPerShard, FitnessType());
+		shard.keys.assign(static_cast<size_t>(m_slotsPerShard) * keyBytes, 0);
+	}
+
+	size_t set = (hash % (m_slotsPerShard / 2)) * 2;
+	for (size_t way = 0; way < 2; way++)
+	{
+		// Another thread may have inserted the same chromosome meanwhile
+		if (shard.hashes[set + way] == hash && Matches(genes, length, &shard.keys[(set + way) * keyBytes]))
+		{
+			return;
+		}
+	}
+
+	// Evict the least recent way
+	shard.hashes[set + 1] = shard.hashes[set];
+	shard.fitness[set + 1] = shard.fitness[set];
+	std::memmove(&shard.keys[(set + 1) * keyBytes], &shard.keys[set * keyBytes], keyBytes);
+
+	shard.hashes[set] = hash;
+	shard.fitness[set] = fitness;
+	for (unsigned int i = 0; i < length; i++)
+	{
+		EncodeGene(genes[i], &shard.keys[set * keyBytes + static_cast<size_t>(i) * GeneKeyBytes()]);
+	}
+}
+
+#endif
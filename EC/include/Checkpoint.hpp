@@ -0,0 +1,236 @@
+#ifndef EC_Checkpoint_Hpp
+#define EC_Checkpoint_Hpp
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RandomGenerator.hpp"
+
+
+namespace EC
+{
+	/// \brief Complete state of a differential evolution run, as saved in a checkpoint
+	struct CheckpointState
+	{
+		CheckpointState();
+
+		unsigned int       populationSize;
+		unsigned int       chromosomeLength;
+		unsigned int       stride;             // Distance between two rows of genes
+		unsigned int       generation;
+		unsigned int       maxGeneration;      // Of the interrupted run
+		unsigned long long seed;
+		unsigned long long numEvaluations;
+		uint64_t           randomState[RandomGenerator::StateSize];
+		double             diffWeight;
+		double             crossoverProb;
+		bool               hasElite;
+		double             eliteFitness;
+
+		// Adaptive strategies of DifferentialEvolution: DEStrategy, AdaptiveParameters and
+		// the adaptation state. The vectors are empty for rand/1/bin.
+		unsigned int       strategy;
+		double             pBestRate;
+		double             archiveRate;
+		unsigned int       memorySize;
+		double             learningRate;
+		double             initialDiffWeight;
+		double             initialCrossoverProb;
+		unsigned int       minPopulationSize;
+		unsigned int       memoryIndex;
+		unsigned int       initialPopulationSize;
+		unsigned int       archiveCapacity;    // Rows of the external archive
+
+		std::vector<double> lowerBound;        // chromosomeLength values
+		std::vector<double> upperBound;        // chromosomeLength values
+		std::vector<double> eliteChromosome;   // chromosomeLength values if hasElite
+		std::vector<double> fitness;           // populationSize values
+		std::vector<double> genes;             // populationSize rows of stride values
+		std::vector<double> memoryDiffWeight;     // Means of F
+		std::vector<double> memoryCrossoverProb;  // Means of CR, as many as memoryDiffWeight
+		std::vector<double> externalArchive;      // Rows in use, chromosomeLength values each
+	};
+
+
+	/// \brief Fixed-size header at the start of a checkpoint file.
+	///
+	/// \details  File layout, native byte order. Every section starts on a 64-byte boundary
+	///           so that a mapped file can be read in place:
+	///             header | lower bound | upper bound | elite | fitness | genes |
+	///             memory of F | memory of CR | external archive
+	///           The checksum covers the whole file, computed with the checksum field zeroed.
+	struct CheckpointHeader
+	{
+		char     magic[8];                 // "ECDECKPT"
+		uint32_t version;
+		uint32_t byteOrder;                // 0x01020304 as written by the saving machine
+		uint32_t populationSize;
+		uint32_t chromosomeLength;
+		uint32_t stride;
+		uint32_t generation;
+		uint64_t seed;
+		uint64_t numEvaluations;
+		uint64_t randomState[RandomGenerator::StateSize];
+		double   diffWeight;
+		double   crossoverProb;
+		double   eliteFitness;
+		uint32_t hasElite;
+		uint32_t maxGeneration;
+		uint32_t strategy;
+		uint32_t memorySize;
+		uint32_t minPopulationSize;
+		uint32_t numMemories;              // Entries of the memories of F and CR
+		uint32_t memoryIndex;
+		uint32_t initialPopulationSize;
+		uint32_t archiveCapacity;
+		uint32_t archiveSize;              // Rows of the external archive in use
+		double   pBestRate;
+		double   archiveRate;
+		double   learningRate;
+		double   initialDiffWeight;
+		double   initialCrossoverProb;
+		uint64_t payloadSize;              // Bytes after the header
+		uint64_t checksum;
+	};
+
+
+	/// \brief Write a checkpoint file. The file is written under a temporary name, flushed to
+	///        disk and renamed, so an existing checkpoint is replaced atomically and a crash
+	///        never leaves a truncated file behind.
+	/// \param[in] path. Destination file
+	/// \param[in] state. State to save
+	void WriteCheckpoint(const std::string& path, const CheckpointState& state);
+
+
+	/// \brief Read-only view of a checkpoint file, memory-mapped where the OS allows it. The
+	///        header is validated (magic, version, byte order, sizes, checksum) on opening,
+	///        then the sections can be copied straight into a population buffer.
+	class MappedCheckpoint
+	{
+	public:
+		/// \brief Map and validate a checkpoint. Throws std::runtime_error if the file can't
+		///        be read or isn't a valid checkpoint of this version.
+		/// \param[in] path. Checkpoint file
+		explicit MappedCheckpoint(const std::string& path);
+		~MappedCheckpoint();
+
+		inline const CheckpointHeader& GetHeader() const
+		{
+			return *reinterpret_cast<const CheckpointHeader*>(m_pData);
+		}
+
+		inline const double* GetLowerBound() const
+		{
+			return Section(0);
+		}
+
+		inline const double* GetUpperBound() const
+		{
+			return Section(1);
+		}
+
+		/// \return The elite chromosome, valid if the header's hasElite is set
+		inline const double* GetEliteChromosome() const
+		{
+			return Section(2);
+		}
+
+		inline const double* GetFitness() const
+		{
+			return Section(3);
+		}
+
+		/// \return populationSize rows of the header's stride
+		inline const double* GetGenes() const
+		{
+			return Section(4);
+		}
+
+		/// \return The header's numMemories means of F
+		inline const double* GetMemoryDiffWeight() const
+		{
+			return Section(5);
+		}
+
+		/// \return The header's numMemories means of CR
+		inline const double* GetMemoryCrossoverProb() const
+		{
+			return Section(6);
+		}
+
+		/// \return The header's archiveSize rows of chromosomeLength values
+		inline const double* GetExternalArchive() const
+		{
+			return Section(7);
+		}
+
+	private:
+		MappedCheckpoint(const MappedCheckpoint&);
+		MappedCheckpoint& operator =(const MappedCheckpoint&);
+
+		inline const double* Section(unsigned int index) const
+		{
+			return reinterpret_cast<const double*>(m_pData + m_sectionOffsets[index]);
+		}
+
+	private:
+		const char*       m_pData;
+		std::size_t       m_size;
+		bool              m_isMapped;          // Otherwise m_pData points into m_buffer
+		std::vector<char> m_buffer;
+		std::size_t       m_sectionOffsets[8];
+	};
+
+
+	/// \brief Write checkpoints on a background thread, so the evolver only pays for copying
+	///        its state. If a new checkpoint is submitted before the previous one hits the
+	///        disk, only the newest is written.
+	class CheckpointWriter
+	{
+	public:
+		CheckpointWriter();
+
+		/// \brief Destructor. Writes the pending checkpoint, if any.
+		~CheckpointWriter();
+
+		/// \brief Queue a checkpoint. The state is swapped with an internal buffer, so the
+		///        caller gets back a buffer of the right capacity and no memory is allocated
+		///        once the writer is warm. The contents of state are unspecified afterwards.
+		/// \param[in] path. Destination file
+		/// \param[in,out] state. State to save
+		void Submit(const std::string& path, CheckpointState& state);
+
+		/// \brief Wait until every submitted checkpoint is written. Throws
+		///        std::runtime_error if a write failed since the last call.
+		void Flush();
+
+		/// \brief Get the number of checkpoints written so far
+		/// \return Number of files written
+		unsigned long long GetNumWritten();
+
+	private:
+		CheckpointWriter(const CheckpointWriter&);
+		CheckpointWriter& operator =(const CheckpointWriter&);
+
+		void Run();
+
+	private:
+		std::thread             m_thread;
+		std::mutex              m_mutex;
+		std::condition_variable m_condition;
+
+		CheckpointState    m_pending;
+		std::string        m_pendingPath;
+		bool               m_hasPending;
+		bool               m_isWriting;
+		bool               m_stop;
+		std::string        m_error;          // Message of the last failed write
+		unsigned long long m_numWritten;
+	};
+}
+
+#endif
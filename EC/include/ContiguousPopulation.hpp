@@ -0,0 +1,151 @@
+#ifndef EC_ContiguousPopulation_Hpp
+#define EC_ContiguousPopulation_Hpp
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+#include "AlignedMemory.hpp"
+#include "BasePopulation.hpp"
+#include "IndividualView.hpp"
+
+
+namespace EC
+{
+	/// \brief Population with structure-of-arrays storage. All chromosomes live in one
+	///        aligned N x stride matrix (one row per individual, rows padded with zeros to
+	///        a multiple of the SIMD width) and all fitness values in a separate array.
+	///
+	///        operator[] and Size() still work: each slot holds an IndividualView on the
+	///        corresponding row. The views are owned by the population; do not delete or
+	///        replace them, write genes and fitness through them instead.
+	template<typename ChromoType, typename FitnessType>
+	class ContiguousPopulation : public BasePopulation<ChromoType, FitnessType>
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] size. Desired population size
+		/// \param[in] chromosomeLength. Length of every chromosome
+		ContiguousPopulation(unsigned int size, unsigned int chromosomeLength);
+		virtual ~ContiguousPopulation();
+
+		/// \brief Get the chromosome matrix. Row i starts at i * GetStride().
+		/// \return Pointer to the first gene of the first individual
+		inline ChromoType* GetChromosomeData()
+		{
+			return m_pGenes;
+		}
+
+		/// \brief Get the chromosome of an individual, without bounds checking.
+		/// \param[in] index. Index of a particular individual
+		/// \return Pointer to the first gene of the individual
+		inline ChromoType* GetChromosome(unsigned int index)
+		{
+			return m_pGenes + static_cast<std::size_t>(index) * m_stride;
+		}
+
+		/// \brief Get the fitness array
+		/// \return Pointer to the fitness of the first individual
+		inline FitnessType* GetFitnessData()
+		{
+			return m_pFitness;
+		}
+
+		/// \brief Get the length of the chromosomes
+		/// \return Number of genes per individual
+		inline unsigned int GetChromosomeLength() const
+		{
+			return m_chromosomeLength;
+		}
+
+		/// \brief Get the distance, in genes, between two consecutive rows
+		/// \return Row stride
+		inline unsigned int GetStride() const
+		{
+			return m_stride;
+		}
+
+		/// \brief Drop the individuals from a given index on. The storage is kept, so the
+		///        remaining rows and views stay where they are.
+		/// \param[in] size. New size, not larger than the current one
+		void Truncate(unsigned int size);
+
+	private:
+		ContiguousPopulation(const ContiguousPopulation&);
+		ContiguousPopulation& operator =(const ContiguousPopulation&);
+
+	private:
+		ChromoType*  m_pGenes;
+		FitnessType* m_pFitness;
+		unsigned int m_chromosomeLength;
+		unsigned int m_stride;
+	};
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename ChromoType, typename FitnessType>
+EC::ContiguousPopulation<ChromoType, FitnessType>::ContiguousPopulation(
+	unsigned int size,
+	unsigned int chromosomeLength)
+	: BasePopulation<ChromoType, FitnessType>(size),
+	m_pGenes(NULL), m_pFitness(NULL), m_chromosomeLength(chromosomeLength), m_stride(chromosomeLength)
+{
+	static_assert(std::is_trivially_copyable<ChromoType>::value,
+		"ContiguousPopulation requires trivially copyable genes");
+	static_assert(std::is_trivially_copyable<FitnessType>::value,
+		"ContiguousPopulation requires a trivially copyable fitness");
+
+	if (chromosomeLength == 0)
+	{
+		throw std::invalid_argument("received non-positive chromosome length");
+	}
+
+	// Pad rows so that every row starts on an aligned boundary
+	if (SimdAlignment % sizeof(ChromoType) == 0)
+	{
+		unsigned int genesPerBlock = SimdAlignment / sizeof(ChromoType);
+		m_stride = (chromosomeLength + genesPerBlock - 1) / genesPerBlock * genesPerBlock;
+	}
+
+	std::size_t geneBytes = static_cast<std::size_t>(size) * m_stride * sizeof(ChromoType);
+	m_pGenes = static_cast<ChromoType*>(AlignedMalloc(geneBytes));
+	m_pFitness = static_cast<FitnessType*>(AlignedMalloc(size * sizeof(FitnessType)));
+	std::memset(static_cast<void*>(m_pGenes), 0, geneBytes);
+	std::memset(static_cast<void*>(m_pFitness), 0, size * sizeof(FitnessType));
+
+	for (unsigned int i = 0; i < size; i++)
+	{
+		this->m_population[i] = new IndividualView<ChromoType, FitnessType>(
+			GetChromosome(i), m_pFitness + i, m_chromosomeLength);
+	}
+}
+
+
+template<typename ChromoType, typename FitnessType>
+void EC::ContiguousPopulation<ChromoType, FitnessType>::Truncate(unsigned int size)
+{
+	if (size > this->m_population.size())
+	{
+		throw std::out_of_range("can't grow a population by truncation");
+	}
+	for (std::size_t i = size; i < this->m_population.size(); i++)
+	{
+		delete this->m_population[i];
+	}
+	this->m_population.resize(size);
+}
+
+
+template<typename ChromoType, typename FitnessType>
+EC::ContiguousPopulation<ChromoType, FitnessType>::~ContiguousPopulation()
+{
+	// The views are released by BasePopulation
+	AlignedFree(m_pGenes);
+	AlignedFree(m_pFitness);
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef EC_CooperativeCoevolution_Hpp
+#define EC_CooperativeCoevolution_Hpp
+
+#include <vector>
+#include "DifferentialEvolution.hpp"
+#include "RandomGenerator.hpp"
+#include "RealCodedIndividual.hpp"
+#include "StopCriteria.hpp"
+#include "ThreadPool.hpp"
+
+
+namespace EC
+{
+	/// \brief How the variables are split into subcomponents
+	enum GroupingMethod
+	{
+		GROUPING_RANDOM       = 0,  // New random groups of a fixed size every cycle
+		GROUPING_DIFFERENTIAL = 1   // Interacting variables detected once, before the first cycle
+	};
+
+
+	/// \brief Fitness of a subset of the variables, the others being taken from a context
+	///        vector. The genes of an individual are scattered into a private copy of the
+	///        context and the full functor is called on it, so a call only writes as many
+	///        genes as the subset has. Not thread-safe: one instance per thread.
+	class SubspaceFunctor : public BaseFitnessFunctor<double, double>
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] pFitnessFunc. Functor of the full problem, not owned
+		explicit SubspaceFunctor(BaseFitnessFunctor<double, double>* pFitnessFunc);
+		virtual ~SubspaceFunctor();
+
+		/// \brief Set the context vector and the variables of the subset
+		/// \param[in] context. Full-length vector providing the other variables
+		/// \param[in] indexes. Indexes of the variables of the subset
+		void SetContext(const std::vector<double>& context, const std::vector<unsigned int>& indexes);
+
+		virtual double operator() (BaseIndividual<double, double>* pIndiv);
+
+		virtual void EvaluateBatch(
+			const double* pChromosomes,
+			unsigned int numIndiv,
+			unsigned int length,
+			unsigned int stride,
+			double* pFitness);
+
+		virtual bool SupportsBoundedEvaluation() const;
+
+		virtual double EvaluateBounded(BaseIndividual<double, double>* pIndiv, double bound, bool& isAborted);
+
+	private:
+		SubspaceFunctor(const SubspaceFunctor&);
+		SubspaceFunctor& operator =(const SubspaceFunctor&);
+
+	private:
+		BaseFitnessFunctor<double, double>* m_pFitnessFunc;
+		std::vector<double>       m_point;     // Context, with the subset overwritten
+		std::vector<unsigned int> m_indexes;
+	};
+
+
+	/// \brief Cooperative co-evolution for large-scale problems (DECC).
+	///
+	/// \details  The variables are split into groups, either at random (DECC-G) or by
+	///           differential grouping, which perturbs pairs of variables to detect the
+	///           ones that interact. Every cycle, each group is optimized for a few
+	///           generations by its own DifferentialEvolution, with the other variables
+	///           fixed to the context vector, the best solution found so far. Groups run in
+	///           parallel against the same context, then their best solutions are merged
+	///           into it: all of them if the merged vector is the better, otherwise the best
+	///           single one. A trial only touches the genes of its group.
+	///
+	///           One full-length population is kept across cycles. A subcomponent starts
+	///           each cycle from its columns, plus the context, and writes them back at the
+	///           end, so random regrouping keeps the progress of every variable.
+	///
+	///           The stop criteria are checked between cycles; a cycle counts as a
+	///           generation. The evaluation budget, deadline and cancellation token are
+	///           also handed to the subcomponents, the budget left split evenly between
+	///           the groups, so a run stops within one of their generations. The fitness
+	///           functor is shared by all threads and must be thread-safe.
+	class CooperativeCoevolution
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] grouping. How the variables are split into subcomponents
+		CooperativeCoevolution(GroupingMethod grouping = GROUPING_RANDOM);
+		virtual ~CooperativeCoevolution();
+
+		/// \brief Set the size of the groups: of every group with random grouping, of the
+		///        groups of separable variables with differential grouping
+		/// \param[in] groupSize. Maximum number of variables per group
+		void SetGroupSize(unsigned int groupSize);
+
+		/// \brief Set how many generations a subcomponent runs per cycle
+		/// \param[in] numGenerations. Generations per cycle
+		void SetGenerationsPerCycle(unsigned int numGenerations);
+
+		/// \brief Set the threshold of differential grouping: two variables interact when
+		///        the effect of one changes by more than this when the other moves
+		/// \param[in] threshold. Non-negative threshold. default 1e-3
+		void SetInteractionThreshold(double threshold);
+
+		/// \brief Set the strategy of the subcomponent optimizers. The adaptive strategies
+		///        start from their initial parameters every cycle. L-SHADE isn't supported:
+		///        a subcomponent's population must keep its size across cycles.
+		/// \param[in] strategy. Strategy
+		/// \param[in] parameters. Parameters of the adaptive strategies
+		void SetStrategy(DEStrategy strategy, const AdaptiveParameters& parameters = AdaptiveParameters());
+
+		/// \brief Set the number of threads running subcomponents
+		/// \param[in] numThreads. 1 runs serially, 0 uses all cores (default)
+		inline void SetNumThreads(unsigned int numThreads)
+		{
+			m_numThreads = numThreads;
+		}
+
+		/// \brief Seed the subcomponents. Subcomponent i gets an independent stream of this seed.
+		/// \param[in] seed. Seed
+		void SetSeed(unsigned long long seed);
+
+		/// \brief Get the stop criteria checked between cycles and by the subcomponents,
+		///        to configure them
+		/// \return The stop criteria
+		inline StopCriteria& GetStopCriteria()
+		{
+			return m_stopCriteria;
+		}
+
+		/// \brief Get why the last run stopped
+		/// \return Reason, STOP_MAX_GENERATION when all cycles were run
+		inline StopReason GetStopReason() const
+		{
+			return m_stopReason;
+		}
+
+		/// \brief Evolve
+		/// \param[in] populationSize. Population size of every subcomponent, at least 4
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation, shared by all threads
+		/// \param[in] maxCycle. Max number of cycles. default 100
+		/// \param[in] verbose. If true, show a summary. default false
+		void Evolve(
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			unsigned int maxCycle=100,
+			bool verbose=false);
+
+		/// \brief Get the context vector, the best solution found
+		/// \return the best individual
+		BaseIndividual<double, double>* GetElite();
+
+		/// \brief Get the groups of the last cycle
+		/// \return Indexes of the variables of every group
+		inline const std::vector<std::vector<unsigned int> >& GetGroups() const
+		{
+			return m_groups;
+		}
+
+		/// \brief Get the number of cycles run
+		/// \return Cycle counter
+		inline unsigned int GetCycle() const
+		{
+			return m_cycle;
+		}
+
+		/// \brief Get the number of fitness evaluations, grouping included
+		/// \return Number of evaluations
+		unsigned long long GetNumEvaluations() const;
+
+		/// \brief Get the number of fitness evaluations spent by differential grouping
+		/// \return Number of evaluations
+		inline unsigned long long GetNumGroupingEvaluations() const
+		{
+			return m_numGroupingEvaluations;
+		}
+
+		/// \brief Differential grouping: find the variables that interact by perturbing
+		///        them from the lower corner of the domain. Takes about D^2 / 2 evaluations.
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		/// \param[in] threshold. Interaction threshold
+		/// \param[in] groupSize. Maximum size of the groups of separable variables
+		/// \param[in] pThreadPool. Pool to evaluate in parallel, NULL runs serially
+		/// \param[out] numEvaluations. Evaluations spent
+		/// \return Indexes of the variables of every group
+		static std::vector<std::vector<unsigned int> > DifferentialGrouping(
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			const std::vector<double>& lowerBound,
+			const std::vector<double>& upperBound,
+			double threshold,
+			unsigned int groupSize,
+			ThreadPool* pThreadPool,
+			unsigned long long& numEvaluations);
+
+	private:
+		CooperativeCoevolution(const CooperativeCoevolution&);
+		CooperativeCoevolution& operator =(const CooperativeCoevolution&);
+
+		/// \brief A group of variables and its optimizer
+		struct Subcomponent
+		{
+			DifferentialEvolution* pEvolver;
+			SubspaceFunctor*       pFunctor;
+			std::vector<double>    lowerBound;
+			std::vector<double>    upperBound;
+			std::vector<double>    bestGenes;
+			double                 bestFitness;
+		};
+
+		/// \brief Split the variables at random into groups of m_groupSize
+		void RandomGrouping();
+
+		/// \brief Create the missing subcomponents
+		void CreateSubcomponents();
+
+		/// \brief Run one cycle of a subcomponent against the context
+		/// \param[in] group. Index of the group
+		/// \param[in] maxEvaluations. Evaluations the cycle may spend. 0 for no limit.
+		void RunSubcomponent(unsigned int group, unsigned long long maxEvaluations);
+
+		/// \brief Merge the best solutions of the groups into the context
+		void MergeGroups();
+
+		/// \brief Mean distance of the population to its centroid
+		double ComputeDiversity() const;
+
+		void ReleaseSubcomponents();
+
+	private:
+		GroupingMethod      m_grouping;
+		unsigned int        m_groupSize;
+		unsigned int        m_generationsPerCycle;
+		double              m_interactionThreshold;
+		DEStrategy          m_strategy;
+		AdaptiveParameters  m_adaptive;
+		unsigned int        m_numThreads;
+		unsigned long long  m_seed;
+		RandomGenerator     m_randomGenerator;
+
+		// Problem
+		BaseFitnessFunctor<double, double>* m_pFitnessFunc;
+		std::vector<double> m_lowerBound;
+		std::vector<double> m_upperBound;
+		unsigned int        m_populationSize;
+
+		// State of the run
+		std::vector<std::vector<unsigned int> > m_groups;
+		std::vector<Subcomponent>   m_subcomponents;
+		std::vector<double>         m_population;      // m_populationSize rows of all the variables
+		std::vector<double>         m_context;
+		double                      m_contextFitness;
+		std::vector<unsigned int>   m_permutation;
+		std::vector<double>         m_merged;
+		unsigned int                m_cycle;
+		unsigned long long          m_numGroupingEvaluations;
+		unsigned long long          m_numContextEvaluations;  // Of the initial population and merged contexts
+		ThreadPool*                 m_pThreadPool;
+		StopCriteria                m_stopCriteria;
+		StopReason                  m_stopReason;
+		RealCodedIndividual*        m_pElite;
+	};
+}
+
+#endif
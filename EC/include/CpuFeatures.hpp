@@ -0,0 +1,41 @@
+#ifndef EC_CpuFeatures_Hpp
+#define EC_CpuFeatures_Hpp
+
+// x86 SIMD kernels are compiled with per-function target attributes and selected
+// at run time, so the library itself does not need -mavx2 / -mavx512f.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define EC_SIMD_X86 1
+#endif
+
+
+namespace EC
+{
+	/// \brief Instruction sets used by the vectorized kernels, in increasing order.
+	enum SimdLevel
+	{
+		SIMD_NONE   = 0,  // Portable scalar code
+		SIMD_SSE2   = 1,  // 2 doubles per register
+		SIMD_AVX2   = 2,  // 4 doubles per register, with FMA
+		SIMD_AVX512 = 3   // 8 doubles per register
+	};
+
+	/// \brief Get the instruction set the kernels dispatch to. Detected once, then capped
+	///        by SetMaxSimdLevel.
+	/// \return The SIMD level in use
+	SimdLevel GetSimdLevel();
+
+	/// \brief Get the best instruction set supported by this CPU
+	/// \return The detected SIMD level
+	SimdLevel DetectSimdLevel();
+
+	/// \brief Cap the instruction set used by the kernels, e.g. to compare code paths.
+	/// \param[in] level. Highest level allowed. Levels the CPU lacks are never used.
+	void SetMaxSimdLevel(SimdLevel level);
+
+	/// \brief Get a printable name of a SIMD level
+	/// \param[in] level. A SIMD level
+	/// \return Name of the level
+	const char* GetSimdLevelName(SimdLevel level);
+}
+
+#endif
@@ -1,18 +1,92 @@
 #ifndef EC_DifferentialEvolution_Hpp
 #define EC_DifferentialEvolution_Hpp
 
+#include <string>
 #include <vector>
 #include "BaseEvolver.hpp"
 #include "BaseFitnessFunctor.hpp"
+#include "Checkpoint.hpp"
+#include "ContiguousPopulation.hpp"
+#include "EliteArchive.hpp"
+#include "Surrogate.hpp"
 
 
 namespace EC
 {
+	/// \brief Mutation strategy and parameter control of DifferentialEvolution
+	enum DEStrategy
+	{
+		DE_RAND_1_BIN = 0,  // rand/1/bin with fixed F and CR
+		DE_JADE       = 1,  // current-to-pbest/1/bin with an archive, adaptive means of F and CR
+		DE_SHADE      = 2,  // As JADE, with a success history of F and CR
+		DE_LSHADE     = 3   // SHADE with linear population size reduction
+	};
+
+
+	/// \brief Settings of the adaptive strategies. Defaults follow L-SHADE.
+	///
+	///  Zhang, J. and Sanderson, A. C. "JADE: Adaptive Differential Evolution with Optional
+	///  External Archive." IEEE Trans. Evolutionary Computation 13(5), 945-958, 2009.
+	///  Tanabe, R. and Fukunaga, A. "Improving the Search Performance of SHADE Using Linear
+	///  Population Size Reduction." IEEE CEC, 1658-1665, 2014.
+	struct AdaptiveParameters
+	{
+		AdaptiveParameters()
+			: pBestRate(0.11), archiveRate(1.4), memorySize(5), learningRate(0.1),
+			initialDiffWeight(0.5), initialCrossoverProb(0.5), minPopulationSize(4)
+		{ }
+
+		double       pBestRate;             // Fraction of the population the pbest is drawn from
+		double       archiveRate;           // Archive capacity, relative to the population size
+		unsigned int memorySize;            // Entries of the success history (SHADE, L-SHADE)
+		double       learningRate;          // Adaptation rate of the means (JADE)
+		double       initialDiffWeight;     // Initial mean of F
+		double       initialCrossoverProb;  // Initial mean of CR
+		unsigned int minPopulationSize;     // Final population size (L-SHADE)
+	};
+
+
+	/// \brief Settings of the surrogate pre-screening of DifferentialEvolution
+	struct SurrogateParameters
+	{
+		SurrogateParameters()
+			: candidatesPerTarget(4), explorationWeight(1.0), minEvaluatedFraction(0.1), minTrainingPoints(0),
+			minRankAccuracy(0.7), probeInterval(5)
+		{ }
+
+		unsigned int candidatesPerTarget;   // Trials generated per target; the most promising is kept
+		double       explorationWeight;     // Candidates are ranked on mean - weight * std
+		double       minEvaluatedFraction;  // Trials evaluated per generation even if none looks promising
+		unsigned int minTrainingPoints;     // Points before the surrogate is used, 0 for 2 (n + 1)
+		double       minRankAccuracy;       // Screening is suspended below it, see GetSurrogateAccuracy
+		unsigned int probeInterval;         // Every probeInterval-th generation breeds the other way. 0 never.
+	};
+
+
 	/// \brief Differential evolution is a kind of evolutionary algorithm for black-box
 	///        optimization. DE is fast and robust.
 	///
 	///  Storn, R. and Price, K. "Differential Evolution: A Simple and Efficient Adaptive Scheme
     ///  for Global Optimization over Continuous Spaces." J. Global Optimization 11, 341-359, 1997.
+	///
+	///  The evolver owns two contiguous buffers, the population and the trials, allocated in
+	///  Initialize and swapped on every selection. No memory is allocated per generation.
+	///
+	///  The default strategy is rand/1/bin with F = 0.7 and CR = 0.2. The adaptive strategies
+	///  (SetStrategy) draw F and CR per individual around means learnt from the successful
+	///  trials, mutate towards one of the best individuals and keep the replaced parents in
+	///  an external archive for the difference vectors. L-SHADE also shrinks the population
+	///  linearly to AdaptiveParameters::minPopulationSize over the maximum generation.
+	///
+	///  With a surrogate (SetSurrogate), every generation breeds several candidate trials per
+	///  target and keeps the one with the best lower confidence bound. Only the trials
+	///  predicted to beat their target are evaluated, the others are rejected unevaluated.
+	///  The evolver checks the predictions against the evaluated trials; while the surrogate
+	///  ranks them worse than SurrogateParameters::minRankAccuracy, e.g. on rugged functions
+	///  it can't model, generations breed and evaluate one trial per target as without it.
+	///  Otherwise it keeps whichever breeding gains more fitness per evaluation, trying the
+	///  other one every SurrogateParameters::probeInterval generations: pre-selecting the
+	///  candidates can also mislead adaptive strategies on accurately modelled functions.
 	class DifferentialEvolution : public BaseEvolver<double, double>
 	{
 	public:
@@ -22,8 +96,69 @@ namespace EC
 		/// \brief Get the best individual
 		/// \return the best individual
 		BaseIndividual<double, double>* GetElite();	
-		
-	protected:
+
+		/// \brief Set how many of the best solutions found are kept in the archive. The
+		///        archive is updated during selection, as trials replace their targets.
+		/// \param[in] archiveSize. Number of solutions, at least 1 (default)
+		void SetArchiveSize(unsigned int archiveSize);
+
+		/// \brief Get the archive of the best solutions found. Evolver thread only; other
+		///        threads use GetEliteSnapshot.
+		/// \return The archive, best first
+		inline const EliteArchive& GetArchive() const
+		{
+			return m_archive;
+		}
+
+		/// \brief Copy the archive as of the last completed generation. Safe to call from
+		///        any thread while evolution runs; never blocks the evolver.
+		/// \param[out] snapshot. The archive, best first
+		/// \return False if no generation has completed yet
+		inline bool GetEliteSnapshot(EliteSnapshot& snapshot) const
+		{
+			return m_archive.ReadSnapshot(snapshot);
+		}
+
+		/// \brief Select the mutation strategy. Takes effect at Initialize.
+		/// \param[in] strategy. Strategy
+		/// \param[in] parameters. Settings of the adaptive strategies
+		void SetStrategy(DEStrategy strategy, const AdaptiveParameters& parameters = AdaptiveParameters());
+
+		inline DEStrategy GetStrategy() const
+		{
+			return m_strategy;
+		}
+
+		/// \brief Screen the trials with a surrogate model before evaluating them. The
+		///        surrogate is reset at Initialize and trained on every true evaluation.
+		/// \param[in] pSurrogate. Model, not owned. NULL evaluates every trial (default).
+		/// \param[in] parameters. Screening settings
+		void SetSurrogate(BaseSurrogate* pSurrogate, const SurrogateParameters& parameters = SurrogateParameters());
+
+		/// \brief Get the number of trials rejected by the surrogate without evaluation
+		/// \return Number of true evaluations avoided
+		inline unsigned long long GetNumScreenedOut() const
+		{
+			return m_numScreenedOut;
+		}
+
+		/// \brief Get how well the surrogate ranks the trials against their targets: the
+		///        fraction of (successful, failed) pairs of evaluated trials in which it
+		///        predicted the larger gain for the successful one, averaged over the last
+		///        generations. 0.5 is chance, 1 before anything was measured.
+		/// \return Rank accuracy
+		inline double GetSurrogateAccuracy() const
+		{
+			return m_surrogateAccuracy;
+		}
+
+		/// \brief Insert an individual coming from elsewhere, e.g. a migrant of an island
+		///        model. It replaces the worst individual if it is better.
+		/// \param[in] pGenes. Chromosome of the newcomer
+		/// \param[in] fitness. Fitness of the newcomer
+		/// \return True if the newcomer was inserted
+		bool Immigrate(const double* pGenes, double fitness);
+
 		/// \brief Create and initialize a population randomly. Overridden.
 		///	       WARNING: MUST BE CALLED BY OVERRIDDEN FUNCTION.
 		/// \param[in] populationSize. Size of a population.
@@ -37,10 +172,46 @@ namespace EC
 			BaseFitnessFunctor<double, double>* pFitnessFunc
 			);
 
-		/// \brief Select the better ones from the current population.
+		/// \brief Run one generation, then write a checkpoint if checkpointing is enabled.
+		virtual void Step();
+
+		/// \brief Set the population that will be evolved. Overridden. The evolver takes
+		///        ownership: the population is deleted at the next Initialize or
+		///        SetPopulation, or with the evolver. Must be a ContiguousPopulation.
+		/// \param[in] pop. Population allocated with new
+		virtual void SetPopulation(BasePopulation<double, double>* pop);
+
+		/// \brief Write the complete state of the run (population, elite, generation and
+		///        maximum generation, evaluation count, parameters and random generator) to a
+		///        checkpoint file. Adaptive strategies also save their memories of F and CR,
+		///        external archive and initial population size. A surrogate is not saved: it
+		///        is retrained from scratch on resume.
+		/// \param[in] path. Destination file
+		void SaveCheckpoint(const std::string& path);
+
+		/// \brief Restore a run from a checkpoint. Replaces Initialize; then call Resume
+		///        instead of Start, and drive the run with ShouldStop and Step. With the same
+		///        fitness functor the resumed run is identical to the run that wasn't
+		///        interrupted.
+		/// \param[in] path. Checkpoint file written by SaveCheckpoint or SetCheckpointing
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation
+		void LoadCheckpoint(const std::string& path, BaseFitnessFunctor<double, double>* pFitnessFunc);
+
+		/// \brief Checkpoint the run every few generations. Files are written on a
+		///        background thread; Step only copies the state.
+		/// \param[in] path. Checkpoint file, replaced atomically each time
+		/// \param[in] interval. Generations between checkpoints. 0 disables checkpointing.
+		void SetCheckpointing(const std::string& path, unsigned int interval);
+
+		/// \brief Wait until all periodic checkpoints are on disk. Throws
+		///        std::runtime_error if one of them failed.
+		void FlushCheckpoints();
+
+	protected:
+		/// \brief Replace every individual by its trial if the trial is better.
 		virtual void Select();
 
-		/// \brief Generate a new population using the selected individuals.
+		/// \brief Generate one trial per individual into the offsprings and evaluate them.
 		virtual void Breed();
 
 		/// \brief Check whether the stop criteria is met.
@@ -54,18 +225,148 @@ namespace EC
 		/// \param[in] min. Lower bound
 		/// \param[in] max. Upper bound
 		/// \param[in] numInteger. How many random integers will be generated
-		virtual int* RandIntegerWithoutReplacement(
+		/// \param[out] pIntegers. Buffer of at least numInteger integers
+		virtual void RandIntegerWithoutReplacement(
 			unsigned int min, 
 			unsigned int max, 
-			unsigned int numInteger
+			unsigned int numInteger,
+			int* pIntegers
 			);
 
 
-	private:
+	protected:
 		BaseIndividual<double, double>* m_pElite;
 
 		double m_diffWeight;    // Differential weights [0, 2]
 		double m_crossoverProb; // Crossover probability
+
+		std::vector<uint64_t> m_crossoverMask; // One bit per gene, reused by every trial
+
+		/// \brief Generate one trial per individual with the current strategy
+		/// \param[in] pPopulation. Population
+		/// \param[out] pTrials. Trial buffer of the same size
+		void GenerateTrials(ContiguousPopulation<double, double>* pPopulation, ContiguousPopulation<double, double>* pTrials);
+
+		/// \brief Generate candidates, keep the most promising per target according to the
+		///        surrogate and evaluate the trials predicted to beat their target
+		/// \param[in] pPopulation. Population
+		/// \param[out] pTrials. Trial buffer of the same size
+		void BreedScreened(ContiguousPopulation<double, double>* pPopulation, ContiguousPopulation<double, double>* pTrials);
+
+		/// \brief Decide whether the next generation is screened: not while the surrogate
+		///        ranks poorly, otherwise as the breeding that progresses faster per evaluation,
+		///        with a generation of the other one every probeInterval
+		/// \return True to screen
+		bool ChooseScreening();
+
+		/// \brief Update the progress per evaluation of screened or unscreened breeding
+		/// \param[in] isScreened. Breeding of the generation
+		/// \param[in] pParentFitness. Fitness of the targets
+		/// \param[in] pTrialFitness. Fitness of the trials, HUGE_VAL if not evaluated
+		/// \param[in] popSize. Number of targets
+		/// \param[in] numEvaluated. Trials evaluated
+		void RecordProgress(bool isScreened, const double* pParentFitness, const double* pTrialFitness,
+			unsigned int popSize, unsigned int numEvaluated);
+
+		/// \brief Predict the gain of every trial over its target, for the accuracy check of
+		///        generations that are not screened
+		/// \param[in] pPopulation. Population
+		/// \param[in] pTrials. Trials, not evaluated yet
+		void PredictTrials(ContiguousPopulation<double, double>* pPopulation, ContiguousPopulation<double, double>* pTrials);
+
+		/// \brief Compare the predicted gains of evaluated trials with their outcome and
+		///        update the rank accuracy of the surrogate
+		/// \param[in] pParentFitness. Fitness of the targets
+		/// \param[in] pTrialFitness. Fitness of the trials
+		/// \param[in] pRows. Evaluated trials. NULL for the first numRows.
+		/// \param[in] numRows. Number of evaluated trials
+		void UpdateSurrogateAccuracy(const double* pParentFitness, const double* pTrialFitness,
+			const unsigned int* pRows, unsigned int numRows);
+
+		/// \brief Generate the trials of the adaptive strategies: current-to-pbest/1/bin
+		///        with F and CR drawn per individual
+		/// \param[in] pPopulation. Population
+		/// \param[out] pTrials. Trial buffer of the same size
+		void BreedAdaptive(ContiguousPopulation<double, double>* pPopulation, ContiguousPopulation<double, double>* pTrials);
+
+		/// \brief Record the successful trials: archive their parents, keep their F and CR
+		///        weighted by the fitness improvement. Called before the replacement.
+		void RecordSuccesses(ContiguousPopulation<double, double>* pPopulation, ContiguousPopulation<double, double>* pTrials);
+
+		/// \brief Update the means of F and CR from the successes of the generation
+		void AdaptParameters();
+
+		/// \brief L-SHADE: drop the worst individuals to follow the linear size schedule
+		void ReducePopulation();
+
+		/// \brief Forget what was learnt about the surrogate, and empty it once the domain
+		///        is known, for a new run
+		void ResetSurrogateState();
+
+		/// \brief Reset the adaptation state for a new run
+		/// \param[in] populationSize. Initial population size
+		/// \param[in] chromosomeLength. Genes per individual
+		void ResetAdaptation(unsigned int populationSize, unsigned int chromosomeLength);
+
+		// Adaptive strategies
+		DEStrategy          m_strategy;
+		AdaptiveParameters  m_adaptive;
+		std::vector<double> m_memoryDiffWeight;     // Means of F, one for JADE
+		std::vector<double> m_memoryCrossoverProb;  // Means of CR, negative once CR is frozen to 0
+		unsigned int        m_memoryIndex;          // Next entry of the history to update
+		std::vector<double> m_trialDiffWeight;      // F of each trial
+		std::vector<double> m_trialCrossoverProb;   // CR of each trial
+		std::vector<double> m_successDiffWeight;    // F of the successful trials
+		std::vector<double> m_successCrossoverProb; // CR of the successful trials
+		std::vector<double> m_successImprovement;   // Their fitness improvements
+		std::vector<double> m_externalArchive;      // Replaced parents, rows of chromosome length
+		unsigned int        m_externalArchiveSize;  // Rows in use
+		unsigned int        m_initialPopulationSize;
+		std::vector<unsigned int> m_rankOrder;      // Population indexes, reused for ranking
+		std::vector<double> m_donorBase;            // x_i + F (x_pbest - x_i)
+
+		// Surrogate pre-screening
+		BaseSurrogate*      m_pSurrogate;
+		SurrogateParameters m_surrogateParameters;
+		bool                m_isSurrogateSeeded;      // The initial population was added
+		unsigned long long  m_numScreenedOut;
+		std::vector<double> m_candidates;             // candidatesPerTarget trial matrices
+		std::vector<double> m_candidateDiffWeight;
+		std::vector<double> m_candidateCrossoverProb;
+		std::vector<double> m_candidateScores;        // Lower confidence bounds
+		std::vector<unsigned int> m_screenedRows;     // Trials to evaluate
+		std::vector<double> m_predictedGains;         // Of each trial over its target
+		double              m_surrogateAccuracy;      // Moving average of the rank accuracy
+		double              m_screenedProgress;       // Moving averages of the progress per
+		double              m_unscreenedProgress;     //   evaluation, negative until measured
+		unsigned int        m_numSurrogateGenerations;
+
+		// Best solutions found, maintained by Select
+		EliteArchive m_archive;
+		unsigned int m_archiveSize;
+		bool         m_isArchiveValid;         // False until the population was archived
+		std::vector<std::vector<unsigned int> > m_archiveCandidates;  // Accepted trials, per thread
+
+		/// \brief Selection of the trials [begin, end): keep the better of trial and target
+		///        in the trial buffer, collect the accepted trials that would enter the archive
+		/// \param[in] begin. First individual
+		/// \param[in] end. One past the last individual
+		/// \param[in] threadIndex. Index of the calling thread, selects its candidate list
+		void SelectRange(unsigned int begin, unsigned int end, unsigned int threadIndex);
+
+		/// \brief Offer every individual of the population to the archive, e.g. after the
+		///        population was changed outside Select
+		void ArchivePopulation();
+
+		/// \brief Copy the state of the run
+		/// \param[out] state. Filled with the current state
+		void CaptureState(CheckpointState& state);
+
+		// Periodic checkpoints
+		CheckpointWriter* m_pCheckpointWriter;  // Created on first use
+		std::string       m_checkpointPath;
+		unsigned int      m_checkpointInterval;
+		CheckpointState   m_checkpointState;    // Recycled by the writer
 	};
 }
 
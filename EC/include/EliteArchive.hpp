@@ -0,0 +1,119 @@
+#ifndef EC_EliteArchive_Hpp
+#define EC_EliteArchive_Hpp
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+namespace EC
+{
+	/// \brief Copy of an EliteArchive taken by EliteArchive::ReadSnapshot
+	struct EliteSnapshot
+	{
+		unsigned int        generation;        // Generations completed when it was published
+		unsigned int        size;              // Number of solutions, best first
+		unsigned int        chromosomeLength;
+		std::vector<double> fitness;           // size values
+		std::vector<double> genes;             // size rows of chromosomeLength values
+	};
+
+
+	/// \brief The k best distinct solutions found so far, best first. Smaller, better.
+	///
+	/// \details  Owned and updated by the thread running the evolver: Offer keeps the
+	///           solutions sorted, in O(k) per accepted solution, so the elite is known
+	///           without scanning the population. Publish copies the archive into a
+	///           snapshot area guarded by a sequence lock; any other thread can then copy it
+	///           with ReadSnapshot while evolution runs, without blocking the evolver.
+	class EliteArchive
+	{
+	public:
+		EliteArchive();
+
+		/// \brief Empty the archive and set its shape. Not concurrent with ReadSnapshot.
+		/// \param[in] capacity. Number of solutions kept, at least 1
+		/// \param[in] chromosomeLength. Genes per solution
+		void Reset(unsigned int capacity, unsigned int chromosomeLength);
+
+		/// \brief Empty the archive, keeping its shape
+		void Clear();
+
+		/// \brief Insert a solution if it is among the k best. Identical solutions are
+		///        only kept once.
+		/// \param[in] pGenes. Chromosome
+		/// \param[in] fitness. Fitness
+		/// \return True if inserted
+		bool Offer(const double* pGenes, double fitness);
+
+		/// \brief Check whether a fitness would enter the archive, e.g. to filter
+		///        candidates before Offer
+		/// \param[in] fitness. Fitness
+		/// \return True if the archive isn't full or fitness beats the worst solution
+		inline bool IsCandidate(double fitness) const
+		{
+			return m_size < m_capacity || fitness < m_fitness[m_size - 1];
+		}
+
+		inline unsigned int Size() const
+		{
+			return m_size;
+		}
+
+		inline unsigned int GetCapacity() const
+		{
+			return m_capacity;
+		}
+
+		inline unsigned int GetChromosomeLength() const
+		{
+			return m_chromosomeLength;
+		}
+
+		/// \brief Get the fitness of a solution
+		/// \param[in] rank. 0 is the best
+		/// \return Fitness
+		inline double GetFitness(unsigned int rank) const
+		{
+			return m_fitness[rank];
+		}
+
+		/// \brief Get the chromosome of a solution
+		/// \param[in] rank. 0 is the best
+		/// \return Pointer to the genes
+		inline const double* GetChromosome(unsigned int rank) const
+		{
+			return &m_genes[static_cast<size_t>(rank) * m_chromosomeLength];
+		}
+
+		/// \brief Publish the archive to readers of ReadSnapshot
+		/// \param[in] generation. Generations completed
+		void Publish(unsigned int generation);
+
+		/// \brief Copy the last published archive. Safe from any thread.
+		/// \param[out] snapshot. Copy of the archive
+		/// \return False if nothing was published yet
+		bool ReadSnapshot(EliteSnapshot& snapshot) const;
+
+	private:
+		EliteArchive(const EliteArchive&);
+		EliteArchive& operator =(const EliteArchive&);
+
+	private:
+		// Working copy, evolver thread only
+		unsigned int        m_capacity;
+		unsigned int        m_chromosomeLength;
+		unsigned int        m_size;
+		std::vector<double> m_fitness;
+		std::vector<double> m_genes;
+
+		// Published copy. Relaxed atomics under a sequence lock: odd while being written.
+		std::atomic<unsigned long long>      m_sequence;
+		std::atomic<unsigned int>            m_publishedGeneration;
+		std::atomic<unsigned int>            m_publishedSize;
+		std::unique_ptr<std::atomic<double>[]> m_pPublishedFitness;
+		std::unique_ptr<std::atomic<double>[]> m_pPublishedGenes;
+	};
+}
+
+#endif
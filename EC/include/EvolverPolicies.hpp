@@ -0,0 +1,351 @@
+#ifndef EC_EvolverPolicies_Hpp
+#define EC_EvolverPolicies_Hpp
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include "BaseFitnessFunctor.hpp"
+#include "RandomGenerator.hpp"
+#include "SimdKernels.hpp"
+
+
+namespace EC
+{
+	/// \brief Read-only view of a population matrix handed to the mutation policies
+	struct PopulationMatrix
+	{
+		const double* pGenes;     // Row i starts at i * stride
+		const double* pFitness;
+		unsigned int  size;       // Number of individuals
+		unsigned int  length;     // Genes per individual
+		unsigned int  stride;
+		unsigned int  bestIndex;  // Individual with the smallest fitness
+
+		/// \brief Get the chromosome of an individual
+		/// \param[in] index. Index of a particular individual
+		/// \return Pointer to the first gene of the individual
+		inline const double* Row(unsigned int index) const
+		{
+			return pGenes + static_cast<std::size_t>(index) * stride;
+		}
+	};
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Genome policies: the length of the chromosomes and the trial blend
+	///////////////////////////////////////////////////////////////////////////////////////////////
+
+	/// \brief Chromosomes whose length is only known at run time. Trials are blended by the
+	///        runtime-dispatched SIMD kernel.
+	struct DynamicGenome
+	{
+		/// \brief Get the number of genes
+		/// \param[in] length. Length given to Initialize
+		/// \return Number of genes
+		static inline unsigned int Length(unsigned int length)
+		{
+			return length;
+		}
+
+		/// \brief Check that a problem dimension can be stored
+		/// \param[in] length. Length given to Initialize
+		/// \return True if valid
+		static inline bool Accepts(unsigned int length)
+		{
+			return length > 0;
+		}
+
+		/// \brief Blend donor x0 + weight * (x1 - x2) and target into a trial. See
+		///        SimdKernels::DifferentialTrial.
+		static inline void Trial(
+			const double* pTarget,
+			const double* pX0,
+			const double* pX1,
+			const double* pX2,
+			const uint64_t* pMask,
+			unsigned int length,
+			double weight,
+			double* pTrial)
+		{
+			SimdKernels::DifferentialTrial(pTarget, pX0, pX1, pX2, pMask, length, weight, pTrial);
+		}
+	};
+
+
+	/// \brief Chromosomes of exactly Dim genes. Gene loops have a constant trip count, so
+	///        the blend and inlined objectives are unrolled and vectorized by the compiler.
+	template<unsigned int Dim>
+	struct FixedGenome
+	{
+		static_assert(Dim > 0, "FixedGenome needs at least one gene");
+
+		static inline unsigned int Length(unsigned int)
+		{
+			return Dim;
+		}
+
+		static inline bool Accepts(unsigned int length)
+		{
+			return length == Dim;
+		}
+
+		static inline void Trial(
+			const double* pTarget,
+			const double* pX0,
+			const double* pX1,
+			const double* pX2,
+			const uint64_t* pMask,
+			unsigned int,
+			double weight,
+			double* pTrial)
+		{
+			// Constant trip count and no branch: the bits of the donor or of the target are
+			// selected with a mask, so the loop is unrolled and vectorized as a blend
+			for (unsigned int j = 0; j < Dim; j++)
+			{
+				double donor = pX0[j] + weight * (pX1[j] - pX2[j]);
+				uint64_t select = 0 - ((pMask[j >> 6] >> (j & 63)) & 1);
+				uint64_t donorBits, targetBits;
+				std::memcpy(&donorBits, &donor, sizeof(double));
+				std::memcpy(&targetBits, pTarget + j, sizeof(double));
+				uint64_t trialBits = (donorBits & select) | (targetBits & ~select);
+				std::memcpy(pTrial + j, &trialBits, sizeof(double));
+			}
+		}
+	};
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Mutation policies: build the trial of one individual
+	///////////////////////////////////////////////////////////////////////////////////////////////
+
+	/// \brief Draw distinct indexes in [0, popSize), in the order of
+	///        DifferentialEvolution::RandIntegerWithoutReplacement
+	/// \param[in,out] rng. Random number generator
+	/// \param[in] popSize. Population size
+	/// \param[in] numIndexes. How many indexes
+	/// \param[out] pIndexes. Buffer of at least numIndexes indexes
+	inline void DrawDistinctIndexes(
+		RandomGenerator& rng, unsigned int popSize, unsigned int numIndexes, unsigned int* pIndexes)
+	{
+		for (unsigned int i = 0; i < numIndexes; i++)
+		{
+			bool isNew;
+			do
+			{
+				pIndexes[i] = rng.NextInt(popSize);
+				isNew = true;
+				for (unsigned int j = 0; j < i; j++)
+				{
+					isNew = isNew && pIndexes[j] != pIndexes[i];
+				}
+			} while (!isNew);
+		}
+	}
+
+
+	/// \brief Draw a binomial crossover mask with at least one donor gene (j_rand)
+	/// \param[in,out] rng. Random number generator
+	/// \param[out] pMask. One bit per gene
+	/// \param[in] length. Number of genes
+	/// \param[in] crossoverProb. Probability of taking a donor gene
+	inline void DrawCrossoverMask(RandomGenerator& rng, uint64_t* pMask, unsigned int length, double crossoverProb)
+	{
+		rng.FillBernoulliMask(pMask, length, crossoverProb);
+		unsigned int randIndex = rng.NextInt(length);
+		pMask[randIndex >> 6] |= static_cast<uint64_t>(1) << (randIndex & 63);
+	}
+
+
+	/// \brief DE/rand/1/bin, the scheme of DifferentialEvolution
+	struct RandOneBinMutation
+	{
+		/// Smallest population the scheme works with
+		static const unsigned int MinPopulationSize = 4;
+
+		/// \brief Constructor
+		/// \param[in] diffWeight. Differential weight [0, 2]
+		/// \param[in] crossoverProb. Crossover probability
+		RandOneBinMutation(double diffWeight = 0.7, double crossoverProb = 0.2)
+			: m_diffWeight(diffWeight), m_crossoverProb(crossoverProb)
+		{ }
+
+		/// \brief Build the trial of an individual
+		/// \param[in] population. Current population
+		/// \param[in] index. Index of the target individual
+		/// \param[in,out] rng. Random number generator
+		/// \param[in] pMask. Scratch crossover mask, one bit per gene
+		/// \param[out] pTrial. Trial chromosome
+		template<typename Genome>
+		inline void Mutate(const PopulationMatrix& population, unsigned int index,
+			RandomGenerator& rng, uint64_t* pMask, double* pTrial) const
+		{
+			unsigned int r[3];
+			DrawDistinctIndexes(rng, population.size, 3, r);
+			unsigned int length = Genome::Length(population.length);
+			DrawCrossoverMask(rng, pMask, length, m_crossoverProb);
+			Genome::Trial(population.Row(index), population.Row(r[0]), population.Row(r[1]),
+				population.Row(r[2]), pMask, length, m_diffWeight, pTrial);
+		}
+
+		double m_diffWeight;
+		double m_crossoverProb;
+	};
+
+
+	/// \brief DE/best/1/bin: the donor is built around the current best individual.
+	///        Converges faster than rand/1 on unimodal functions, at the cost of diversity.
+	struct BestOneBinMutation
+	{
+		static const unsigned int MinPopulationSize = 3;
+
+		BestOneBinMutation(double diffWeight = 0.7, double crossoverProb = 0.2)
+			: m_diffWeight(diffWeight), m_crossoverProb(crossoverProb)
+		{ }
+
+		template<typename Genome>
+		inline void Mutate(const PopulationMatrix& population, unsigned int index,
+			RandomGenerator& rng, uint64_t* pMask, double* pTrial) const
+		{
+			unsigned int r[2];
+			DrawDistinctIndexes(rng, population.size, 2, r);
+			unsigned int length = Genome::Length(population.length);
+			DrawCrossoverMask(rng, pMask, length, m_crossoverProb);
+			Genome::Trial(population.Row(index), population.Row(population.bestIndex),
+				population.Row(r[0]), population.Row(r[1]), pMask, length, m_diffWeight, pTrial);
+		}
+
+		double m_diffWeight;
+		double m_crossoverProb;
+	};
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Selection policies: decide whether a trial replaces its target. Smaller, better.
+	///////////////////////////////////////////////////////////////////////////////////////////////
+
+	/// \brief Keep the trial only if it is strictly better, as DifferentialEvolution
+	struct GreedySelection
+	{
+		inline bool AcceptTrial(double trialFitness, double targetFitness) const
+		{
+			return trialFitness < targetFitness;
+		}
+	};
+
+
+	/// \brief Keep the trial if it is not worse, so that the population can drift along
+	///        plateaus of the fitness landscape
+	struct WeakGreedySelection
+	{
+		inline bool AcceptTrial(double trialFitness, double targetFitness) const
+		{
+			return trialFitness <= targetFitness;
+		}
+	};
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Objective policies: evaluate a block of rows of a population matrix
+	///////////////////////////////////////////////////////////////////////////////////////////////
+
+	/// \brief Forward to a BaseFitnessFunctor: one virtual call per block of rows
+	class FunctorObjective
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation. Not owned.
+		explicit FunctorObjective(BaseFitnessFunctor<double, double>* pFitnessFunc = NULL)
+			: m_pFitnessFunc(pFitnessFunc)
+		{ }
+
+		inline void EvaluateBatch(const double* pGenes, unsigned int numRows,
+			unsigned int length, unsigned int stride, double* pFitness)
+		{
+			m_pFitnessFunc->EvaluateBatch(pGenes, numRows, length, stride, pFitness);
+		}
+
+		/// \brief Check that a functor is set
+		/// \return True if the objective can be evaluated
+		inline bool IsValid() const
+		{
+			return m_pFitnessFunc != NULL;
+		}
+
+	private:
+		BaseFitnessFunctor<double, double>* m_pFitnessFunc;
+	};
+
+
+	/// \brief Call a function object, double(const double* pGenes, unsigned int length),
+	///        inline on every row
+	template<typename Func>
+	class InlineObjective
+	{
+	public:
+		explicit InlineObjective(const Func& func = Func())
+			: m_func(func)
+		{ }
+
+		inline void EvaluateBatch(const double* pGenes, unsigned int numRows,
+			unsigned int length, unsigned int stride, double* pFitness)
+		{
+			for (unsigned int i = 0; i < numRows; i++)
+			{
+				pFitness[i] = m_func(pGenes + static_cast<std::size_t>(i) * stride, length);
+			}
+		}
+
+		inline bool IsValid() const
+		{
+			return true;
+		}
+
+		/// \brief Get the wrapped function object
+		/// \return The function object
+		inline Func& GetFunction()
+		{
+			return m_func;
+		}
+
+	private:
+		Func m_func;
+	};
+
+
+	/// \brief Call a function object on a std::array<double, Dim>, e.g. the functors of
+	///        FixedBenchmarkFunctions.hpp, inline on every row. The row is copied into a local
+	///        array, which the compiler keeps in registers once the call is inlined.
+	template<unsigned int Dim, typename Func>
+	class ArrayObjective
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] pFunc. Function object, double(const std::array<double, Dim>&). Not owned.
+		ArrayObjective(Func* pFunc = NULL)
+			: m_pFunc(pFunc)
+		{ }
+
+		inline void EvaluateBatch(const double* pGenes, unsigned int numRows,
+			unsigned int, unsigned int stride, double* pFitness)
+		{
+			std::array<double, Dim> genes;
+			for (unsigned int i = 0; i < numRows; i++)
+			{
+				std::memcpy(&genes[0], pGenes + static_cast<std::size_t>(i) * stride, Dim * sizeof(double));
+				pFitness[i] = (*m_pFunc)(genes);
+			}
+		}
+
+		inline bool IsValid() const
+		{
+			return m_pFunc != NULL;
+		}
+
+	private:
+		Func* m_pFunc;
+	};
+}
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef EC_FixedBenchmarkFunctions_Hpp
+#define EC_FixedBenchmarkFunctions_Hpp
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+
+namespace EC
+{
+	/// \brief Base of the fixed-dimension test functions: domain and known optimum. The same
+	///        functions as BenchmarkFunctions.hpp, for FixedDimDifferentialEvolution. The
+	///        objectives are plain inline operator() on a std::array, so the compiler sees
+	///        the dimension and can unroll and vectorize them.
+	template<unsigned int Dim>
+	class FixedBenchmarkFunctor
+	{
+	public:
+		typedef std::array<double, Dim> Chromosome;
+
+		/// \brief Constructor
+		/// \param[in] lowerBound. Domain lower bound, the same for every dimension
+		/// \param[in] upperBound. Domain upper bound, the same for every dimension
+		/// \param[in] optimum. Every gene of the global minimum
+		FixedBenchmarkFunctor(double lowerBound, double upperBound, double optimum)
+			: m_lowerBound(Dim, lowerBound), m_upperBound(Dim, upperBound), m_optimum(Dim, optimum)
+		{ }
+
+		/// \brief Get the domain lower bound
+		/// \return the domain lower bound
+		inline std::vector<double>& GetDomainLowerBound()
+		{
+			return m_lowerBound;
+		}
+
+		/// \brief Get the domain upper bound
+		/// \return the domain upper bound
+		inline std::vector<double>& GetDomainUpperBound()
+		{
+			return m_upperBound;
+		}
+
+		/// \brief Get the location of the global minimum
+		/// \return The optimal chromosome
+		inline const std::vector<double>& GetOptimum() const
+		{
+			return m_optimum;
+		}
+
+		/// \brief Get the value of the global minimum
+		/// \return The optimal fitness
+		inline double GetOptimalFitness() const
+		{
+			return 0;
+		}
+
+	protected:
+		std::vector<double> m_lowerBound;
+		std::vector<double> m_upperBound;
+		std::vector<double> m_optimum;
+	};
+
+
+	/// \brief Sphere function, see SphereFunctor
+	template<unsigned int Dim>
+	class FixedSphereFunctor : public FixedBenchmarkFunctor<Dim>
+	{
+	public:
+		FixedSphereFunctor() : FixedBenchmarkFunctor<Dim>(-5.12, 5.12, 0)
+		{ }
+
+		inline double operator() (const std::array<double, Dim>& x) const
+		{
+			// Independent partial sums break the dependency chain and map onto SIMD lanes
+			double partial[4] = { 0, 0, 0, 0 };
+			for (unsigned int i = 0; i < Dim; i++)
+			{
+				partial[i % 4] += x[i] * x[i];
+			}
+			return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+		}
+	};
+
+
+	/// \brief Rastrigin function, see RastriginFunctor
+	template<unsigned int Dim>
+	class FixedRastriginFunctor : public FixedBenchmarkFunctor<Dim>
+	{
+	public:
+		FixedRastriginFunctor() : FixedBenchmarkFunctor<Dim>(-5.12, 5.12, 0)
+		{ }
+
+		inline double operator() (const std::array<double, Dim>& x) const
+		{
+			const double twoPi = 6.28318530717958647692;
+			double sum = 10.0 * Dim;
+			for (unsigned int i = 0; i < Dim; i++)
+			{
+				sum += x[i] * x[i] - 10 * std::cos(twoPi * x[i]);
+			}
+			return sum;
+		}
+	};
+
+
+	/// \brief Rosenbrock function, see RosenbrockFunctor
+	template<unsigned int Dim>
+	class FixedRosenbrockFunctor : public FixedBenchmarkFunctor<Dim>
+	{
+		static_assert(Dim >= 2, "Rosenbrock function needs at least two dimensions");
+
+	public:
+		FixedRosenbrockFunctor() : FixedBenchmarkFunctor<Dim>(-2.048, 2.048, 1)
+		{ }
+
+		inline double operator() (const std::array<double, Dim>& x) const
+		{
+			double partial[4] = { 0, 0, 0, 0 };
+			for (unsigned int i = 0; i + 1 < Dim; i++)
+			{
+				double a = x[i + 1] - x[i] * x[i];
+				double b = 1 - x[i];
+				partial[i % 4] += 100 * a * a + b * b;
+			}
+			return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+		}
+	};
+
+
+	/// \brief Ackley function, see AckleyFunctor
+	template<unsigned int Dim>
+	class FixedAckleyFunctor : public FixedBenchmarkFunctor<Dim>
+	{
+	public:
+		FixedAckleyFunctor() : FixedBenchmarkFunctor<Dim>(-32.768, 32.768, 0)
+		{ }
+
+		inline double operator() (const std::array<double, Dim>& x) const
+		{
+			const double twoPi = 6.28318530717958647692;
+			double sumSquares = 0;
+			double sumCos = 0;
+			for (unsigned int i = 0; i < Dim; i++)
+			{
+				sumSquares += x[i] * x[i];
+				sumCos += std::cos(twoPi * x[i]);
+			}
+			return -20 * std::exp(-0.2 * std::sqrt(sumSquares / Dim)) - std::exp(sumCos / Dim) + 20 + std::exp(1.0);
+		}
+	};
+
+
+	/// \brief Griewank function, see GriewankFunctor
+	template<unsigned int Dim>
+	class FixedGriewankFunctor : public FixedBenchmarkFunctor<Dim>
+	{
+	public:
+		FixedGriewankFunctor() : FixedBenchmarkFunctor<Dim>(-600, 600, 0)
+		{ }
+
+		inline double operator() (const std::array<double, Dim>& x) const
+		{
+			double sum = 0;
+			double product = 1;
+			for (unsigned int i = 0; i < Dim; i++)
+			{
+				sum += x[i] * x[i];
+				product *= std::cos(x[i] / std::sqrt(i + 1.0));
+			}
+			return 1 + sum / 4000 - product;
+		}
+	};
+
+
+	/// \brief Schwefel function 2.26, see SchwefelFunctor
+	template<unsigned int Dim>
+	class FixedSchwefelFunctor : public FixedBenchmarkFunctor<Dim>
+	{
+	public:
+		FixedSchwefelFunctor() : FixedBenchmarkFunctor<Dim>(-500, 500, 420.9687460425061)
+		{ }
+
+		inline double operator() (const std::array<double, Dim>& x) const
+		{
+			double sum = 418.9828872724338 * Dim;
+			for (unsigned int i = 0; i < Dim; i++)
+			{
+				sum -= x[i] * std::sin(std::sqrt(std::fabs(x[i])));
+			}
+			return sum;
+		}
+	};
+}
+
+#endif
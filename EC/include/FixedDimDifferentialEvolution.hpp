@@ -0,0 +1,26 @@
+#ifndef EC_FixedDimDifferentialEvolution_Hpp
+#define EC_FixedDimDifferentialEvolution_Hpp
+
+#include "EvolverPolicies.hpp"
+#include "PolicyEvolver.hpp"
+
+
+namespace EC
+{
+	/// \brief Differential evolution (rand/1/bin, as DifferentialEvolution) for problems whose
+	///        dimension is known at compile time.
+	///
+	///  The policy core with FixedGenome<Dim>: gene loops have a constant trip count, so the
+	///  trial blend is unrolled and vectorized by the compiler. The objective is called as
+	///  double(const std::array<double, Dim>&), e.g. the functors of FixedBenchmarkFunctions.hpp,
+	///  and is inlined. Evaluation is serial.
+	///
+	///      FixedSphereFunctor<30> sphere;
+	///      FixedDimDifferentialEvolution<30, FixedSphereFunctor<30> > de(&sphere);
+	///      de.Evolve(60, sphere.GetDomainLowerBound(), sphere.GetDomainUpperBound(), 1000);
+	template<unsigned int Dim, typename Objective>
+	using FixedDimDifferentialEvolution =
+		PolicyDifferentialEvolution<FixedGenome<Dim>, ArrayObjective<Dim, Objective> >;
+}
+
+#endif
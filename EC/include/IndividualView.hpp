@@ -0,0 +1,136 @@
+#ifndef EC_IndividualView_Hpp
+#define EC_IndividualView_Hpp
+
+#include <vector>
+#include <stdexcept>
+#include "BaseIndividual.hpp"
+
+namespace EC
+{
+	/// \brief A lightweight individual that does not own its genes. It refers to a row of a
+	///        contiguous chromosome matrix and to a slot of a fitness array, so evolvers and
+	///        functors written against BaseIndividual keep working on contiguous storage.
+	template<typename ChromoType, typename FitnessType>
+	class IndividualView : public BaseIndividual<ChromoType, FitnessType>
+	{
+	public:
+		/// \brief Constructor. The view refers to external storage.
+		/// \param[in] pGenes. First gene of the chromosome
+		/// \param[in] pFitness. Where the fitness is stored
+		/// \param[in] length. Length of the chromosome
+		IndividualView(ChromoType* pGenes, FitnessType* pFitness, unsigned int length);
+
+		/// \brief Constructor. The view owns a chromosome of the given length.
+		/// \param[in] length. Length of the chromosome
+		IndividualView(unsigned int length);
+
+		virtual ~IndividualView();
+
+		/// \brief Point the view to another row.
+		/// \param[in] pGenes. First gene of the chromosome
+		/// \param[in] pFitness. Where the fitness is stored
+		inline void Bind(ChromoType* pGenes, FitnessType* pFitness)
+		{
+			m_pGenes = pGenes;
+			m_pFitness = pFitness;
+		}
+
+		/// \brief Overloaded subscript. Note that the return value can be a left-value.
+		/// \param[in] index. Index of a particular gene
+		/// \return The corresponding gene.
+		virtual ChromoType& operator[](const int index)
+		{
+			if (index < 0 || static_cast<unsigned int>(index) >= m_length)
+			{
+				throw std::out_of_range("Index out of bound");
+			}
+			return m_pGenes[index];
+		}
+
+		/// \brief Get the length of this individual
+		/// \return Length of the individual(chromosome).
+		inline virtual int Size() const
+		{
+			return m_length;
+		}
+
+		/// \brief Get the fitness of this individual
+		/// \return Fitness
+		inline virtual FitnessType GetFitness() const
+		{
+			return *m_pFitness;
+		}
+
+		/// \brief Set the fitness of this individual
+		/// \param[in] fitness. Fitness
+		inline virtual void SetFitness(FitnessType fitness)
+		{
+			*m_pFitness = fitness;
+		}
+
+		/// \brief Create a deepcopy of this individual. The copy owns its genes.
+		/// \return A pointer to a deepcopy of this individual
+		virtual BaseIndividual<ChromoType, FitnessType>* DeepCopy();
+
+		/// \brief Direct access to the genes, without bounds checking.
+		/// \return Pointer to the first gene
+		inline ChromoType* GetData()
+		{
+			return m_pGenes;
+		}
+
+	private:
+		IndividualView(const IndividualView&);
+		IndividualView& operator =(const IndividualView&);
+
+	private:
+		ChromoType*  m_pGenes;
+		FitnessType* m_pFitness;
+		unsigned int m_length;
+
+		// Only used when the view owns its storage
+		std::vector<ChromoType> m_ownedGenes;
+		FitnessType             m_ownedFitness;
+	};
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename ChromoType, typename FitnessType>
+EC::IndividualView<ChromoType, FitnessType>::IndividualView(
+	ChromoType* pGenes,
+	FitnessType* pFitness,
+	unsigned int length)
+	: m_pGenes(pGenes), m_pFitness(pFitness), m_length(length), m_ownedFitness()
+{ }
+
+
+template<typename ChromoType, typename FitnessType>
+EC::IndividualView<ChromoType, FitnessType>::IndividualView(unsigned int length)
+	: m_length(length), m_ownedGenes(length), m_ownedFitness()
+{
+	m_pGenes = m_ownedGenes.empty() ? NULL : &m_ownedGenes[0];
+	m_pFitness = &m_ownedFitness;
+}
+
+
+template<typename ChromoType, typename FitnessType>
+EC::IndividualView<ChromoType, FitnessType>::~IndividualView()
+{ }
+
+
+template<typename ChromoType, typename FitnessType>
+EC::BaseIndividual<ChromoType, FitnessType>* EC::IndividualView<ChromoType, FitnessType>::DeepCopy()
+{
+	IndividualView<ChromoType, FitnessType>* deepCopy = new IndividualView<ChromoType, FitnessType>(m_length);
+	for (unsigned int i = 0; i < m_length; i++)
+	{
+		deepCopy->m_pGenes[i] = m_pGenes[i];
+	}
+	deepCopy->SetFitness(*m_pFitness);
+	return deepCopy;
+}
+
+#endif
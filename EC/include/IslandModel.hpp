@@ -0,0 +1,162 @@
+#ifndef EC_IslandModel_Hpp
+#define EC_IslandModel_Hpp
+
+#include <atomic>
+#include <vector>
+#include "DifferentialEvolution.hpp"
+#include "RealCodedIndividual.hpp"
+#include "SpscQueue.hpp"
+
+
+namespace EC
+{
+	/// \brief How islands exchange migrants
+	enum MigrationTopology
+	{
+		TOPOLOGY_RING            = 0,  // Island i sends to island i+1
+		TOPOLOGY_TORUS           = 1,  // Islands on a wrapped 2D grid, four neighbours each
+		TOPOLOGY_FULLY_CONNECTED = 2   // Every island sends to every other island
+	};
+
+
+	/// \brief Island-model parallel differential evolution.
+	///
+	/// \details  Each island is an independent DifferentialEvolution with its own population,
+	///           random stream and thread. Every few generations an island sends its elite to
+	///           its neighbours and takes in the migrants it has received, which replace its
+	///           worst individuals if better. Islands never wait for each other: migrants go
+	///           through bounded lock-free single-producer single-consumer buffers, one per
+	///           edge of the topology, and are dropped when a buffer is full.
+	///
+	///           The fitness functor is shared by all islands and must be thread-safe.
+	class IslandModel
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] numIslands. Number of islands, one thread each
+		/// \param[in] topology. Migration topology
+		IslandModel(unsigned int numIslands, MigrationTopology topology = TOPOLOGY_RING);
+		virtual ~IslandModel();
+
+		/// \brief Set how often migration happens
+		/// \param[in] interval. Number of generations between migrations. 0 disables migration.
+		inline void SetMigrationInterval(unsigned int interval)
+		{
+			m_migrationInterval = interval;
+		}
+
+		/// \brief Set the capacity of each migration buffer
+		/// \param[in] capacity. Migrants that can wait on one edge
+		inline void SetMigrationBufferSize(unsigned int capacity)
+		{
+			m_migrationBufferSize = capacity;
+		}
+
+		/// \brief Seed the islands. Island i gets an independent stream of this seed.
+		/// \param[in] seed. Seed
+		inline void SetSeed(unsigned long long seed)
+		{
+			m_seed = seed;
+		}
+
+		/// \brief Evolve all islands in parallel
+		/// \param[in] populationSize. Population size of each island
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation, shared by all islands
+		/// \param[in] maxGeneration. Generations run by each island, unless its own stop
+		///            criteria (GetIsland(i)->GetStopCriteria()) end it first. default 100
+		/// \param[in] verbose. If true, show a summary. default false
+		void Evolve(
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			unsigned int maxGeneration=100,
+			bool verbose=false);
+
+		/// \brief Get the best individual over all islands
+		/// \return the best individual
+		BaseIndividual<double, double>* GetElite();
+
+		/// \brief Get an island
+		/// \param[in] island. Index of the island
+		/// \return The evolver of the island
+		DifferentialEvolution* GetIsland(unsigned int island);
+
+		/// \brief Get the number of islands
+		/// \return Number of islands
+		inline unsigned int GetNumIslands() const
+		{
+			return static_cast<unsigned int>(m_islands.size());
+		}
+
+		/// \brief Get the islands an island sends its migrants to
+		/// \param[in] island. Index of the island
+		/// \return Indices of the neighbours
+		const std::vector<unsigned int>& GetNeighbours(unsigned int island) const;
+
+		/// \brief Get the number of migrants accepted by the islands
+		/// \return Number of accepted migrants
+		inline unsigned long long GetNumMigrations() const
+		{
+			return m_numMigrations;
+		}
+
+		/// \brief Get the number of fitness evaluations over all islands
+		/// \return Number of evaluations
+		unsigned long long GetNumEvaluations() const;
+
+		/// \brief Build the outgoing edges of a topology
+		/// \param[in] numIslands. Number of islands
+		/// \param[in] topology. Migration topology
+		/// \return For every island, the islands it sends its migrants to
+		static std::vector<std::vector<unsigned int> > BuildTopology(
+			unsigned int numIslands, 
+			MigrationTopology topology);
+
+	private:
+		IslandModel(const IslandModel&);
+		IslandModel& operator =(const IslandModel&);
+
+		/// \brief A migrant in transit
+		struct Migrant
+		{
+			std::vector<double> genes;
+			double              fitness;
+		};
+
+		/// \brief Build the edges of the topology and their buffers
+		void BuildChannels();
+
+		/// \brief Main loop of one island thread
+		void RunIsland(
+			unsigned int island,
+			unsigned int populationSize,
+			std::vector<double> lowerBound,
+			std::vector<double> upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			unsigned int maxGeneration);
+
+		void ReleaseChannels();
+
+	private:
+		std::vector<DifferentialEvolution*>      m_islands;
+		MigrationTopology                        m_topology;
+		std::vector<std::vector<unsigned int> >  m_neighbours;
+
+		// One buffer per directed edge, indexed through the per-island edge lists
+		std::vector<SpscQueue<Migrant>*>         m_channels;
+		std::vector<std::vector<unsigned int> >  m_outgoingChannels;
+		std::vector<std::vector<unsigned int> >  m_incomingChannels;
+
+		unsigned int        m_migrationInterval;
+		unsigned int        m_migrationBufferSize;
+		unsigned long long  m_seed;
+
+		std::atomic<unsigned long long> m_numMigrations;
+		RealCodedIndividual*            m_pElite;
+	};
+}
+
+#endif
@@ -0,0 +1,599 @@
+#ifndef EC_PolicyEvolver_Hpp
+#define EC_PolicyEvolver_Hpp
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+#include "ContiguousPopulation.hpp"
+#include "EvolverPolicies.hpp"
+#include "RandomGenerator.hpp"
+#include "StatisticsStream.hpp"
+
+
+namespace EC
+{
+	/// \brief Static counterpart of BaseEvolver. The main loop calls the phases of Derived
+	///        (Evaluate, Breed, Select, SaveElite, CheckStopCriteria) through the curiously
+	///        recurring template pattern, so there is no virtual call per generation and the
+	///        phases can be inlined into Step. Derived also provides ComputeStatistics, called
+	///        only when a statistics stream is set.
+	template<typename Derived>
+	class PolicyEvolver
+	{
+	public:
+		/// \brief Evaluate the initial population. Call it once before Step.
+		/// \param[in] verbose. If true and no statistics stream is set, the statistics of
+		///            every generation are written to std::cout as CSV
+		inline void Start(bool verbose=false)
+		{
+			m_verbose = verbose;
+			if (m_verbose && m_pStatisticsStream == NULL)
+			{
+				if (m_pConsoleStatistics == NULL)
+				{
+					m_pConsoleSink = new CsvStatisticsSink(std::cout);
+					m_pConsoleStatistics = new StatisticsStream();
+					m_pConsoleStatistics->AddSink(m_pConsoleSink);
+				}
+				m_pStatisticsStream = m_pConsoleStatistics;
+			}
+			else if (!m_verbose && m_pStatisticsStream == m_pConsoleStatistics)
+			{
+				m_pStatisticsStream = NULL;
+			}
+			m_startTime = Clock::now();
+			Self().EvaluatePopulation();
+		}
+
+		/// \brief Run one generation: breed, select and save the elite.
+		inline void Step()
+		{
+			// Timed only when the statistics are published
+			bool isPublished = m_pStatisticsStream != NULL;
+			Clock::time_point breedTime = isPublished ? Clock::now() : Clock::time_point();
+
+			Self().Breed();     // Generate offsprings
+
+			Clock::time_point selectTime = isPublished ? Clock::now() : breedTime;
+
+			Self().Select();    // Select better ones
+
+			Clock::time_point saveEliteTime = isPublished ? Clock::now() : breedTime;
+
+			Self().SaveElite(); // Save the best one
+
+			m_generation++;
+
+			if (isPublished)
+			{
+				Publish(breedTime, selectTime, saveEliteTime);
+			}
+		}
+
+		/// \brief Evolve. The main loop
+		/// \param[in] maxGeneration. Max generation allowed
+		/// \param[in] verbose. If true, show details during evolving
+		void Evolve(unsigned int maxGeneration=100, bool verbose=false)
+		{
+			m_maxGeneration = maxGeneration;
+			Start(verbose);
+			while (Self().CheckStopCriteria() == false)
+			{
+				Step();
+			}
+			if (m_pStatisticsStream != NULL)
+			{
+				m_pStatisticsStream->Flush();
+			}
+		}
+
+		/// \brief Publish the statistics of every generation to a stream. Computing them
+		///        costs one pass over the population per generation.
+		/// \param[in] pStream. Stream, not owned. NULL disables the statistics.
+		inline void SetStatisticsStream(StatisticsStream* pStream)
+		{
+			m_pStatisticsStream = pStream;
+		}
+
+		/// \brief Get the number of generations done so far
+		/// \return Generation counter
+		inline unsigned int GetGeneration() const
+		{
+			return m_generation;
+		}
+
+		/// \brief Get the number of fitness evaluations done so far
+		/// \return Number of evaluations
+		inline unsigned long long GetNumEvaluations() const
+		{
+			return m_numEvaluations;
+		}
+
+	protected:
+		typedef std::chrono::steady_clock Clock;
+
+		PolicyEvolver()
+			: m_generation(0), m_maxGeneration(100), m_numEvaluations(0), m_verbose(false),
+			m_pStatisticsStream(NULL), m_pConsoleStatistics(NULL), m_pConsoleSink(NULL)
+		{ }
+
+		~PolicyEvolver()
+		{
+			delete m_pConsoleStatistics;
+			delete m_pConsoleSink;
+		}
+
+		inline Derived& Self()
+		{
+			return *static_cast<Derived*>(this);
+		}
+
+		/// \brief Publish the statistics of the generation just completed
+		void Publish(Clock::time_point breedTime, Clock::time_point selectTime, Clock::time_point saveEliteTime)
+		{
+			Clock::time_point endTime = Clock::now();
+			GenerationStatistics record = GenerationStatistics();
+			record.generation = m_generation;
+			record.numEvaluations = m_numEvaluations;
+			// Evaluation runs inside Breed and isn't timed on its own
+			record.breedSeconds = std::chrono::duration<double>(selectTime - breedTime).count();
+			record.selectSeconds = std::chrono::duration<double>(saveEliteTime - selectTime).count();
+			record.saveEliteSeconds = std::chrono::duration<double>(endTime - saveEliteTime).count();
+			record.elapsedSeconds = std::chrono::duration<double>(endTime - m_startTime).count();
+			Self().ComputeStatistics(record);
+			m_pStatisticsStream->Publish(record);
+		}
+
+	protected:
+		unsigned int       m_generation;     // Generation
+		unsigned int       m_maxGeneration;  // Max generation allowed
+		unsigned long long m_numEvaluations;
+		bool               m_verbose;
+
+		StatisticsStream*  m_pStatisticsStream;
+		StatisticsStream*  m_pConsoleStatistics;  // Owned, used when verbose
+		CsvStatisticsSink* m_pConsoleSink;
+		Clock::time_point  m_startTime;
+
+	private:
+		PolicyEvolver(const PolicyEvolver&);
+		PolicyEvolver& operator =(const PolicyEvolver&);
+	};
+
+
+	/// \brief Differential evolution assembled from policies resolved at compile time:
+	///
+	///  - Genome:    DynamicGenome or FixedGenome<Dim>, the chromosome length and trial blend
+	///  - Objective: FunctorObjective or InlineObjective<Func>, evaluates blocks of rows
+	///  - Mutation:  RandOneBinMutation, BestOneBinMutation, ... builds one trial
+	///  - Selection: GreedySelection, WeakGreedySelection, ... trial against target
+	///
+	///  See EvolverPolicies.hpp for the interface each policy provides. Storage is the same as
+	///  DifferentialEvolution: two ContiguousPopulation buffers swapped on every selection.
+	///  With rand/1/bin, greedy selection and the same seed, the run is identical to
+	///  DifferentialEvolution. PolicyEvolverAdapter exposes it through BaseEvolver.
+	template<typename Genome, typename Objective,
+		typename Mutation = RandOneBinMutation, typename Selection = GreedySelection>
+	class PolicyDifferentialEvolution
+		: public PolicyEvolver<PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection> >
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] objective. Objective policy
+		/// \param[in] mutation. Mutation policy
+		/// \param[in] selection. Selection policy
+		explicit PolicyDifferentialEvolution(
+			const Objective& objective = Objective(),
+			const Mutation& mutation = Mutation(),
+			const Selection& selection = Selection());
+		~PolicyDifferentialEvolution();
+
+		/// \brief Create and initialize a population randomly.
+		/// \param[in] populationSize. Size of a population, at least Mutation::MinPopulationSize
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		void Initialize(
+			unsigned int populationSize,
+			const std::vector<double>& lowerBound,
+			const std::vector<double>& upperBound
+			);
+
+		/// \brief Initialize, then evolve.
+		/// \param[in] populationSize. Size of a population
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		/// \param[in] maxGeneration. Max generation allowed
+		/// \param[in] verbose. If true, show details during evolving
+		void Evolve(
+			unsigned int populationSize,
+			const std::vector<double>& lowerBound,
+			const std::vector<double>& upperBound,
+			unsigned int maxGeneration=100,
+			bool verbose=false
+			);
+		using PolicyEvolver<PolicyDifferentialEvolution>::Evolve;
+
+		/// \brief Seed the random number generator owned by the evolver
+		/// \param[in] seed. Seed
+		void SetSeed(unsigned long long seed);
+
+		/// \brief Get the seed of the random number generator owned by the evolver
+		/// \return Seed
+		inline unsigned long long GetSeed() const
+		{
+			return m_seed;
+		}
+
+		/// \brief Draw random numbers from another generator, e.g. the one of an adapter.
+		/// \param[in] pRandomGenerator. Generator, not owned. NULL restores the own generator.
+		inline void SetRandomGenerator(RandomGenerator* pRandomGenerator)
+		{
+			m_pRandomGenerator = pRandomGenerator != NULL ? pRandomGenerator : &m_randomGenerator;
+		}
+
+		// Phases of a generation, called by Step. Public so that adapters can interleave
+		// their own work, e.g. parallel evaluation of the trials.
+
+		/// \brief Evaluate every individual of the population
+		void EvaluatePopulation();
+
+		/// \brief Generate one trial per individual, without evaluating them
+		void GenerateTrials();
+
+		/// \brief Evaluate every trial
+		void EvaluateTrials();
+
+		/// \brief Generate and evaluate the trials
+		inline void Breed()
+		{
+			GenerateTrials();
+			EvaluateTrials();
+		}
+
+		/// \brief Replace every individual by its trial if Selection accepts the trial.
+		void Select();
+
+		/// \brief Save elite
+		void SaveElite();
+
+		/// \brief Check whether the stop criteria is met.
+		inline bool CheckStopCriteria() const
+		{
+			return this->m_generation >= this->m_maxGeneration;
+		}
+
+		/// \brief Fill the population statistics of a record: best, mean and standard
+		///        deviation of the fitness, and diversity as in BaseEvolver
+		/// \param[in,out] record. Statistics of the generation
+		void ComputeStatistics(GenerationStatistics& record);
+
+		/// \brief Get the chromosome of the best individual
+		/// \return Pointer to the genes, NULL before the first generation
+		inline const double* GetEliteChromosome() const
+		{
+			return m_hasElite ? &m_eliteChromosome[0] : NULL;
+		}
+
+		/// \brief Get the fitness of the best individual
+		/// \return Fitness, only valid after the first generation
+		inline double GetEliteFitness() const
+		{
+			return m_eliteFitness;
+		}
+
+		/// \brief Get the population
+		/// \return The population, NULL before Initialize
+		inline ContiguousPopulation<double, double>* GetPopulation()
+		{
+			return m_pPopulation;
+		}
+
+		/// \brief Get the trial buffer
+		/// \return The trials, NULL before Initialize
+		inline ContiguousPopulation<double, double>* GetTrials()
+		{
+			return m_pTrials;
+		}
+
+		inline Objective& GetObjective()
+		{
+			return m_objective;
+		}
+
+		inline Mutation& GetMutation()
+		{
+			return m_mutation;
+		}
+
+		inline Selection& GetSelection()
+		{
+			return m_selection;
+		}
+
+	private:
+		PolicyDifferentialEvolution(const PolicyDifferentialEvolution&);
+		PolicyDifferentialEvolution& operator =(const PolicyDifferentialEvolution&);
+
+		/// \brief Describe the population to the mutation policy
+		PopulationMatrix GetPopulationMatrix() const;
+
+	private:
+		ContiguousPopulation<double, double>* m_pPopulation;
+		ContiguousPopulation<double, double>* m_pTrials;
+
+		Objective m_objective;
+		Mutation  m_mutation;
+		Selection m_selection;
+
+		std::vector<double>   m_lowerBound;
+		std::vector<double>   m_upperBound;
+		std::vector<uint64_t> m_crossoverMask;  // One bit per gene, reused by every trial
+		std::vector<double>   m_centroid;       // Scratch of ComputeStatistics
+
+		std::vector<double> m_eliteChromosome;
+		double              m_eliteFitness;
+		bool                m_hasElite;
+
+		unsigned long long m_seed;
+		RandomGenerator    m_randomGenerator;
+		RandomGenerator*   m_pRandomGenerator;  // m_randomGenerator or an external one
+	};
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::PolicyDifferentialEvolution(
+	const Objective& objective,
+	const Mutation& mutation,
+	const Selection& selection)
+	: m_pPopulation(NULL), m_pTrials(NULL), m_objective(objective), m_mutation(mutation),
+	m_selection(selection), m_eliteFitness(0), m_hasElite(false), m_pRandomGenerator(&m_randomGenerator)
+{
+	std::random_device randDevice;
+	SetSeed((static_cast<unsigned long long>(randDevice()) << 32) ^ randDevice());
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::~PolicyDifferentialEvolution()
+{
+	delete m_pPopulation;
+	delete m_pTrials;
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::SetSeed(unsigned long long seed)
+{
+	m_seed = seed;
+	m_randomGenerator.Seed(seed, 0);
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::Initialize(
+	unsigned int populationSize,
+	const std::vector<double>& lowerBound,
+	const std::vector<double>& upperBound)
+{
+	if (populationSize < Mutation::MinPopulationSize)
+	{
+		throw std::invalid_argument("Population size too small for the mutation scheme");
+	}
+	if (lowerBound.size() != upperBound.size())
+	{
+		throw std::invalid_argument("Lower and upper bounds should have the same size");
+	}
+	unsigned int problemDim = static_cast<unsigned int>(lowerBound.size());
+	if (!Genome::Accepts(problemDim))
+	{
+		throw std::invalid_argument("Problem dimension doesn't match the genome");
+	}
+	for (unsigned int k = 0; k < problemDim; k++)
+	{
+		if (lowerBound[k] > upperBound[k])
+		{
+			throw std::invalid_argument("Lower bound must be not bigger than the upper bound.");
+		}
+	}
+	if (!m_objective.IsValid())
+	{
+		throw std::invalid_argument("Invalid fitness function");
+	}
+	m_lowerBound = lowerBound;
+	m_upperBound = upperBound;
+
+	delete m_pPopulation;
+	delete m_pTrials;
+	m_pPopulation = NULL;
+	m_pTrials = new ContiguousPopulation<double, double>(populationSize, problemDim);
+	m_pPopulation = new ContiguousPopulation<double, double>(populationSize, problemDim);
+	for (unsigned int i = 0; i < populationSize; i++)
+	{
+		double* pGenes = m_pPopulation->GetChromosome(i);
+		for (unsigned int k = 0; k < problemDim; k++)
+		{
+			pGenes[k] = m_pRandomGenerator->Uniform(m_lowerBound[k], m_upperBound[k]);
+		}
+	}
+	m_crossoverMask.assign((problemDim + 63) / 64, 0);
+	m_hasElite = false;
+	this->m_generation = 0;
+	this->m_numEvaluations = 0;
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::Evolve(
+	unsigned int populationSize,
+	const std::vector<double>& lowerBound,
+	const std::vector<double>& upperBound,
+	unsigned int maxGeneration,
+	bool verbose)
+{
+	Initialize(populationSize, lowerBound, upperBound);
+	Evolve(maxGeneration, verbose);
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::EvaluatePopulation()
+{
+	if (m_pPopulation == NULL)
+	{
+		throw std::runtime_error("Empty population. Call Initialize first");
+	}
+	m_objective.EvaluateBatch(m_pPopulation->GetChromosomeData(), m_pPopulation->Size(),
+		Genome::Length(m_pPopulation->GetChromosomeLength()), m_pPopulation->GetStride(),
+		m_pPopulation->GetFitnessData());
+	this->m_numEvaluations += m_pPopulation->Size();
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+EC::PopulationMatrix
+EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::GetPopulationMatrix() const
+{
+	PopulationMatrix population;
+	population.pGenes = m_pPopulation->GetChromosomeData();
+	population.pFitness = m_pPopulation->GetFitnessData();
+	population.size = m_pPopulation->Size();
+	population.length = m_pPopulation->GetChromosomeLength();
+	population.stride = m_pPopulation->GetStride();
+	population.bestIndex = static_cast<unsigned int>(
+		std::min_element(population.pFitness, population.pFitness + population.size) - population.pFitness);
+	return population;
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::GenerateTrials()
+{
+	if (m_pPopulation == NULL || m_pPopulation->Size() == 0)
+	{
+		throw std::runtime_error("Empty population. Can't do breeding");
+	}
+
+	// Mutation and crossover, written in place into the trial buffer
+	const PopulationMatrix population = GetPopulationMatrix();
+	RandomGenerator& rng = *m_pRandomGenerator;
+	uint64_t* pMask = &m_crossoverMask[0];
+	for (unsigned int i = 0; i < population.size; i++)
+	{
+		m_mutation.template Mutate<Genome>(population, i, rng, pMask, m_pTrials->GetChromosome(i));
+	}
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::EvaluateTrials()
+{
+	m_objective.EvaluateBatch(m_pTrials->GetChromosomeData(), m_pTrials->Size(),
+		Genome::Length(m_pTrials->GetChromosomeLength()), m_pTrials->GetStride(),
+		m_pTrials->GetFitnessData());
+	this->m_numEvaluations += m_pTrials->Size();
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::Select()
+{
+	// Targets that survive are copied into the trial buffer, which then becomes the population
+	unsigned int popSize = m_pPopulation->Size();
+	size_t rowBytes = m_pPopulation->GetStride() * sizeof(double);
+	double* pParentFitness = m_pPopulation->GetFitnessData();
+	double* pTrialFitness = m_pTrials->GetFitnessData();
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		if (!m_selection.AcceptTrial(pTrialFitness[i], pParentFitness[i]))
+		{
+			std::memcpy(m_pTrials->GetChromosome(i), m_pPopulation->GetChromosome(i), rowBytes);
+			pTrialFitness[i] = pParentFitness[i];
+		}
+	}
+
+	std::swap(m_pPopulation, m_pTrials);
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::SaveElite()
+{
+	// Smaller, better
+	const double* pFitness = m_pPopulation->GetFitnessData();
+	unsigned int bestIndex = static_cast<unsigned int>(
+		std::min_element(pFitness, pFitness + m_pPopulation->Size()) - pFitness);
+
+	// Keep a copy. The population row may be overwritten by later generations.
+	const double* pBest = m_pPopulation->GetChromosome(bestIndex);
+	m_eliteChromosome.assign(pBest, pBest + m_pPopulation->GetChromosomeLength());
+	m_eliteFitness = pFitness[bestIndex];
+	m_hasElite = true;
+
+}
+
+
+template<typename Genome, typename Objective, typename Mutation, typename Selection>
+void EC::PolicyDifferentialEvolution<Genome, Objective, Mutation, Selection>::ComputeStatistics(
+	GenerationStatistics& record)
+{
+	unsigned int popSize = m_pPopulation->Size();
+	unsigned int length = m_pPopulation->GetChromosomeLength();
+	const double* pFitness = m_pPopulation->GetFitnessData();
+
+	// Fitness: smaller, better
+	double best = pFitness[0];
+	double sum = 0;
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		best = std::min(best, pFitness[i]);
+		sum += pFitness[i];
+	}
+	double mean = sum / popSize;
+	double sumSquares = 0;
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		sumSquares += (pFitness[i] - mean) * (pFitness[i] - mean);
+	}
+	record.bestFitness = best;
+	record.meanFitness = mean;
+	record.stdFitness = std::sqrt(sumSquares / popSize);
+
+	// Diversity: mean Euclidean distance to the centroid
+	m_centroid.assign(length, 0);
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		const double* pGenes = m_pPopulation->GetChromosome(i);
+		for (unsigned int k = 0; k < length; k++)
+		{
+			m_centroid[k] += pGenes[k];
+		}
+	}
+	for (unsigned int k = 0; k < length; k++)
+	{
+		m_centroid[k] /= popSize;
+	}
+	double sumDistances = 0;
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		const double* pGenes = m_pPopulation->GetChromosome(i);
+		double squaredDistance = 0;
+		for (unsigned int k = 0; k < length; k++)
+		{
+			squaredDistance += (pGenes[k] - m_centroid[k]) * (pGenes[k] - m_centroid[k]);
+		}
+		sumDistances += std::sqrt(squaredDistance);
+	}
+	record.diversity = sumDistances / popSize;
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef EC_PolicyEvolverAdapter_Hpp
+#define EC_PolicyEvolverAdapter_Hpp
+
+#include <vector>
+#include "BaseEvolver.hpp"
+#include "BaseFitnessFunctor.hpp"
+#include "PolicyEvolver.hpp"
+#include "RealCodedIndividual.hpp"
+
+
+namespace EC
+{
+	/// \brief BaseEvolver front end of PolicyDifferentialEvolution, usable wherever a
+	///        DifferentialEvolution is. Each virtual phase makes a single call into the policy
+	///        core, whose per-individual loops are inlined. Trials are evaluated by
+	///        BaseEvolver::Evaluate, so SetNumThreads and the evaluation statistics work as
+	///        usual, and the core draws from the evolver's generator, so SetSeed does too.
+	///
+	///        The populations are owned by the core: don't replace them with SetPopulation.
+	template<typename Genome = DynamicGenome,
+		typename Mutation = RandOneBinMutation, typename Selection = GreedySelection>
+	class PolicyEvolverAdapter : public BaseEvolver<double, double>
+	{
+	public:
+		typedef PolicyDifferentialEvolution<Genome, FunctorObjective, Mutation, Selection> Core;
+
+		/// \brief Constructor
+		/// \param[in] mutation. Mutation policy
+		/// \param[in] selection. Selection policy
+		explicit PolicyEvolverAdapter(const Mutation& mutation = Mutation(), const Selection& selection = Selection());
+		virtual ~PolicyEvolverAdapter();
+
+		/// \brief Get the best individual
+		/// \return the best individual, NULL before the first generation
+		BaseIndividual<double, double>* GetElite();
+
+		/// \brief Create and initialize a population randomly. Overridden.
+		/// \param[in] populationSize. Size of a population.
+		/// \param[in] lowerBound. Domain lower bound.
+		/// \param[in] upperBound. Domain upper bound.
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation.
+		virtual void Initialize(
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc
+			);
+
+		/// \brief Get the policy core
+		/// \return The core
+		inline Core& GetCore()
+		{
+			return m_core;
+		}
+
+	protected:
+		/// \brief Replace every individual by its trial if the trial is accepted.
+		virtual void Select();
+
+		/// \brief Generate one trial per individual into the offsprings and evaluate them.
+		virtual void Breed();
+
+		/// \brief Check whether the stop criteria is met.
+		virtual bool CheckStopCriteria();
+
+		/// \brief Save elite
+		virtual void SaveElite();
+
+	protected:
+		Core m_core;
+		RealCodedIndividual* m_pElite;
+	};
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename Genome, typename Mutation, typename Selection>
+EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::PolicyEvolverAdapter(
+	const Mutation& mutation, const Selection& selection)
+	: m_core(FunctorObjective(), mutation, selection), m_pElite(NULL)
+{
+	m_core.SetRandomGenerator(&GetRandomGenerator());
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::~PolicyEvolverAdapter()
+{
+	delete m_pElite;
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+void EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::Initialize(
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc)
+{
+	BaseEvolver<double, double>::Initialize(populationSize, lowerBound, upperBound, pFitnessFunc);
+
+	m_core.GetObjective() = FunctorObjective(pFitnessFunc);
+	m_core.Initialize(populationSize, lowerBound, upperBound);
+	m_pPopulation = m_core.GetPopulation();
+	m_pOffsprings = m_core.GetTrials();
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+void EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::Breed()
+{
+	m_core.GenerateTrials();
+
+	// Evaluate all trials at once, so that they can be spread over threads
+	Evaluate(m_pOffsprings);
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+void EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::Select()
+{
+	m_core.Select();
+	m_pPopulation = m_core.GetPopulation();
+	m_pOffsprings = m_core.GetTrials();
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+bool EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::CheckStopCriteria()
+{
+	return m_generation >= m_maxGeneration;
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+void EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::SaveElite()
+{
+	m_core.SaveElite();
+
+	int length = static_cast<int>(m_core.GetPopulation()->GetChromosomeLength());
+	if (m_pElite == NULL || m_pElite->Size() != length)
+	{
+		delete m_pElite;
+		m_pElite = new RealCodedIndividual(length);
+	}
+	const double* pBest = m_core.GetEliteChromosome();
+	for (int k = 0; k < length; k++)
+	{
+		(*m_pElite)[k] = pBest[k];
+	}
+	m_pElite->SetFitness(m_core.GetEliteFitness());
+}
+
+
+template<typename Genome, typename Mutation, typename Selection>
+EC::BaseIndividual<double, double>* EC::PolicyEvolverAdapter<Genome, Mutation, Selection>::GetElite()
+{
+	return m_pElite;
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef EC_ProcessIslandModel_Hpp
+#define EC_ProcessIslandModel_Hpp
+
+#include <vector>
+#include "IslandModel.hpp"
+#include "RealCodedIndividual.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define EC_HAS_POSIX_PROCESSES 1
+#endif
+
+
+namespace EC
+{
+	/// \brief Island-model differential evolution with one OS process per island.
+	///
+	/// \details  For fitness functions that are not thread-safe. The calling process is the
+	///           coordinator: it forks one worker per island and waits for them, leaving
+	///           its other child processes alone. Each worker runs its own
+	///           DifferentialEvolution on its own copy of the fitness functor.
+	///
+	///           Workers share one anonymous shared-memory region with the coordinator. It
+	///           holds a lock-free single-producer single-consumer ring of migrant slots per
+	///           edge of the topology, and per island a status block: generation, evaluation
+	///           count and the current elite, published every generation under a sequence
+	///           lock. If a worker dies (signal or non-zero exit), the coordinator forks it
+	///           again up to SetMaxRestarts times. The new worker reseeds its population with
+	///           the last published elite and runs the remaining generations; an elite
+	///           torn by a worker killed while publishing it is dropped. The elite
+	///           returned by GetElite is the best one published by any island.
+	///
+	///           POSIX only. Elsewhere Evolve throws std::runtime_error.
+	class ProcessIslandModel
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] numIslands. Number of islands, one process each
+		/// \param[in] topology. Migration topology
+		ProcessIslandModel(unsigned int numIslands, MigrationTopology topology = TOPOLOGY_RING);
+		virtual ~ProcessIslandModel();
+
+		/// \brief Set how often migration happens
+		/// \param[in] interval. Number of generations between migrations. 0 disables migration.
+		inline void SetMigrationInterval(unsigned int interval)
+		{
+			m_migrationInterval = interval;
+		}
+
+		/// \brief Set the capacity of each migration ring
+		/// \param[in] capacity. Migrants that can wait on one edge
+		inline void SetMigrationBufferSize(unsigned int capacity)
+		{
+			m_migrationBufferSize = capacity;
+		}
+
+		/// \brief Seed the islands. Island i gets an independent stream of this seed.
+		/// \param[in] seed. Seed
+		inline void SetSeed(unsigned long long seed)
+		{
+			m_seed = seed;
+		}
+
+		/// \brief Set how many times a crashed island is started again
+		/// \param[in] maxRestarts. Restarts allowed per island
+		inline void SetMaxRestarts(unsigned int maxRestarts)
+		{
+			m_maxRestarts = maxRestarts;
+		}
+
+		/// \brief Evolve all islands in parallel processes and collect the results
+		/// \param[in] populationSize. Population size of each island
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation, copied into each worker
+		/// \param[in] maxGeneration. Generations run by each island. default 100
+		/// \param[in] verbose. If true, report crashes and a summary. default false
+		void Evolve(
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			unsigned int maxGeneration=100,
+			bool verbose=false);
+
+		/// \brief Get the best individual published by any island
+		/// \return the best individual, NULL before Evolve
+		BaseIndividual<double, double>* GetElite();
+
+		/// \brief Get the number of islands
+		/// \return Number of islands
+		inline unsigned int GetNumIslands() const
+		{
+			return m_numIslands;
+		}
+
+		/// \brief Get the number of worker processes that died during the last run
+		/// \return Number of crashes
+		inline unsigned int GetNumCrashes() const
+		{
+			return m_numCrashes;
+		}
+
+		/// \brief Get the number of islands that gave up after too many crashes
+		/// \return Number of failed islands
+		inline unsigned int GetNumFailedIslands() const
+		{
+			return m_numFailedIslands;
+		}
+
+		/// \brief Get the number of migrants accepted during the last run
+		/// \return Number of accepted migrants
+		inline unsigned long long GetNumMigrations() const
+		{
+			return m_numMigrations;
+		}
+
+		/// \brief Get the number of fitness evaluations during the last run
+		/// \return Number of evaluations
+		inline unsigned long long GetNumEvaluations() const
+		{
+			return m_numEvaluations;
+		}
+
+	private:
+		ProcessIslandModel(const ProcessIslandModel&);
+		ProcessIslandModel& operator =(const ProcessIslandModel&);
+
+		/// \brief Body of a worker process. Never returns.
+		void RunWorker(
+			void* pRegion,
+			unsigned int island,
+			unsigned int attempt,
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			unsigned int maxGeneration);
+
+	private:
+		unsigned int                             m_numIslands;
+		std::vector<std::vector<unsigned int> >  m_neighbours;
+
+		unsigned int        m_migrationInterval;
+		unsigned int        m_migrationBufferSize;
+		unsigned int        m_maxRestarts;
+		unsigned long long  m_seed;
+
+		unsigned int        m_numCrashes;
+		unsigned int        m_numFailedIslands;
+		unsigned long long  m_numMigrations;
+		unsigned long long  m_numEvaluations;
+		RealCodedIndividual* m_pElite;
+	};
+}
+
+#endif
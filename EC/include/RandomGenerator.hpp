@@ -0,0 +1,150 @@
+#ifndef EC_RandomGenerator_Hpp
+#define EC_RandomGenerator_Hpp
+
+#include <cstddef>
+#include <stdint.h>
+
+
+namespace EC
+{
+	/// \brief Fast pseudo random number generator (xoshiro256++) with bulk fill methods.
+	///
+	/// \details  A generator is fully determined by a seed and a stream id. Different stream
+	///           ids give independent sequences, so each thread or each individual can own a
+	///           generator and parallel runs stay bit-reproducible. Also usable as a standard
+	///           UniformRandomBitGenerator (e.g. with std::shuffle).
+	///
+	///  Blackman, D. and Vigna, S. "Scrambled Linear Pseudorandom Number Generators."
+	///  ACM Transactions on Mathematical Software 47(4), 2021.
+	class RandomGenerator
+	{
+	public:
+		typedef uint64_t result_type;
+
+		/// \brief Number of 64-bit words saved by GetState: the xoshiro state plus a
+		///        pending normal number
+		static const unsigned int StateSize = 6;
+
+		/// \brief Constructor
+		/// \param[in] seed. Seed of the sequence
+		/// \param[in] stream. Id of an independent stream for the same seed
+		RandomGenerator(uint64_t seed = 0, uint64_t stream = 0);
+
+		/// \brief Restart the generator
+		/// \param[in] seed. Seed of the sequence
+		/// \param[in] stream. Id of an independent stream for the same seed
+		void Seed(uint64_t seed, uint64_t stream = 0);
+
+		/// \brief Advance the generator by 2^128 draws, e.g. to split one stream in
+		///        non-overlapping sub-streams.
+		void Jump();
+
+		/// \brief Generate 64 random bits
+		/// \return Random bits
+		inline uint64_t Next()
+		{
+			const uint64_t result = RotateLeft(m_state[0] + m_state[3], 23) + m_state[0];
+			const uint64_t t = m_state[1] << 17;
+			m_state[2] ^= m_state[0];
+			m_state[3] ^= m_state[1];
+			m_state[1] ^= m_state[2];
+			m_state[0] ^= m_state[3];
+			m_state[2] ^= t;
+			m_state[3] = RotateLeft(m_state[3], 45);
+			return result;
+		}
+
+		/// \brief Generate a number from the uniform distribution [0, 1)
+		/// \return Random number
+		inline double NextDouble()
+		{
+			return (Next() >> 11) * (1.0 / 9007199254740992.0);
+		}
+
+		/// \brief Generate a number from a given uniform distribution [min, max)
+		/// \param[in] min. Lower bound
+		/// \param[in] max. Upper bound
+		/// \return Random number
+		inline double Uniform(double min, double max)
+		{
+			return min + (max - min) * NextDouble();
+		}
+
+		/// \brief Generate an integer from the uniform distribution [0, bound), unbiased.
+		/// \param[in] bound. Upper bound, excluded. Must be positive.
+		/// \return Random integer
+		inline uint32_t NextInt(uint32_t bound)
+		{
+			// Lemire's multiply-and-reject method
+			uint64_t m = static_cast<uint64_t>(static_cast<uint32_t>(Next() >> 32)) * bound;
+			uint32_t low = static_cast<uint32_t>(m);
+			if (low < bound)
+			{
+				uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+				while (low < threshold)
+				{
+					m = static_cast<uint64_t>(static_cast<uint32_t>(Next() >> 32)) * bound;
+					low = static_cast<uint32_t>(m);
+				}
+			}
+			return static_cast<uint32_t>(m >> 32);
+		}
+
+		/// \brief Generate a number from a given normal distribution (mean, std)
+		/// \param[in] mean. Mean of the distribution
+		/// \param[in] std. Standard deviation of the distribution
+		/// \return Random number
+		double Normal(double mean, double std);
+
+		/// \brief Generate a number from a given Cauchy distribution (location, scale)
+		/// \param[in] location. Median of the distribution
+		/// \param[in] scale. Half width at half maximum
+		/// \return Random number
+		double Cauchy(double location, double scale);
+
+		/// \brief Fill an array from a uniform distribution [min, max)
+		void FillUniform(double* pOut, size_t count, double min, double max);
+
+		/// \brief Fill an array from a normal distribution (mean, std)
+		void FillNormal(double* pOut, size_t count, double mean, double std);
+
+		/// \brief Fill an array with integers from the uniform distribution [min, max)
+		void FillInt(int* pOut, size_t count, int min, int max);
+
+		/// \brief Fill an array with random bits
+		void FillBits(uint64_t* pOut, size_t count);
+
+		/// \brief Fill a bitmask in which every bit is set independently with a given
+		///        probability. Bit k is bit (k % 64) of word k / 64; unused bits are cleared.
+		/// \param[out] pMask. At least (numBits + 63) / 64 words
+		/// \param[in] numBits. Number of bits
+		/// \param[in] prob. Probability of a bit being set
+		void FillBernoulliMask(uint64_t* pMask, size_t numBits, double prob);
+
+		/// \brief Save the generator state
+		/// \param[out] pState. StateSize words
+		void GetState(uint64_t* pState) const;
+
+		/// \brief Restore a state saved by GetState
+		/// \param[in] pState. StateSize words
+		void SetState(const uint64_t* pState);
+
+		// UniformRandomBitGenerator interface
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return ~static_cast<result_type>(0); }
+		inline result_type operator()() { return Next(); }
+
+	private:
+		static inline uint64_t RotateLeft(const uint64_t x, int k)
+		{
+			return (x << k) | (x >> (64 - k));
+		}
+
+	private:
+		uint64_t m_state[4];
+		double   m_spareNormal;     // Second value of the last Box-Muller pair
+		bool     m_hasSpareNormal;
+	};
+}
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef EC_RestartPortfolio_Hpp
+#define EC_RestartPortfolio_Hpp
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "BaseEvolver.hpp"
+#include "RealCodedIndividual.hpp"
+#include "StopCriteria.hpp"
+
+
+namespace EC
+{
+	/// \brief How the population size changes from one restart to the next
+	enum RestartStrategy
+	{
+		RESTART_IPOP  = 0,  // Every run has a larger population than the one before
+		RESTART_BIPOP = 1   // Larger and larger runs interleaved with small, local ones
+	};
+
+
+	/// \brief Settings and outcome of one run of a RestartPortfolio
+	struct RestartRun
+	{
+		unsigned int        index;            // Launch order, from 0
+		bool                isSmall;          // BIPOP small-population run
+		unsigned int        populationSize;
+		double              stepSize;         // Initial step size, relative to the domain width
+		unsigned long long  maxEvaluations;   // Budget of the run. 0 if unlimited.
+		unsigned long long  seed;
+
+		// Outcome, set when the run ends
+		double              bestFitness;
+		unsigned long long  numEvaluations;
+		unsigned int        numGenerations;
+		StopReason          stopReason;
+		bool                isDominated;      // Stopped by the portfolio, see SetDominance
+	};
+
+
+	/// \brief Runs independent restarts of an evolver in parallel, with growing population
+	///        sizes, and keeps the best solution.
+	///
+	///  Auger, A. and Hansen, N. "A Restart CMA Evolution Strategy With Increasing
+	///  Population Size." IEEE CEC, 1769-1776, 2005.
+	///  Hansen, N. "Benchmarking a BI-Population CMA-ES on the BBOB-2009 Function Testbed."
+	///  GECCO Workshops, 2389-2396, 2009.
+	///
+	/// \details  Every thread launches a run, lets it go until it stops on its own criteria
+	///           (for CMA-ES, a collapsed step size), then launches the next one. With
+	///           IPOP, run k has populationSize * factor^k individuals. With BIPOP, the
+	///           next run is a large one, the next step of the IPOP sequence, or a small one,
+	///           whichever regime has spent fewer evaluations; until a large run has
+	///           finished, all runs are large. A small run has a random population between
+	///           populationSize and half the last large one, a random smaller step size, and
+	///           at most half the evaluations of the last large run.
+	///
+	///           Run k is seeded with stream k of the portfolio's seed. With one thread the
+	///           whole portfolio is bit-reproducible; with more, the regimes chosen by BIPOP
+	///           and the runs killed depend on timing.
+	///
+	///           All runs share the best solution found. A run that has gone on for
+	///           SetDominance times as many generations as the best run needed to find it,
+	///           without matching it, is stopped early. The portfolio stops when the
+	///           evaluation budget, time limit or number of runs is spent, or the target
+	///           fitness is reached: running runs are cancelled within one block of
+	///           evaluations.
+	///
+	///           The evolvers are CMAEvolutionStrategy by default. The fitness functor is
+	///           shared by all threads and must be thread-safe.
+	class RestartPortfolio
+	{
+	public:
+		/// \brief Create the evolver of a run. It is seeded, set to one thread and given
+		///        its stop criteria by the portfolio, which then owns it.
+		typedef std::function<BaseEvolver<double, double>*(const RestartRun& run)> EvolverFactory;
+
+		/// \brief Constructor
+		/// \param[in] strategy. How the population size changes across restarts
+		RestartPortfolio(RestartStrategy strategy = RESTART_IPOP);
+		virtual ~RestartPortfolio();
+
+		/// \brief Set how the evolvers are created. Their own stop criteria end the runs,
+		///        e.g. stagnation for DifferentialEvolution. An empty factory restores
+		///        the default CMAEvolutionStrategy.
+		/// \param[in] factory. Factory
+		void SetEvolverFactory(const EvolverFactory& factory);
+
+		/// \brief Set the growth of the population size from one large run to the next
+		/// \param[in] factor. Factor, at least 1. default 2
+		void SetPopulationFactor(double factor);
+
+		/// \brief Set the initial step size of the runs, before the BIPOP reduction
+		/// \param[in] stepSize. Relative to the width of the domain. default 0.3
+		void SetInitialStepSize(double stepSize);
+
+		/// \brief Set the total evaluation budget, over all runs. It can be exceeded by
+		///        one block of evaluations per running run.
+		/// \param[in] maxEvaluations. Budget. 0 disables it.
+		void SetMaxEvaluations(unsigned long long maxEvaluations);
+
+		/// \brief Set the wall-clock budget of Evolve
+		/// \param[in] seconds. Time limit. 0 disables it.
+		void SetTimeLimit(double seconds);
+
+		/// \brief Set the maximum number of runs launched
+		/// \param[in] maxRuns. Number of runs. 0 for no limit.
+		inline void SetMaxRuns(unsigned int maxRuns)
+		{
+			m_maxRuns = maxRuns;
+		}
+
+		/// \brief Stop everything once the best fitness is not larger than a target
+		/// \param[in] targetFitness. Target
+		void SetTargetFitness(double targetFitness);
+
+		/// \brief Set when a run is dominated: it has run factor times the generations the
+		///        best run took to find the best solution, and at least minGenerations,
+		///        without doing as well.
+		/// \param[in] factor. Factor. 0 disables the check. default 3
+		/// \param[in] minGenerations. Generations a run is always given. default 100
+		void SetDominance(double factor, unsigned int minGenerations = 100);
+
+		/// \brief Set the number of runs going in parallel
+		/// \param[in] numThreads. 1 runs them one after the other, 0 uses all cores (default)
+		inline void SetNumThreads(unsigned int numThreads)
+		{
+			m_numThreads = numThreads;
+		}
+
+		/// \brief Seed the runs. Run k gets an independent stream of this seed.
+		/// \param[in] seed. Seed
+		inline void SetSeed(unsigned long long seed)
+		{
+			m_seed = seed;
+		}
+
+		/// \brief Run restarts until a budget is spent. At least one of the evaluation
+		///        budget, time limit and maximum number of runs must be set.
+		/// \param[in] populationSize. Population of the first run. 0 chooses the CMA-ES
+		///            default 4 + 3 ln(n).
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		/// \param[in] pFitnessFunc. Functor for fitness evaluation, shared by all threads
+		/// \param[in] verbose. If true, show every run and a summary. default false
+		void Evolve(
+			unsigned int populationSize,
+			std::vector<double>& lowerBound,
+			std::vector<double>& upperBound,
+			BaseFitnessFunctor<double, double>* pFitnessFunc,
+			bool verbose=false);
+
+		/// \brief Get the best individual over all runs
+		/// \return the best individual
+		BaseIndividual<double, double>* GetElite();
+
+		/// \brief Get the runs launched by the last Evolve
+		/// \return Runs, in launch order
+		inline const std::vector<RestartRun>& GetRuns() const
+		{
+			return m_runs;
+		}
+
+		/// \brief Get the number of runs stopped because they were dominated
+		/// \return Number of runs
+		inline unsigned int GetNumDominatedRuns() const
+		{
+			return m_numDominatedRuns;
+		}
+
+		/// \brief Get the number of fitness evaluations over all runs
+		/// \return Number of evaluations
+		inline unsigned long long GetNumEvaluations() const
+		{
+			return m_numEvaluations;
+		}
+
+		/// \brief Get why the last Evolve stopped
+		/// \return Reason. STOP_MAX_GENERATION when the maximum number of runs was done.
+		inline StopReason GetStopReason() const
+		{
+			return m_stopReason;
+		}
+
+	private:
+		RestartPortfolio(const RestartPortfolio&);
+		RestartPortfolio& operator =(const RestartPortfolio&);
+
+		typedef std::chrono::steady_clock Clock;
+
+		/// \brief Stop condition attached to every run: accounts its evaluations, publishes
+		///        its best solution and stops it when dominated
+		class RunMonitor : public StopCondition
+		{
+		public:
+			RunMonitor(RestartPortfolio* pPortfolio, unsigned int run, bool isSmall, BaseEvolver<double, double>* pEvolver);
+
+			virtual bool Check(const GenerationStatistics& record);
+
+			/// \brief Account the evaluations and the population not seen by Check
+			void Finish();
+
+			inline double GetBestFitness() const
+			{
+				return m_bestFitness;
+			}
+
+			inline bool IsDominated() const
+			{
+				return m_isDominated;
+			}
+
+		private:
+			RestartPortfolio*            m_pPortfolio;
+			unsigned int                 m_run;
+			bool                         m_isSmall;
+			BaseEvolver<double, double>* m_pEvolver;
+			unsigned long long           m_numEvaluations;  // Already added to the portfolio
+			double                       m_bestFitness;
+			bool                         m_isDominated;
+		};
+
+		/// \brief Main loop of one thread
+		void RunThread();
+
+		/// \brief Choose the settings of the next run
+		/// \param[out] run. Index of the run
+		/// \return False if no more runs should be launched
+		bool LaunchRun(unsigned int& run);
+
+		/// \brief Create, run and release the evolver of a run
+		/// \param[in] run. Index of the run
+		void RunEvolver(unsigned int run);
+
+		/// \brief Add the evaluations of a run to the budget
+		/// \param[in] isSmall. Regime of the run
+		/// \param[in] numEvaluations. New evaluations
+		void AddEvaluations(bool isSmall, unsigned long long numEvaluations);
+
+		/// \brief Make the best of a run's population the global best, if it is better
+		/// \param[in] run. Index of the run
+		/// \param[in] pEvolver. Evolver of the run
+		/// \param[in] generation. Generation of the run
+		void Publish(unsigned int run, BaseEvolver<double, double>* pEvolver, unsigned int generation);
+
+		/// \brief Check whether a run can't catch up with the best one
+		/// \param[in] run. Index of the run
+		/// \param[in] bestFitness. Best fitness of the run
+		/// \param[in] generation. Generation of the run
+		bool IsDominated(unsigned int run, double bestFitness, unsigned int generation);
+
+	private:
+		RestartStrategy     m_strategy;
+		EvolverFactory      m_factory;
+		double              m_populationFactor;
+		double              m_initialStepSize;
+		unsigned long long  m_maxEvaluations;
+		double              m_timeLimit;
+		unsigned int        m_maxRuns;
+		bool                m_hasTargetFitness;
+		double              m_targetFitness;
+		double              m_dominanceFactor;
+		unsigned int        m_dominanceMinGenerations;
+		unsigned int        m_numThreads;
+		unsigned long long  m_seed;
+
+		// Problem
+		BaseFitnessFunctor<double, double>* m_pFitnessFunc;
+		std::vector<double> m_lowerBound;
+		std::vector<double> m_upperBound;
+		unsigned int        m_populationSize;
+		bool                m_verbose;
+
+		// Schedule, guarded by m_mutex
+		std::mutex                m_mutex;
+		std::vector<RestartRun>   m_runs;
+		unsigned int              m_numLargeRuns;
+		unsigned int              m_numSmallRuns;
+		unsigned int              m_largePopulation;     // Of the last large run launched
+		unsigned long long        m_largeRunEvaluations; // Of the last large run finished
+		unsigned int              m_numDominatedRuns;
+
+		// Budget, updated by the runs every generation
+		std::atomic<unsigned long long> m_numEvaluations;
+		std::atomic<unsigned long long> m_regimeEvaluations[2];  // Large, small
+		Clock::time_point               m_deadline;
+		CancellationToken               m_token;
+		StopReason                      m_stopReason;
+
+		// Best solution, guarded by m_eliteMutex
+		std::mutex            m_eliteMutex;
+		std::atomic<double>   m_bestFitness;
+		unsigned int          m_bestRun;
+		unsigned int          m_bestGeneration;     // Generation of m_bestRun that found it
+		bool                  m_isTargetReached;
+		RealCodedIndividual*  m_pElite;
+	};
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef EC_SimdKernels_Hpp
+#define EC_SimdKernels_Hpp
+
+#include <stdint.h>
+#include "CpuFeatures.hpp"
+
+
+namespace EC
+{
+	/// \brief Vectorized kernels on row-major blocks of chromosomes. Each kernel picks
+	///        the best code path for the running CPU (see GetSimdLevel).
+	namespace SimdKernels
+	{
+		/// \brief Sum of squares of each row: out[i] = sum_j x[i][j]^2
+		/// \param[in] pRows. First element of the first row
+		/// \param[in] numRows. Number of rows
+		/// \param[in] length. Number of elements per row
+		/// \param[in] stride. Distance between two consecutive rows
+		/// \param[out] pOut. One result per row
+		void SumOfSquaresBatch(
+			const double* pRows,
+			unsigned int numRows,
+			unsigned int length,
+			unsigned int stride,
+			double* pOut);
+
+		/// \brief Rosenbrock function of each row:
+		///        out[i] = sum_j 100 * (x[i][j+1] - x[i][j]^2)^2 + (1 - x[i][j])^2, j < length - 1
+		/// \param[in] pRows. First element of the first row
+		/// \param[in] numRows. Number of rows
+		/// \param[in] length. Number of elements per row
+		/// \param[in] stride. Distance between two consecutive rows
+		/// \param[out] pOut. One result per row
+		void RosenbrockBatch(
+			const double* pRows,
+			unsigned int numRows,
+			unsigned int length,
+			unsigned int stride,
+			double* pOut);
+
+		/// \brief DE rand/1/bin trial generation. Gene j of the trial is the donor
+		///        x0[j] + weight * (x1[j] - x2[j]) if bit j of the crossover mask is set,
+		///        the target gene otherwise.
+		/// \param[in] pTarget. Target vector
+		/// \param[in] pX0. Base vector
+		/// \param[in] pX1. First difference vector
+		/// \param[in] pX2. Second difference vector
+		/// \param[in] pMask. Crossover mask, bit j is bit (j % 64) of word j / 64
+		/// \param[in] length. Number of genes
+		/// \param[in] weight. Differential weight
+		/// \param[out] pTrial. Trial vector
+		void DifferentialTrial(
+			const double* pTarget,
+			const double* pX0,
+			const double* pX1,
+			const double* pX2,
+			const uint64_t* pMask,
+			unsigned int length,
+			double weight,
+			double* pTrial);
+	}
+}
+
+#endif
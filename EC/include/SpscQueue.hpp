@@ -0,0 +1,110 @@
+#ifndef EC_SpscQueue_Hpp
+#define EC_SpscQueue_Hpp
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+
+namespace EC
+{
+	/// \brief Bounded lock-free queue for exactly one producer thread and one consumer thread.
+	///
+	/// \details  Slots are allocated once. Elements are copied into and out of the slots, so
+	///           element types holding buffers (e.g. std::vector) stop allocating once every
+	///           slot has reached its final capacity.
+	template<typename T>
+	class SpscQueue
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] capacity. Maximum number of queued elements
+		SpscQueue(size_t capacity);
+
+		/// \brief Add an element. Producer thread only.
+		/// \param[in] value. Element to add
+		/// \return False if the queue is full; the element is dropped
+		bool TryPush(const T& value);
+
+		/// \brief Remove the oldest element. Consumer thread only.
+		/// \param[out] value. Removed element
+		/// \return False if the queue is empty
+		bool TryPop(T& value);
+
+		/// \brief Get the maximum number of queued elements
+		/// \return Capacity
+		inline size_t GetCapacity() const
+		{
+			return m_slots.size() - 1;
+		}
+
+		/// \brief Get an estimate of the number of queued elements
+		/// \return Number of elements
+		inline size_t Size() const
+		{
+			size_t head = m_head.load(std::memory_order_acquire);
+			size_t tail = m_tail.load(std::memory_order_acquire);
+			return (tail + m_slots.size() - head) % m_slots.size();
+		}
+
+	private:
+		SpscQueue(const SpscQueue&);
+		SpscQueue& operator =(const SpscQueue&);
+
+	private:
+		std::vector<T> m_slots;           // One slot is kept empty to tell full from empty
+
+		// Head and tail are padded apart: they are written by different threads
+		char                m_padding0[64];
+		std::atomic<size_t> m_head;       // Next slot to pop, written by the consumer
+		char                m_padding1[64];
+		std::atomic<size_t> m_tail;       // Next slot to push, written by the producer
+		char                m_padding2[64];
+	};
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+EC::SpscQueue<T>::SpscQueue(size_t capacity)
+	: m_slots(capacity + 1), m_head(0), m_tail(0)
+{
+	if (capacity == 0)
+	{
+		throw std::invalid_argument("received non-positive capacity");
+	}
+}
+
+
+template<typename T>
+bool EC::SpscQueue<T>::TryPush(const T& value)
+{
+	size_t tail = m_tail.load(std::memory_order_relaxed);
+	size_t next = tail + 1 == m_slots.size() ? 0 : tail + 1;
+	if (next == m_head.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	m_slots[tail] = value;
+	m_tail.store(next, std::memory_order_release);
+	return true;
+}
+
+
+template<typename T>
+bool EC::SpscQueue<T>::TryPop(T& value)
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+	if (head == m_tail.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	value = m_slots[head];
+	m_head.store(head + 1 == m_slots.size() ? 0 : head + 1, std::memory_order_release);
+	return true;
+}
+
+#endif
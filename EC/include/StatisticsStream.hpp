@@ -0,0 +1,146 @@
+#ifndef EC_StatisticsStream_Hpp
+#define EC_StatisticsStream_Hpp
+
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "SpscQueue.hpp"
+
+
+namespace EC
+{
+	/// \brief Statistics of one generation, published by BaseEvolver::Step
+	struct GenerationStatistics
+	{
+		unsigned int       generation;       // Generation just completed, counted from 1
+		unsigned long long numEvaluations;   // Fitness evaluations since Initialize
+		double             bestFitness;      // Of the current population
+		double             meanFitness;
+		double             stdFitness;
+		double             diversity;        // Mean distance of the individuals to their centroid
+		double             breedSeconds;     // Includes evaluationSeconds
+		double             evaluationSeconds;
+		double             selectSeconds;
+		double             saveEliteSeconds;
+		double             elapsedSeconds;   // Since Start
+	};
+
+
+	/// \brief Destination of the statistics. Sinks are only called from the consumer thread
+	///        of a StatisticsStream, so they need not be thread-safe.
+	class StatisticsSink
+	{
+	public:
+		virtual ~StatisticsSink() { }
+
+		/// \brief Write one record
+		/// \param[in] record. Statistics of a generation
+		virtual void Write(const GenerationStatistics& record) = 0;
+
+		/// \brief Push buffered records out. Called whenever the stream runs empty.
+		virtual void Flush() { }
+	};
+
+
+	/// \brief Comma-separated values, one line per generation after a header line
+	class CsvStatisticsSink : public StatisticsSink
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] stream. Output, e.g. an std::ofstream. Not owned.
+		explicit CsvStatisticsSink(std::ostream& stream);
+
+		virtual void Write(const GenerationStatistics& record);
+		virtual void Flush();
+
+	private:
+		std::ostream& m_stream;
+		bool          m_hasHeader;
+	};
+
+
+	/// \brief One JSON object per line. Non-finite values are written as null.
+	class JsonLinesStatisticsSink : public StatisticsSink
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] stream. Output, e.g. an std::ofstream. Not owned.
+		explicit JsonLinesStatisticsSink(std::ostream& stream);
+
+		virtual void Write(const GenerationStatistics& record);
+		virtual void Flush();
+
+	private:
+		std::ostream& m_stream;
+	};
+
+
+	/// \brief Call a function for every record
+	class CallbackStatisticsSink : public StatisticsSink
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] callback. Called on the consumer thread of the stream
+		explicit CallbackStatisticsSink(const std::function<void(const GenerationStatistics&)>& callback);
+
+		virtual void Write(const GenerationStatistics& record);
+
+	private:
+		std::function<void(const GenerationStatistics&)> m_callback;
+	};
+
+
+	/// \brief Channel from one evolver to a set of sinks. Records go through a lock-free
+	///        ring buffer to a consumer thread that feeds the sinks, so Publish never blocks
+	///        and never does I/O. If the sinks fall behind and the ring is full, records are
+	///        dropped and counted.
+	class StatisticsStream
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] capacity. Records that can wait in the ring buffer
+		explicit StatisticsStream(size_t capacity = 1024);
+
+		/// \brief Destructor. Delivers the queued records, then stops the consumer thread.
+		~StatisticsStream();
+
+		/// \brief Add a sink. Must be called before the first Publish.
+		/// \param[in] pSink. Sink, not owned
+		void AddSink(StatisticsSink* pSink);
+
+		/// \brief Queue a record. Producer thread only.
+		/// \param[in] record. Statistics of a generation
+		/// \return False if the ring buffer was full and the record was dropped
+		bool Publish(const GenerationStatistics& record);
+
+		/// \brief Wait until every published record has been written and the sinks flushed
+		void Flush();
+
+		/// \brief Get the number of records dropped because the ring buffer was full
+		/// \return Number of dropped records
+		inline unsigned long long GetNumDropped() const
+		{
+			return m_numDropped.load(std::memory_order_relaxed);
+		}
+
+	private:
+		StatisticsStream(const StatisticsStream&);
+		StatisticsStream& operator =(const StatisticsStream&);
+
+		void Run();
+
+	private:
+		SpscQueue<GenerationStatistics> m_queue;
+		std::vector<StatisticsSink*>    m_sinks;
+		std::thread                     m_thread;       // Started by the first Publish
+
+		std::atomic<bool>               m_stop;
+		std::atomic<unsigned long long> m_numPublished;
+		std::atomic<unsigned long long> m_numFlushed;   // Records written and flushed
+		std::atomic<unsigned long long> m_numDropped;
+	};
+}
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef EC_StopCriteria_Hpp
+#define EC_StopCriteria_Hpp
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "StatisticsStream.hpp"
+
+
+namespace EC
+{
+	/// \brief Why a run stopped
+	enum StopReason
+	{
+		STOP_NONE               = 0,  // Still running
+		STOP_MAX_GENERATION     = 1,  // The evolver's own criterion, e.g. the maximum generation
+		STOP_TARGET_FITNESS     = 2,  // The best fitness reached the target
+		STOP_STAGNATION         = 3,  // No improvement over the given number of generations
+		STOP_DIVERSITY_COLLAPSE = 4,  // The population shrank to a point
+		STOP_MAX_EVALUATIONS    = 5,  // The evaluation budget is spent
+		STOP_DEADLINE           = 6,  // The wall-clock deadline passed
+		STOP_CANCELLED          = 7,  // A CancellationToken was cancelled
+		STOP_CUSTOM             = 8   // A StopCondition added by the user
+	};
+
+	/// \brief Get the name of a stop reason, e.g. for logs
+	/// \param[in] reason. Stop reason
+	/// \return Static string
+	const char* GetStopReasonName(StopReason reason);
+
+
+	/// \brief Cooperative cancellation. Cancel may be called from any thread; the evolver
+	///        notices it before the next block of evaluations and stops after the
+	///        generation in progress.
+	class CancellationToken
+	{
+	public:
+		CancellationToken() : m_isCancelled(false) { }
+
+		inline void Cancel()
+		{
+			m_isCancelled.store(true, std::memory_order_relaxed);
+		}
+
+		inline bool IsCancelled() const
+		{
+			return m_isCancelled.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Clear the token, to reuse it for another run
+		inline void Reset()
+		{
+			m_isCancelled.store(false, std::memory_order_relaxed);
+		}
+
+	private:
+		CancellationToken(const CancellationToken&);
+		CancellationToken& operator =(const CancellationToken&);
+
+	private:
+		std::atomic<bool> m_isCancelled;
+	};
+
+
+	/// \brief User-defined stop condition, checked once per generation
+	class StopCondition
+	{
+	public:
+		virtual ~StopCondition() { }
+
+		/// \brief Called when a run starts
+		virtual void Reset() { }
+
+		/// \brief Check the condition
+		/// \param[in] record. Statistics of the generation just completed
+		/// \return True to stop
+		virtual bool Check(const GenerationStatistics& record) = 0;
+	};
+
+
+	/// \brief Set of stop conditions checked by BaseEvolver::Evolve, in addition to the
+	///        evolver's own maximum generation. The run stops at the first condition met.
+	///
+	/// \details  Target fitness, stagnation, diversity collapse and custom conditions are
+	///           checked between generations, on the population statistics. The evaluation
+	///           budget, deadline and cancellation token are also polled between blocks of
+	///           evaluations: once one of them is met, the remaining individuals of the
+	///           generation aren't evaluated and get the worst possible fitness, so a
+	///           request returns within one block of evaluations.
+	class StopCriteria
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		StopCriteria();
+
+		/// \brief Stop once the best fitness is not larger than a target
+		/// \param[in] targetFitness. Target
+		void SetTargetFitness(double targetFitness);
+
+		/// \brief Stop when the best fitness hasn't improved by more than a tolerance over
+		///        a number of generations
+		/// \param[in] numGenerations. Generations without improvement. 0 disables the check.
+		/// \param[in] tolerance. Smallest improvement that counts
+		void SetStagnation(unsigned int numGenerations, double tolerance = 0);
+
+		/// \brief Stop when the diversity (mean distance of the individuals to their
+		///        centroid) drops below a threshold
+		/// \param[in] minDiversity. Threshold. 0 disables the check.
+		void SetMinDiversity(double minDiversity);
+
+		/// \brief Stop after a number of fitness evaluations, as counted by
+		///        BaseEvolver::GetNumEvaluations
+		/// \param[in] maxEvaluations. Budget. 0 disables the check.
+		void SetMaxEvaluations(unsigned long long maxEvaluations);
+
+		/// \brief Stop once a run has been going for a given time, counting from Start
+		/// \param[in] seconds. Time limit. 0 disables the check.
+		void SetTimeLimit(double seconds);
+
+		/// \brief Stop at a point in time
+		/// \param[in] deadline. Deadline
+		void SetDeadline(Clock::time_point deadline);
+
+		/// \brief Stop when a token is cancelled
+		/// \param[in] pToken. Token, not owned. NULL disables the check.
+		void SetCancellationToken(const CancellationToken* pToken);
+
+		/// \brief Add a user-defined condition
+		/// \param[in] pCondition. Condition, not owned
+		void AddCondition(StopCondition* pCondition);
+
+		/// \brief Remove every condition
+		void Clear();
+
+		/// \brief Called by the evolver when a run starts
+		/// \param[in] startTime. Start of the run, origin of the time limit
+		void Start(Clock::time_point startTime);
+
+		/// \brief Check whether the generation-level conditions need the population
+		///        statistics (best fitness and diversity)
+		inline bool NeedsStatistics() const
+		{
+			return m_hasTargetFitness || m_stagnationGenerations > 0 || m_minDiversity > 0 ||
+				!m_conditions.empty();
+		}
+
+		/// \brief Check whether any condition must be polled during evaluations
+		inline bool IsInterruptible() const
+		{
+			return m_maxEvaluations > 0 || m_hasDeadline || m_pToken != NULL;
+		}
+
+		/// \brief Poll the evaluation budget, deadline and token. Safe to call from the
+		///        evaluating threads concurrently.
+		/// \param[in] numEvaluations. Evaluations done so far
+		/// \return True to stop
+		bool Poll(unsigned long long numEvaluations);
+
+		/// \brief Check every condition after a generation. Not concurrent with Poll.
+		/// \param[in] record. Statistics of the generation; best fitness and diversity
+		///            only need to be set if NeedsStatistics
+		/// \return The reason to stop, STOP_NONE to go on
+		StopReason Check(const GenerationStatistics& record);
+
+		/// \brief Get the evaluation budget
+		/// \return Budget, 0 if unset
+		inline unsigned long long GetMaxEvaluations() const
+		{
+			return m_maxEvaluations;
+		}
+
+		/// \brief Get the deadline of the current run, the earlier of the fixed deadline
+		///        and the time limit counted from Start
+		/// \param[out] deadline. Deadline, if any
+		/// \return False if the run has no deadline
+		inline bool GetDeadline(Clock::time_point& deadline) const
+		{
+			deadline = m_deadline;
+			return m_hasDeadline;
+		}
+
+		/// \brief Get the cancellation token
+		/// \return Token, NULL if unset
+		inline const CancellationToken* GetCancellationToken() const
+		{
+			return m_pToken;
+		}
+
+		/// \brief Get the reason found by the last Poll or Check
+		inline StopReason GetReason() const
+		{
+			return static_cast<StopReason>(m_reason.load(std::memory_order_relaxed));
+		}
+
+	private:
+		StopCriteria(const StopCriteria&);
+		StopCriteria& operator =(const StopCriteria&);
+
+		/// \brief Record the first reason found
+		void Latch(StopReason reason);
+
+	private:
+		bool               m_hasTargetFitness;
+		double             m_targetFitness;
+		unsigned int       m_stagnationGenerations;
+		double             m_stagnationTolerance;
+		double             m_minDiversity;
+		unsigned long long m_maxEvaluations;
+		double             m_timeLimit;          // Seconds, 0 if unset
+		bool               m_hasFixedDeadline;
+		Clock::time_point  m_fixedDeadline;
+		const CancellationToken*    m_pToken;
+		std::vector<StopCondition*> m_conditions;
+
+		// State of the run
+		bool               m_hasDeadline;
+		Clock::time_point  m_deadline;           // Earlier of the fixed deadline and the time limit
+		bool               m_hasBestFitness;
+		double             m_bestFitness;        // Best seen by the stagnation check
+		unsigned int       m_bestGeneration;     // When it last improved
+		std::atomic<int>   m_reason;
+	};
+}
+
+#endif
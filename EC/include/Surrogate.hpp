@@ -0,0 +1,117 @@
+#ifndef EC_Surrogate_Hpp
+#define EC_Surrogate_Hpp
+
+#include <vector>
+
+
+namespace EC
+{
+	/// \brief Cheap model of the fitness function, trained on the points evaluated so far.
+	///        Used by DifferentialEvolution to screen trials before the true evaluation.
+	class BaseSurrogate
+	{
+	public:
+		virtual ~BaseSurrogate() { }
+
+		/// \brief Forget every point and set the domain
+		/// \param[in] lowerBound. Domain lower bound
+		/// \param[in] upperBound. Domain upper bound
+		virtual void Reset(const std::vector<double>& lowerBound, const std::vector<double>& upperBound) = 0;
+
+		/// \brief Add an evaluated point
+		/// \param[in] pGenes. Chromosome
+		/// \param[in] fitness. True fitness
+		virtual void Add(const double* pGenes, double fitness) = 0;
+
+		/// \brief Predict the fitness of a point
+		/// \param[in] pGenes. Chromosome
+		/// \param[out] mean. Predicted fitness
+		/// \param[out] std. Uncertainty of the prediction, 0 if the model has none
+		virtual void Predict(const double* pGenes, double& mean, double& std) = 0;
+
+		/// \brief Get the number of points the model is trained on
+		virtual unsigned int Size() const = 0;
+	};
+
+
+	/// \brief Ordinary kriging with a Gaussian kernel on the most recent evaluated points.
+	///
+	/// \details  Genes are scaled to the unit box of the domain. The Cholesky factor of the
+	///           kernel matrix grows by one row per point added, in O(n^2), so the model is
+	///           refit incrementally. It is rebuilt from scratch, with a new length scale,
+	///           when the number of points has doubled since the last rebuild and when the
+	///           capacity is reached, in which case the oldest half of the points is dropped.
+	///           The length scale follows the mean distance between nearest neighbours, so
+	///           the model gets more local as the population converges. Points too close to
+	///           the existing ones to add information are skipped.
+	class KrigingSurrogate : public BaseSurrogate
+	{
+	public:
+		/// \brief Constructor
+		/// \param[in] capacity. Maximum number of points kept, at least 2
+		explicit KrigingSurrogate(unsigned int capacity = 256);
+		virtual ~KrigingSurrogate();
+
+		virtual void Reset(const std::vector<double>& lowerBound, const std::vector<double>& upperBound);
+		virtual void Add(const double* pGenes, double fitness);
+		virtual void Predict(const double* pGenes, double& mean, double& std);
+
+		virtual unsigned int Size() const
+		{
+			return m_size;
+		}
+
+		/// \brief Get the length scale of the kernel, in units of the domain width
+		inline double GetLengthScale() const
+		{
+			return m_lengthScale;
+		}
+
+	private:
+		KrigingSurrogate(const KrigingSurrogate&);
+		KrigingSurrogate& operator =(const KrigingSurrogate&);
+
+		/// \brief Append a scaled point to the factorization
+		/// \return False if the point is too close to the existing ones
+		bool Append(const double* pPoint, double fitness);
+
+		/// \brief Rebuild the factorization from the newest points
+		/// \param[in] numKept. Number of points to keep
+		void Rebuild(unsigned int numKept);
+
+		/// \brief Solve the kriging weights after points were added
+		void Solve();
+
+		/// \brief Kernel between two scaled points
+		double Kernel(const double* pA, const double* pB) const;
+
+		/// \brief Solve L x = b in place
+		void ForwardSubstitution(double* pB) const;
+
+		/// \brief Solve L^T x = b in place
+		void BackSubstitution(double* pB) const;
+
+	private:
+		unsigned int        m_capacity;
+		unsigned int        m_dimension;
+		std::vector<double> m_lowerBound;
+		std::vector<double> m_scale;         // 1 / domain width, per gene
+
+		unsigned int        m_size;
+		unsigned int        m_sizeAtRebuild;
+		std::vector<double> m_points;        // m_capacity rows of scaled genes
+		std::vector<double> m_fitness;
+		std::vector<double> m_cholesky;      // Lower factor, m_capacity x m_capacity
+		double              m_lengthScale;
+
+		// Kriging weights, solved lazily
+		bool                m_isSolved;
+		double              m_mean;          // Estimated constant mean
+		double              m_variance;      // Estimated process variance
+		std::vector<double> m_weights;       // K^-1 (y - mean)
+		std::vector<double> m_work;
+		std::vector<double> m_scaledPoint;
+	};
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef EC_ThreadPool_Hpp
+#define EC_ThreadPool_Hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace EC
+{
+	/// \brief A fixed-size pool of worker threads for data-parallel loops.
+	///
+	/// \details  The calling thread takes part in the work as thread 0, so a pool of
+	///           N threads starts N-1 workers. Chunks of the index range are claimed
+	///           dynamically, which balances uneven per-item costs.
+	class ThreadPool
+	{
+	public:
+		/// \brief Signature of a loop body: func(begin, end, threadIndex) handles [begin, end).
+		typedef std::function<void(unsigned int, unsigned int, unsigned int)> RangeFunction;
+
+		/// \brief Constructor
+		/// \param[in] numThreads. Total number of threads including the caller.
+		///            0 means one thread per hardware core.
+		ThreadPool(unsigned int numThreads = 0);
+		virtual ~ThreadPool();
+
+		/// \brief Get the number of threads, including the calling thread
+		/// \return Number of threads
+		inline unsigned int GetNumThreads() const
+		{
+			return static_cast<unsigned int>(m_workers.size()) + 1;
+		}
+
+		/// \brief Run a loop body over [0, count) in parallel and wait for completion.
+		///        The first exception thrown by the body is rethrown in the caller.
+		/// \param[in] count. Number of items
+		/// \param[in] chunkSize. Number of items claimed at a time. 0 chooses automatically.
+		/// \param[in] func. Loop body
+		void ParallelFor(unsigned int count, unsigned int chunkSize, const RangeFunction& func);
+
+	private:
+		ThreadPool(const ThreadPool&);
+		ThreadPool& operator =(const ThreadPool&);
+
+		void WorkerLoop(unsigned int threadIndex);
+		void RunChunks(unsigned int threadIndex);
+
+	private:
+		std::vector<std::thread>  m_workers;
+
+		std::mutex                m_jobMutex;    // Serializes ParallelFor calls
+		std::mutex                m_mutex;
+		std::condition_variable   m_startCondition;
+		std::condition_variable   m_doneCondition;
+
+		const RangeFunction*      m_pFunc;
+		unsigned int              m_count;
+		unsigned int              m_chunkSize;
+		std::atomic<unsigned int> m_nextIndex;
+		unsigned int              m_jobId;
+		unsigned int              m_activeWorkers;
+		bool                      m_stop;
+		std::exception_ptr        m_exception;
+	};
+}
+
+#endif
@@ -0,0 +1,201 @@
+#include "../include/AsyncDifferentialEvolution.hpp"
+#include "../include/ContiguousPopulation.hpp"
+#include "../include/SimdKernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+
+EC::AsyncDifferentialEvolution::AsyncDifferentialEvolution()
+	: m_pRowLocks(NULL), m_pIsTargetBusy(NULL), m_numRowLocks(0), m_nextTarget(0), m_remainingTrials(0)
+{ }
+
+
+EC::AsyncDifferentialEvolution::~AsyncDifferentialEvolution()
+{
+	delete[] m_pRowLocks;
+	delete[] m_pIsTargetBusy;
+}
+
+
+unsigned int EC::AsyncDifferentialEvolution::GetNumTrials(unsigned int target) const
+{
+	if (target >= m_numTrials.size())
+	{
+		throw std::out_of_range("Index out of bound");
+	}
+	return m_numTrials[target];
+}
+
+
+void EC::AsyncDifferentialEvolution::Evolve(unsigned int maxGeneration, bool verbose)
+{
+	m_verbose = verbose;
+	m_maxGeneration = maxGeneration;
+
+	ContiguousPopulation<double, double>* pPopulation = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	if (pPopulation == NULL || pPopulation->Size() < 3)
+	{
+		throw std::runtime_error("Asynchronous DE needs a contiguous population of at least 3 individuals");
+	}
+	if (m_pFitnessFunc == NULL)
+	{
+		throw std::invalid_argument("Invalid fitness function");
+	}
+
+	m_stopReason = STOP_NONE;
+	m_startTime = std::chrono::steady_clock::now();
+	m_stopCriteria.Start(m_startTime);
+	Evaluate(m_pPopulation);
+
+	unsigned int popSize = pPopulation->Size();
+	ThreadPool* pPool = GetThreadPool();
+	unsigned int numThreads = pPool->GetNumThreads();
+
+	if (m_numRowLocks != popSize)
+	{
+		delete[] m_pRowLocks;
+		delete[] m_pIsTargetBusy;
+		m_pRowLocks = new std::mutex[popSize];
+		m_pIsTargetBusy = new std::atomic<bool>[popSize];
+		m_numRowLocks = popSize;
+	}
+
+	// Targets are handed out in turn; a busy flag keeps a target to one thread at a time
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		m_pIsTargetBusy[i] = false;
+	}
+	m_nextTarget = 0;
+	m_numTrials.assign(popSize, 0);
+	long long numTrials = static_cast<long long>(maxGeneration) * popSize;
+	m_remainingTrials = numTrials;
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	unsigned long long numEvaluations = m_numEvaluations;
+	pPool->ParallelFor(numThreads, 1,
+		[this](unsigned int, unsigned int, unsigned int threadIndex)
+		{
+			WorkerLoop(threadIndex);
+		});
+	// Fewer than numTrials if the stop criteria interrupted the run
+	unsigned long long numDone = m_numEvaluations - numEvaluations;
+	m_numPopulationEvaluations += numDone;
+	m_populationEvaluationTime += std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - startTime).count();
+	m_stopReason = m_stopCriteria.GetReason() != STOP_NONE ? m_stopCriteria.GetReason() : STOP_MAX_GENERATION;
+
+	m_generation += static_cast<unsigned int>(numDone / popSize);
+	// Individuals were replaced outside Select
+	ArchivePopulation();
+	SaveElite();
+	m_archive.Publish(m_generation);
+
+	if (verbose)
+	{
+		std::cout << "Trials: " << numDone 
+			<< ", per target: " << *std::min_element(m_numTrials.begin(), m_numTrials.end())
+			<< " to " << *std::max_element(m_numTrials.begin(), m_numTrials.end())
+			<< ", threads: " << numThreads << std::endl;
+	}
+}
+
+
+void EC::AsyncDifferentialEvolution::WorkerLoop(unsigned int threadIndex)
+{
+	ContiguousPopulation<double, double>* pPopulation = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	unsigned int popSize = pPopulation->Size();
+	unsigned int length = pPopulation->GetChromosomeLength();
+	unsigned int stride = pPopulation->GetStride();
+	size_t rowBytes = stride * sizeof(double);
+	double* pFitness = pPopulation->GetFitnessData();
+
+	// Private copies of the rows a trial is built from, allocated once per run
+	std::vector<double> rows(5 * static_cast<size_t>(stride));
+	double* pTarget = &rows[0];
+	double* pX0 = pTarget + stride;
+	double* pX1 = pX0 + stride;
+	double* pX2 = pX1 + stride;
+	double* pTrial = pX2 + stride;
+	double* pDonors[3] = { pX0, pX1, pX2 };
+	std::vector<uint64_t> mask((length + 63) / 64);
+	RandomGenerator& rng = GetThreadRandomGenerator(threadIndex);
+	bool isBounded = m_pFitnessFunc->SupportsBoundedEvaluation();
+
+	unsigned int task;
+	while (m_remainingTrials.load(std::memory_order_relaxed) > 0)
+	{
+		// The next target of the cycle that no other thread is working on
+		task = static_cast<unsigned int>(m_nextTarget.fetch_add(1, std::memory_order_relaxed) % popSize);
+		bool isIdle = false;
+		if (!m_pIsTargetBusy[task].compare_exchange_strong(isIdle, true, std::memory_order_acquire))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if (m_remainingTrials.fetch_sub(1) <= 0)
+		{
+			break;
+		}
+		if (m_stopCriteria.IsInterruptible() && m_stopCriteria.Poll(m_numEvaluations))
+		{
+			m_remainingTrials.store(0);
+			break;
+		}
+
+		// Three distinct donors, copied under their row locks one at a time
+		unsigned int donors[3];
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			bool isNew = false;
+			while (!isNew)
+			{
+				donors[k] = rng.NextInt(popSize);
+				isNew = true;
+				for (unsigned int m = 0; m < k; m++)
+				{
+					isNew = isNew && donors[m] != donors[k];
+				}
+			}
+			std::lock_guard<std::mutex> lock(m_pRowLocks[donors[k]]);
+			std::memcpy(pDonors[k], pPopulation->GetChromosome(donors[k]), rowBytes);
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_pRowLocks[task]);
+			std::memcpy(pTarget, pPopulation->GetChromosome(task), rowBytes);
+		}
+
+		rng.FillBernoulliMask(&mask[0], length, m_crossoverProb);
+		unsigned int randIndex = rng.NextInt(length);
+		mask[randIndex >> 6] |= static_cast<uint64_t>(1) << (randIndex & 63);
+		SimdKernels::DifferentialTrial(pTarget, pX0, pX1, pX2, &mask[0], length, m_diffWeight, pTrial);
+
+		// Only this thread owns the task, so its fitness can't change meanwhile
+		double fitness;
+		if (isBounded)
+		{
+			m_numAbortedEvaluations += m_pFitnessFunc->EvaluateBatchBounded(
+				pTrial, 1, length, stride, &pFitness[task], &fitness);
+		}
+		else
+		{
+			m_pFitnessFunc->EvaluateBatch(pTrial, 1, length, stride, &fitness);
+		}
+		m_numEvaluations++;
+		m_numTrials[task]++;
+
+		// Publish at once if better
+		if (fitness < pFitness[task])
+		{
+			std::lock_guard<std::mutex> lock(m_pRowLocks[task]);
+			std::memcpy(pPopulation->GetChromosome(task), pTrial, rowBytes);
+			pFitness[task] = fitness;
+		}
+		m_pIsTargetBusy[task].store(false, std::memory_order_release);
+	}
+}
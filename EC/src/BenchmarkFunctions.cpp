@@ -1,43 +1,393 @@
 #include "../include/BenchmarkFunctions.hpp"
+#include "../include/IndividualView.hpp"
+#include "../include/RandomGenerator.hpp"
+#include "../include/SimdKernels.hpp"
+#include <cmath>
+#include <cstddef>
 #include <stdexcept>
 
 
-EC::SphereFunctor::SphereFunctor() : m_problemDim(10)
-{ 
-	for (unsigned int i = 0; i < m_problemDim; i++)
+namespace
+{
+	const double Pi = 3.14159265358979323846;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// BenchmarkFunctor
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::BenchmarkFunctor::BenchmarkFunctor(unsigned int problemDim, double lowerBound, double upperBound)
+	: m_optimum(problemDim, 0), m_optimalFitness(0), m_problemDim(problemDim)
+{
+	if (problemDim == 0)
 	{
-		m_lowerBound.push_back(-5.12);
-		m_upperBound.push_back(5.12);
+		throw std::invalid_argument("received non-positive problem dimension");
 	}
+	SetDomain(lowerBound, upperBound);
 }
 
 
-EC::SphereFunctor::~SphereFunctor()
+EC::BenchmarkFunctor::~BenchmarkFunctor()
 { }
 
 
 /// \brief Calculate fitness of an individual. For single-objective optimization only.
 /// \param[in] pIndividual. A reference to an individual
-double EC::SphereFunctor::operator() (BaseIndividual<double, double>* pIndividual)
+double EC::BenchmarkFunctor::operator() (BaseIndividual<double, double>* pIndividual)
 {
 	if (pIndividual == NULL)
 	{
-		throw std::invalid_argument("Null pointer");	
+		throw std::invalid_argument("Null pointer");
+	}
+	CheckLength(pIndividual->Size());
+
+	// Views on contiguous storage are evaluated in place
+	IndividualView<double, double>* pView = dynamic_cast<IndividualView<double, double>*>(pIndividual);
+	if (pView != NULL)
+	{
+		return Evaluate(pView->GetData());
+	}
+
+	std::vector<double> genes(m_problemDim);
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		genes[i] = (*pIndividual)[i];
+	}
+	return Evaluate(&genes[0]);
+}
+
+
+void EC::BenchmarkFunctor::EvaluateBatch(
+	const double* pChromosomes,
+	unsigned int numIndiv,
+	unsigned int length,
+	unsigned int stride,
+	double* pFitness)
+{
+	CheckLength(length);
+	for (unsigned int i = 0; i < numIndiv; i++)
+	{
+		pFitness[i] = Evaluate(pChromosomes + static_cast<std::size_t>(i) * stride);
 	}
-	
-	if (pIndividual->Size() != m_problemDim)
+}
+
+
+void EC::BenchmarkFunctor::SetDomain(double lowerBound, double upperBound)
+{
+	if (!(lowerBound < upperBound))
+	{
+		throw std::invalid_argument("Lower bound should be smaller than upper bound");
+	}
+	m_lowerBound.assign(m_problemDim, lowerBound);
+	m_upperBound.assign(m_problemDim, upperBound);
+}
+
+
+void EC::BenchmarkFunctor::CheckLength(unsigned int length) const
+{
+	if (length != m_problemDim)
 	{
 		throw std::invalid_argument(
 			"The length of the individual should be equal to the problem dimension."
 			);
 	}
-	
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Sphere
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::SphereFunctor::SphereFunctor() : BenchmarkFunctor(10, -5.12, 5.12)
+{ }
+
+
+EC::SphereFunctor::SphereFunctor(unsigned int problemDim) : BenchmarkFunctor(problemDim, -5.12, 5.12)
+{ }
+
+
+EC::SphereFunctor::~SphereFunctor()
+{ }
+
+
+double EC::SphereFunctor::Evaluate(const double* x) const
+{
+	double sum;
+	SimdKernels::SumOfSquaresBatch(x, 1, m_problemDim, m_problemDim, &sum);
+	return sum;
+}
+
+
+void EC::SphereFunctor::EvaluateBatch(
+	const double* pChromosomes,
+	unsigned int numIndiv,
+	unsigned int length,
+	unsigned int stride,
+	double* pFitness)
+{
+	CheckLength(length);
+	SimdKernels::SumOfSquaresBatch(pChromosomes, numIndiv, length, stride, pFitness);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Rastrigin
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::RastriginFunctor::RastriginFunctor(unsigned int problemDim) : BenchmarkFunctor(problemDim, -5.12, 5.12)
+{ }
+
+
+EC::RastriginFunctor::~RastriginFunctor()
+{ }
+
+
+double EC::RastriginFunctor::Evaluate(const double* x) const
+{
+	double sum = 10.0 * m_problemDim;
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		sum += x[i] * x[i] - 10 * std::cos(2 * Pi * x[i]);
+	}
+	return sum;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Rosenbrock
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::RosenbrockFunctor::RosenbrockFunctor(unsigned int problemDim) : BenchmarkFunctor(problemDim, -2.048, 2.048)
+{
+	if (problemDim < 2)
+	{
+		throw std::invalid_argument("Rosenbrock function needs at least two dimensions");
+	}
+	m_optimum.assign(problemDim, 1);
+}
+
+
+EC::RosenbrockFunctor::~RosenbrockFunctor()
+{ }
+
+
+double EC::RosenbrockFunctor::Evaluate(const double* x) const
+{
+	double sum;
+	SimdKernels::RosenbrockBatch(x, 1, m_problemDim, m_problemDim, &sum);
+	return sum;
+}
+
+
+void EC::RosenbrockFunctor::EvaluateBatch(
+	const double* pChromosomes,
+	unsigned int numIndiv,
+	unsigned int length,
+	unsigned int stride,
+	double* pFitness)
+{
+	CheckLength(length);
+	SimdKernels::RosenbrockBatch(pChromosomes, numIndiv, length, stride, pFitness);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Ackley
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::AckleyFunctor::AckleyFunctor(unsigned int problemDim) : BenchmarkFunctor(problemDim, -32.768, 32.768)
+{ }
+
+
+EC::AckleyFunctor::~AckleyFunctor()
+{ }
+
+
+double EC::AckleyFunctor::Evaluate(const double* x) const
+{
+	double sumSquares = 0;
+	double sumCos = 0;
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		sumSquares += x[i] * x[i];
+		sumCos += std::cos(2 * Pi * x[i]);
+	}
+	double n = m_problemDim;
+	return -20 * std::exp(-0.2 * std::sqrt(sumSquares / n)) - std::exp(sumCos / n) + 20 + std::exp(1.0);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Griewank
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::GriewankFunctor::GriewankFunctor(unsigned int problemDim) : BenchmarkFunctor(problemDim, -600, 600)
+{ }
+
+
+EC::GriewankFunctor::~GriewankFunctor()
+{ }
+
+
+double EC::GriewankFunctor::Evaluate(const double* x) const
+{
 	double sum = 0;
+	double product = 1;
 	for (unsigned int i = 0; i < m_problemDim; i++)
 	{
-		double val = (*pIndividual)[i];
-		sum += val * val;
+		sum += x[i] * x[i];
+		product *= std::cos(x[i] / std::sqrt(i + 1.0));
 	}
+	return 1 + sum / 4000 - product;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Schwefel
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::SchwefelFunctor::SchwefelFunctor(unsigned int problemDim) : BenchmarkFunctor(problemDim, -500, 500)
+{
+	m_optimum.assign(problemDim, 420.9687460425061);
+}
+
 
+EC::SchwefelFunctor::~SchwefelFunctor()
+{ }
+
+
+double EC::SchwefelFunctor::Evaluate(const double* x) const
+{
+	// Constant chosen so that the minimum is 0 to double precision
+	double sum = 418.9828872724338 * m_problemDim;
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		sum -= x[i] * std::sin(std::sqrt(std::fabs(x[i])));
+	}
 	return sum;
 }
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Shifted and rotated
+///////////////////////////////////////////////////////////////////////////////////////////////////
+EC::ShiftedRotatedFunctor::ShiftedRotatedFunctor(BenchmarkFunctor* pBase, unsigned long long seed, bool rotate)
+	: BenchmarkFunctor(pBase == NULL ? 1 : pBase->GetProblemDim(), 0, 1), m_pBase(pBase)
+{
+	if (pBase == NULL)
+	{
+		throw std::invalid_argument("Null pointer");
+	}
+	m_lowerBound = pBase->GetDomainLowerBound();
+	m_upperBound = pBase->GetDomainUpperBound();
+	m_optimalFitness = pBase->GetOptimalFitness();
+
+	RandomGenerator randomGenerator(seed);
+	m_shift.resize(m_problemDim);
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		double center = (m_lowerBound[i] + m_upperBound[i]) / 2;
+		double radius = 0.4 * (m_upperBound[i] - m_lowerBound[i]);
+		m_shift[i] = randomGenerator.Uniform(center - radius, center + radius);
+	}
+	m_optimum = m_shift;
+
+	// Random orthogonal matrix: Gram-Schmidt on a Gaussian matrix
+	m_rotation.assign(static_cast<std::size_t>(m_problemDim) * m_problemDim, 0);
+	if (!rotate)
+	{
+		for (unsigned int i = 0; i < m_problemDim; i++)
+		{
+			m_rotation[i * m_problemDim + i] = 1;
+		}
+		return;
+	}
+	randomGenerator.FillNormal(&m_rotation[0], m_rotation.size(), 0, 1);
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		double* pRow = &m_rotation[i * m_problemDim];
+		for (unsigned int k = 0; k < i; k++)
+		{
+			const double* pPrevious = &m_rotation[k * m_problemDim];
+			double dot = 0;
+			for (unsigned int j = 0; j < m_problemDim; j++)
+			{
+				dot += pRow[j] * pPrevious[j];
+			}
+			for (unsigned int j = 0; j < m_problemDim; j++)
+			{
+				pRow[j] -= dot * pPrevious[j];
+			}
+		}
+		double norm = 0;
+		for (unsigned int j = 0; j < m_problemDim; j++)
+		{
+			norm += pRow[j] * pRow[j];
+		}
+		norm = std::sqrt(norm);
+		for (unsigned int j = 0; j < m_problemDim; j++)
+		{
+			pRow[j] /= norm;
+		}
+	}
+}
+
+
+EC::ShiftedRotatedFunctor::~ShiftedRotatedFunctor()
+{ }
+
+
+void EC::ShiftedRotatedFunctor::Transform(const double* x, double* z) const
+{
+	const std::vector<double>& baseOptimum = m_pBase->GetOptimum();
+	for (unsigned int i = 0; i < m_problemDim; i++)
+	{
+		const double* pRow = &m_rotation[i * m_problemDim];
+		double sum = 0;
+		for (unsigned int j = 0; j < m_problemDim; j++)
+		{
+			sum += pRow[j] * (x[j] - m_shift[j]);
+		}
+		z[i] = sum + baseOptimum[i];
+	}
+}
+
+
+double EC::ShiftedRotatedFunctor::Evaluate(const double* x) const
+{
+	std::vector<double> z(m_problemDim);
+	Transform(x, &z[0]);
+	return m_pBase->Evaluate(&z[0]);
+}
+
+
+void EC::ShiftedRotatedFunctor::EvaluateBatch(
+	const double* pChromosomes,
+	unsigned int numIndiv,
+	unsigned int length,
+	unsigned int stride,
+	double* pFitness)
+{
+	CheckLength(length);
+
+	// One buffer per thread, grown once. A nested call, from a base that is itself a
+	// ShiftedRotatedFunctor, can't reuse it while the outer call reads it: it gets its own.
+	static thread_local std::vector<double> threadBuffer;
+	static thread_local bool isThreadBufferInUse = false;
+	bool isNested = isThreadBufferInUse;
+	std::vector<double> nestedBuffer;
+	std::vector<double>& transformed = isNested ? nestedBuffer : threadBuffer;
+	if (transformed.size() < static_cast<std::size_t>(numIndiv) * m_problemDim)
+	{
+		transformed.resize(static_cast<std::size_t>(numIndiv) * m_problemDim);
+	}
+	for (unsigned int i = 0; i < numIndiv; i++)
+	{
+		Transform(pChromosomes + static_cast<std::size_t>(i) * stride, &transformed[static_cast<std::size_t>(i) * m_problemDim]);
+	}
+	isThreadBufferInUse = true;
+	try
+	{
+		m_pBase->EvaluateBatch(&transformed[0], numIndiv, m_problemDim, m_problemDim, pFitness);
+	}
+	catch (...)
+	{
+		isThreadBufferInUse = isNested;
+		throw;
+	}
+	isThreadBufferInUse = isNested;
+}
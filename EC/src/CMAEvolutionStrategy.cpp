@@ -0,0 +1,616 @@
+#include "../include/CMAEvolutionStrategy.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace
+{
+	const double MinStepSize = 1e-12;          // Relative to the domain width, along the longest axis
+	const double MaxConditionNumber = 1e14;
+	const double MinFitnessRange = 1e-12;      // Of the best fitness over the history
+	const unsigned int MaxJacobiSweeps = 50;
+}
+
+
+EC::CMAEvolutionStrategy::CMAEvolutionStrategy()
+	: m_pElite(NULL), m_isSeparable(false), m_initialStepSize(0.3), m_numParents(0), m_effectiveMu(0),
+	m_cumulationC(0), m_cumulationSigma(0), m_rankOneRate(0), m_rankMuRate(0), m_damping(0), m_expectedNorm(0),
+	m_isMeanSet(false), m_numUpdates(0), m_stepSize(0), m_evaluationsAtDecomposition(0), m_numDecompositions(0)
+{ }
+
+
+EC::CMAEvolutionStrategy::~CMAEvolutionStrategy()
+{
+	delete m_pElite;
+	delete m_pPopulation;
+	delete m_pOffsprings;
+}
+
+
+EC::BaseIndividual<double, double>* EC::CMAEvolutionStrategy::GetElite()
+{
+	return m_pElite;
+}
+
+
+void EC::CMAEvolutionStrategy::SetSeparable(bool isSeparable)
+{
+	m_isSeparable = isSeparable;
+}
+
+
+void EC::CMAEvolutionStrategy::SetInitialStepSize(double stepSize)
+{
+	if (!(stepSize > 0))
+	{
+		throw std::invalid_argument("received non-positive step size");
+	}
+	m_initialStepSize = stepSize;
+}
+
+
+double EC::CMAEvolutionStrategy::GetConditionNumber() const
+{
+	if (m_axisLengths.empty())
+	{
+		return 1;
+	}
+	double minLength = *std::min_element(m_axisLengths.begin(), m_axisLengths.end());
+	double maxLength = *std::max_element(m_axisLengths.begin(), m_axisLengths.end());
+	return minLength > 0 ? (maxLength / minLength) * (maxLength / minLength) : HUGE_VAL;
+}
+
+
+void EC::CMAEvolutionStrategy::Initialize(
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc)
+{
+	// Call base method to check the lower and upper bound
+	BaseEvolver<double, double>::Initialize(populationSize, lowerBound, upperBound, pFitnessFunc);
+	unsigned int problemDim = static_cast<unsigned int>(lowerBound.size());
+	if (problemDim == 0)
+	{
+		throw std::invalid_argument("received empty domain");
+	}
+	if (populationSize == 0)
+	{
+		populationSize = 4 + static_cast<unsigned int>(3 * std::log(static_cast<double>(problemDim)));
+	}
+	if (populationSize < 2)
+	{
+		throw std::invalid_argument("received population smaller than 2");
+	}
+
+	// Uniform initial population; the mean starts at its best individual
+	delete m_pPopulation;
+	delete m_pOffsprings;
+	m_pOffsprings = new ContiguousPopulation<double, double>(populationSize, problemDim);
+	ContiguousPopulation<double, double>* pPopulation =
+		new ContiguousPopulation<double, double>(populationSize, problemDim);
+	for (unsigned int i = 0; i < populationSize; i++)
+	{
+		double* pGenes = pPopulation->GetChromosome(i);
+		for (unsigned int k = 0; k < problemDim; k++)
+		{
+			pGenes[k] = RandUniform(m_lowerBound[k], m_upperBound[k]);
+		}
+	}
+	m_pPopulation = pPopulation;
+
+	m_width.resize(problemDim);
+	for (unsigned int k = 0; k < problemDim; k++)
+	{
+		m_width[k] = m_upperBound[k] - m_lowerBound[k];
+	}
+	SetStrategyParameters(problemDim, populationSize);
+
+	m_isMeanSet = false;
+	m_numUpdates = 0;
+	m_bestHistory.assign(10 + (30 * problemDim + populationSize - 1) / populationSize, 0);
+	m_mean.assign(problemDim, 0);
+	m_stepSize = m_initialStepSize;
+	m_pathC.assign(problemDim, 0);
+	m_pathSigma.assign(problemDim, 0);
+	m_axisLengths.assign(problemDim, 1);
+	if (m_isSeparable)
+	{
+		m_covariance.assign(problemDim, 1);
+		m_eigenvectors.clear();
+		m_work.clear();
+	}
+	else
+	{
+		m_covariance.assign(static_cast<size_t>(problemDim) * problemDim, 0);
+		m_eigenvectors.assign(static_cast<size_t>(problemDim) * problemDim, 0);
+		for (unsigned int k = 0; k < problemDim; k++)
+		{
+			m_covariance[static_cast<size_t>(k) * problemDim + k] = 1;
+			m_eigenvectors[static_cast<size_t>(k) * problemDim + k] = 1;
+		}
+		m_work.assign(2 * static_cast<size_t>(problemDim) * problemDim, 0);
+	}
+	m_evaluationsAtDecomposition = m_numEvaluations;
+	m_numDecompositions = 0;
+
+	m_normals.resize(static_cast<size_t>(populationSize) * problemDim);
+	m_steps.resize(static_cast<size_t>(m_numParents) * problemDim);
+	m_vector.resize(2 * static_cast<size_t>(problemDim));
+	m_rankOrder.resize(populationSize);
+
+	delete m_pElite;
+	m_pElite = NULL;
+}
+
+
+void EC::CMAEvolutionStrategy::SetStrategyParameters(unsigned int dimension, unsigned int populationSize)
+{
+	double n = static_cast<double>(dimension);
+	m_numParents = populationSize / 2;
+	m_weights.resize(m_numParents);
+	double sumWeights = 0;
+	for (unsigned int r = 0; r < m_numParents; r++)
+	{
+		m_weights[r] = std::log(m_numParents + 0.5) - std::log(r + 1.0);
+		sumWeights += m_weights[r];
+	}
+	double sumSquares = 0;
+	for (unsigned int r = 0; r < m_numParents; r++)
+	{
+		m_weights[r] /= sumWeights;
+		sumSquares += m_weights[r] * m_weights[r];
+	}
+	double mu = m_effectiveMu = 1.0 / sumSquares;
+
+	m_cumulationC = (4 + mu / n) / (n + 4 + 2 * mu / n);
+	m_cumulationSigma = (mu + 2) / (n + mu + 5);
+	m_rankOneRate = 2 / ((n + 1.3) * (n + 1.3) + mu);
+	m_rankMuRate = std::min(1 - m_rankOneRate, 2 * (mu - 2 + 1 / mu) / ((n + 2) * (n + 2) + mu));
+	if (m_isSeparable)
+	{
+		// A diagonal matrix has n parameters instead of n^2 / 2: it can learn faster
+		m_rankOneRate *= (n + 2) / 3;
+		m_rankMuRate = std::min(1 - m_rankOneRate, m_rankMuRate * (n + 2) / 3);
+	}
+	m_damping = 1 + 2 * std::max(0.0, std::sqrt((mu - 1) / (n + 1)) - 1) + m_cumulationSigma;
+	m_expectedNorm = std::sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+}
+
+
+void EC::CMAEvolutionStrategy::Breed()
+{
+	ContiguousPopulation<double, double>* pPopulation =
+		static_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	ContiguousPopulation<double, double>* pOffsprings =
+		static_cast<ContiguousPopulation<double, double>*>(m_pOffsprings);
+	if (pPopulation == NULL || pOffsprings == NULL)
+	{
+		throw std::runtime_error("Breed called before Initialize");
+	}
+	unsigned int popSize = pOffsprings->Size();
+	unsigned int n = pOffsprings->GetChromosomeLength();
+
+	if (!m_isMeanSet)
+	{
+		const double* pFitness = pPopulation->GetFitnessData();
+		unsigned int best = static_cast<unsigned int>(std::min_element(pFitness, pFitness + pPopulation->Size()) - pFitness);
+		const double* pBest = pPopulation->GetChromosome(best);
+		for (unsigned int k = 0; k < n; k++)
+		{
+			m_mean[k] = m_width[k] > 0 ? (pBest[k] - m_lowerBound[k]) / m_width[k] : 0;
+		}
+		m_isMeanSet = true;
+	}
+
+	// Lazy update: the covariance changes by about c1 + cmu per generation
+	if (!m_isSeparable && m_numEvaluations - m_evaluationsAtDecomposition >
+		popSize / ((m_rankOneRate + m_rankMuRate) * n * 10))
+	{
+		UpdateEigenSystem();
+	}
+
+	// All the draws at once, then x = m + sigma B D z, mirrored into the domain
+	GetRandomGenerator().FillNormal(&m_normals[0], m_normals.size(), 0, 1);
+	const double* pAxisLengths = &m_axisLengths[0];
+	double* pStep = &m_vector[0];
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		double* pNormal = &m_normals[static_cast<size_t>(i) * n];
+		for (unsigned int j = 0; j < n; j++)
+		{
+			pNormal[j] *= pAxisLengths[j];
+		}
+		if (m_isSeparable)
+		{
+			std::memcpy(pStep, pNormal, n * sizeof(double));
+		}
+		else
+		{
+			for (unsigned int k = 0; k < n; k++)
+			{
+				const double* pRow = &m_eigenvectors[static_cast<size_t>(k) * n];
+				double sum = 0;
+				for (unsigned int j = 0; j < n; j++)
+				{
+					sum += pRow[j] * pNormal[j];
+				}
+				pStep[k] = sum;
+			}
+		}
+
+		double* pGenes = pOffsprings->GetChromosome(i);
+		for (unsigned int k = 0; k < n; k++)
+		{
+			double y = m_mean[k] + m_stepSize * pStep[k];
+			if (y < 0 || y > 1)
+			{
+				y = std::fmod(std::fabs(y), 2.0);
+				y = y > 1 ? 2 - y : y;
+			}
+			pGenes[k] = m_lowerBound[k] + m_width[k] * y;
+		}
+	}
+
+	// Evaluate all offsprings at once, so that they can be spread over threads
+	Evaluate(m_pOffsprings);
+}
+
+
+void EC::CMAEvolutionStrategy::Select()
+{
+	ContiguousPopulation<double, double>* pOffsprings =
+		static_cast<ContiguousPopulation<double, double>*>(m_pOffsprings);
+	if (pOffsprings == NULL)
+	{
+		return;
+	}
+	unsigned int popSize = pOffsprings->Size();
+	unsigned int n = pOffsprings->GetChromosomeLength();
+	unsigned int mu = m_numParents;
+
+	const double* pFitness = pOffsprings->GetFitnessData();
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		m_rankOrder[i] = i;
+	}
+	std::partial_sort(m_rankOrder.begin(), m_rankOrder.begin() + mu, m_rankOrder.end(),
+		[pFitness](unsigned int a, unsigned int b) { return pFitness[a] < pFitness[b]; });
+
+	// Steps of the best offsprings, as evaluated after mirroring, and their weighted mean
+	double* pMeanStep = &m_vector[0];
+	std::fill(pMeanStep, pMeanStep + n, 0.0);
+	for (unsigned int r = 0; r < mu; r++)
+	{
+		const double* pGenes = pOffsprings->GetChromosome(m_rankOrder[r]);
+		double* pStep = &m_steps[static_cast<size_t>(r) * n];
+		for (unsigned int k = 0; k < n; k++)
+		{
+			double y = m_width[k] > 0 ? (pGenes[k] - m_lowerBound[k]) / m_width[k] : m_mean[k];
+			pStep[k] = (y - m_mean[k]) / m_stepSize;
+			pMeanStep[k] += m_weights[r] * pStep[k];
+		}
+	}
+	for (unsigned int k = 0; k < n; k++)
+	{
+		m_mean[k] += m_stepSize * pMeanStep[k];
+	}
+
+	// Step-size path, with C^-1/2 = B D^-1 B^T
+	double* pWhitened = &m_vector[n];
+	if (m_isSeparable)
+	{
+		for (unsigned int k = 0; k < n; k++)
+		{
+			pWhitened[k] = pMeanStep[k] / m_axisLengths[k];
+		}
+	}
+	else
+	{
+		double* pRotated = &m_work[0];
+		for (unsigned int j = 0; j < n; j++)
+		{
+			pRotated[j] = 0;
+		}
+		for (unsigned int k = 0; k < n; k++)
+		{
+			const double* pRow = &m_eigenvectors[static_cast<size_t>(k) * n];
+			for (unsigned int j = 0; j < n; j++)
+			{
+				pRotated[j] += pRow[j] * pMeanStep[k];
+			}
+		}
+		for (unsigned int j = 0; j < n; j++)
+		{
+			pRotated[j] /= m_axisLengths[j];
+		}
+		for (unsigned int k = 0; k < n; k++)
+		{
+			const double* pRow = &m_eigenvectors[static_cast<size_t>(k) * n];
+			double sum = 0;
+			for (unsigned int j = 0; j < n; j++)
+			{
+				sum += pRow[j] * pRotated[j];
+			}
+			pWhitened[k] = sum;
+		}
+	}
+	double cs = m_cumulationSigma;
+	double sigmaRate = std::sqrt(cs * (2 - cs) * m_effectiveMu);
+	double normSigma = 0;
+	for (unsigned int k = 0; k < n; k++)
+	{
+		m_pathSigma[k] = (1 - cs) * m_pathSigma[k] + sigmaRate * pWhitened[k];
+		normSigma += m_pathSigma[k] * m_pathSigma[k];
+	}
+	normSigma = std::sqrt(normSigma);
+	m_bestHistory[m_numUpdates % m_bestHistory.size()] = pFitness[m_rankOrder[0]];
+	m_numUpdates++;
+
+	// Covariance path, stalled while the step size grows fast
+	double cc = m_cumulationC;
+	bool isStalled = normSigma / std::sqrt(1 - std::pow(1 - cs, 2.0 * m_numUpdates)) / m_expectedNorm >=
+		1.4 + 2.0 / (n + 1);
+	double covarianceRate = isStalled ? 0 : std::sqrt(cc * (2 - cc) * m_effectiveMu);
+	for (unsigned int k = 0; k < n; k++)
+	{
+		m_pathC[k] = (1 - cc) * m_pathC[k] + covarianceRate * pMeanStep[k];
+	}
+
+	// Covariance: rank-one update from the path, rank-mu update from the steps
+	double c1 = m_rankOneRate;
+	double cmu = m_rankMuRate;
+	double decay = 1 - c1 - cmu + (isStalled ? c1 * cc * (2 - cc) : 0);
+	if (m_isSeparable)
+	{
+		for (unsigned int k = 0; k < n; k++)
+		{
+			double rankMu = 0;
+			for (unsigned int r = 0; r < mu; r++)
+			{
+				double step = m_steps[static_cast<size_t>(r) * n + k];
+				rankMu += m_weights[r] * step * step;
+			}
+			m_covariance[k] = decay * m_covariance[k] + c1 * m_pathC[k] * m_pathC[k] + cmu * rankMu;
+			m_axisLengths[k] = std::sqrt(m_covariance[k]);
+		}
+	}
+	else
+	{
+		// Lower triangle only; UpdateEigenSystem mirrors it
+		for (unsigned int a = 0; a < n; a++)
+		{
+			double* pRow = &m_covariance[static_cast<size_t>(a) * n];
+			double pathA = c1 * m_pathC[a];
+			for (unsigned int b = 0; b <= a; b++)
+			{
+				pRow[b] = decay * pRow[b] + pathA * m_pathC[b];
+			}
+		}
+		for (unsigned int r = 0; r < mu; r++)
+		{
+			const double* pStep = &m_steps[static_cast<size_t>(r) * n];
+			double weight = cmu * m_weights[r];
+			for (unsigned int a = 0; a < n; a++)
+			{
+				double* pRow = &m_covariance[static_cast<size_t>(a) * n];
+				double stepA = weight * pStep[a];
+				for (unsigned int b = 0; b <= a; b++)
+				{
+					pRow[b] += stepA * pStep[b];
+				}
+			}
+		}
+	}
+
+	m_stepSize *= std::exp(std::min(1.0, (cs / m_damping) * (normSigma / m_expectedNorm - 1)));
+
+	// (mu, lambda): the offsprings replace the population
+	std::swap(m_pPopulation, m_pOffsprings);
+}
+
+
+void EC::CMAEvolutionStrategy::UpdateEigenSystem()
+{
+	unsigned int n = static_cast<unsigned int>(m_mean.size());
+	double* pCovariance = &m_covariance[0];
+	for (unsigned int a = 0; a < n; a++)
+	{
+		for (unsigned int b = 0; b < a; b++)
+		{
+			pCovariance[static_cast<size_t>(b) * n + a] = pCovariance[static_cast<size_t>(a) * n + b];
+		}
+	}
+
+	// Rotate into the previous eigenbasis: A = B^T C B is nearly diagonal
+	double* pRotated = &m_work[0];
+	double* pProduct = &m_work[static_cast<size_t>(n) * n];
+	const double* pBasis = &m_eigenvectors[0];
+	std::fill(pProduct, pProduct + static_cast<size_t>(n) * n, 0.0);
+	for (unsigned int a = 0; a < n; a++)
+	{
+		for (unsigned int k = 0; k < n; k++)
+		{
+			double c = pCovariance[static_cast<size_t>(a) * n + k];
+			const double* pBasisRow = pBasis + static_cast<size_t>(k) * n;
+			double* pProductRow = pProduct + static_cast<size_t>(a) * n;
+			for (unsigned int j = 0; j < n; j++)
+			{
+				pProductRow[j] += c * pBasisRow[j];
+			}
+		}
+	}
+	std::fill(pRotated, pRotated + static_cast<size_t>(n) * n, 0.0);
+	for (unsigned int k = 0; k < n; k++)
+	{
+		const double* pBasisRow = pBasis + static_cast<size_t>(k) * n;
+		const double* pProductRow = pProduct + static_cast<size_t>(k) * n;
+		for (unsigned int i = 0; i < n; i++)
+		{
+			double b = pBasisRow[i];
+			double* pRotatedRow = pRotated + static_cast<size_t>(i) * n;
+			for (unsigned int j = 0; j < n; j++)
+			{
+				pRotatedRow[j] += b * pProductRow[j];
+			}
+		}
+	}
+
+	double* pEigenvalues = pProduct;
+	JacobiEigen(n, pRotated, &m_eigenvectors[0], pEigenvalues);
+	double maxEigenvalue = *std::max_element(pEigenvalues, pEigenvalues + n);
+	for (unsigned int j = 0; j < n; j++)
+	{
+		m_axisLengths[j] = std::sqrt(std::max(pEigenvalues[j], maxEigenvalue * 1e-20));
+	}
+	m_evaluationsAtDecomposition = m_numEvaluations;
+	m_numDecompositions++;
+}
+
+
+unsigned int EC::CMAEvolutionStrategy::JacobiEigen(
+	unsigned int n,
+	double* pMatrix,
+	double* pEigenvectors,
+	double* pEigenvalues)
+{
+	unsigned int sweep = 0;
+	for (; sweep < MaxJacobiSweeps; sweep++)
+	{
+		double offDiagonal = 0, diagonal = 0;
+		for (unsigned int p = 0; p < n; p++)
+		{
+			diagonal += pMatrix[static_cast<size_t>(p) * n + p] * pMatrix[static_cast<size_t>(p) * n + p];
+			for (unsigned int q = p + 1; q < n; q++)
+			{
+				offDiagonal += pMatrix[static_cast<size_t>(p) * n + q] * pMatrix[static_cast<size_t>(p) * n + q];
+			}
+		}
+		if (offDiagonal <= 1e-30 * diagonal)
+		{
+			break;
+		}
+
+		for (unsigned int p = 0; p + 1 < n; p++)
+		{
+			for (unsigned int q = p + 1; q < n; q++)
+			{
+				double apq = pMatrix[static_cast<size_t>(p) * n + q];
+				if (apq == 0)
+				{
+					continue;
+				}
+				// Rotation by the angle that zeroes a_pq: t = tan(angle), the smaller root
+				double app = pMatrix[static_cast<size_t>(p) * n + p];
+				double aqq = pMatrix[static_cast<size_t>(q) * n + q];
+				double theta = (aqq - app) / (2 * apq);
+				double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+				double c = 1 / std::sqrt(t * t + 1);
+				double s = t * c;
+
+				// A J, then J^T (A J), and V J
+				for (unsigned int k = 0; k < n; k++)
+				{
+					double* pRow = pMatrix + static_cast<size_t>(k) * n;
+					double akp = pRow[p], akq = pRow[q];
+					pRow[p] = c * akp - s * akq;
+					pRow[q] = s * akp + c * akq;
+				}
+				double* pRowP = pMatrix + static_cast<size_t>(p) * n;
+				double* pRowQ = pMatrix + static_cast<size_t>(q) * n;
+				for (unsigned int k = 0; k < n; k++)
+				{
+					double apk = pRowP[k], aqk = pRowQ[k];
+					pRowP[k] = c * apk - s * aqk;
+					pRowQ[k] = s * apk + c * aqk;
+				}
+				pRowP[q] = pRowQ[p] = 0;
+				for (unsigned int k = 0; k < n; k++)
+				{
+					double* pRow = pEigenvectors + static_cast<size_t>(k) * n;
+					double vkp = pRow[p], vkq = pRow[q];
+					pRow[p] = c * vkp - s * vkq;
+					pRow[q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+	for (unsigned int j = 0; j < n; j++)
+	{
+		pEigenvalues[j] = pMatrix[static_cast<size_t>(j) * n + j];
+	}
+	return sweep;
+}
+
+
+bool EC::CMAEvolutionStrategy::CheckStopCriteria()
+{
+	if (m_generation >= m_maxGeneration)
+	{
+		return true;
+	}
+	if (!m_isMeanSet)
+	{
+		return false;
+	}
+	double maxLength = *std::max_element(m_axisLengths.begin(), m_axisLengths.end());
+	if (m_stepSize * maxLength < MinStepSize || GetConditionNumber() > MaxConditionNumber)
+	{
+		return true;
+	}
+
+	// The best fitness has stalled
+	if (m_numUpdates >= m_bestHistory.size())
+	{
+		std::pair<std::vector<double>::const_iterator, std::vector<double>::const_iterator> range =
+			std::minmax_element(m_bestHistory.begin(), m_bestHistory.end());
+		if (*range.second - *range.first < MinFitnessRange)
+		{
+			return true;
+		}
+	}
+
+	// A standard deviation no longer changes a coordinate of the mean
+	unsigned int n = static_cast<unsigned int>(m_mean.size());
+	for (unsigned int k = 0; k < n; k++)
+	{
+		double variance = m_isSeparable ? m_covariance[k] : m_covariance[static_cast<size_t>(k) * n + k];
+		if (m_mean[k] + 0.2 * m_stepSize * std::sqrt(variance) == m_mean[k])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void EC::CMAEvolutionStrategy::SaveElite()
+{
+	ContiguousPopulation<double, double>* pPopulation =
+		static_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	unsigned int popSize = pPopulation->Size();
+	if (popSize == 0)
+	{
+		return;
+	}
+	const double* pFitness = pPopulation->GetFitnessData();
+	unsigned int best = static_cast<unsigned int>(std::min_element(pFitness, pFitness + popSize) - pFitness);
+	unsigned int length = pPopulation->GetChromosomeLength();
+	if (m_pElite == NULL || m_pElite->Size() != static_cast<int>(length))
+	{
+		delete m_pElite;
+		m_pElite = new RealCodedIndividual(length);
+		m_pElite->SetFitness(HUGE_VAL);
+	}
+	if (pFitness[best] < m_pElite->GetFitness())
+	{
+		const double* pBest = pPopulation->GetChromosome(best);
+		for (unsigned int k = 0; k < length; k++)
+		{
+			(*m_pElite)[k] = pBest[k];
+		}
+		m_pElite->SetFitness(pFitness[best]);
+	}
+}
@@ -0,0 +1,440 @@
+#include "../include/Checkpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define EC_HAS_POSIX_FILES 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+	const char         CheckpointMagic[8] = { 'E', 'C', 'D', 'E', 'C', 'K', 'P', 'T' };
+	const uint32_t     CheckpointVersion = 4;  // 2: maxGeneration, 3: adaptive strategies, 4: header checksum
+	const uint32_t     ByteOrderMark = 0x01020304;
+	const std::size_t  SectionAlignment = 64;
+	const unsigned int NumSections = 8;
+
+	inline std::size_t AlignUp(std::size_t bytes)
+	{
+		return (bytes + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+	}
+
+	/// Offsets of the sections and size of the whole file, from the sizes in a header
+	std::size_t ComputeLayout(const EC::CheckpointHeader& header, std::size_t* pOffsets)
+	{
+		uint64_t chromosomeLength = header.chromosomeLength;
+		uint64_t populationSize = header.populationSize;
+		std::size_t sectionBytes[NumSections] = {
+			AlignUp(chromosomeLength * sizeof(double)),
+			AlignUp(chromosomeLength * sizeof(double)),
+			AlignUp(chromosomeLength * sizeof(double)),
+			AlignUp(populationSize * sizeof(double)),
+			AlignUp(populationSize * header.stride * sizeof(double)),
+			AlignUp(static_cast<uint64_t>(header.numMemories) * sizeof(double)),
+			AlignUp(static_cast<uint64_t>(header.numMemories) * sizeof(double)),
+			AlignUp(static_cast<uint64_t>(header.archiveSize) * chromosomeLength * sizeof(double))
+		};
+		std::size_t offset = AlignUp(sizeof(EC::CheckpointHeader));
+		for (unsigned int s = 0; s < NumSections; s++)
+		{
+			pOffsets[s] = offset;
+			offset += sectionBytes[s];
+		}
+		return offset;
+	}
+
+	/// Word-wise FNV-1a. Sections are multiples of 8 bytes.
+	const uint64_t ChecksumBasis = 14695981039346656037ULL;
+
+	inline uint64_t UpdateChecksum(uint64_t hash, const void* pData, std::size_t bytes)
+	{
+		const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+		for (std::size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			std::memcpy(&word, pBytes + i, sizeof(uint64_t));
+			hash = (hash ^ word) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	inline uint64_t UpdateChecksumZeros(uint64_t hash, std::size_t bytes)
+	{
+		for (std::size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t))
+		{
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	static_assert(sizeof(EC::CheckpointHeader) % sizeof(uint64_t) == 0,
+		"The checksum hashes the header word by word");
+
+	/// Checksum of the header, computed with the checksum field zeroed
+	inline uint64_t HeaderChecksum(const EC::CheckpointHeader& header)
+	{
+		EC::CheckpointHeader copy = header;
+		copy.checksum = 0;
+		return UpdateChecksum(ChecksumBasis, &copy, sizeof(copy));
+	}
+
+	/// One section of the payload: data followed by zero padding
+	struct Section
+	{
+		const void* pData;
+		std::size_t dataBytes;
+		std::size_t paddedBytes;
+	};
+
+	void WriteAll(std::FILE* pFile, const void* pData, std::size_t bytes, const std::string& path)
+	{
+		if (bytes > 0 && std::fwrite(pData, 1, bytes, pFile) != bytes)
+		{
+			throw std::runtime_error("Can't write checkpoint " + path);
+		}
+	}
+}
+
+
+EC::CheckpointState::CheckpointState()
+	: populationSize(0), chromosomeLength(0), stride(0), generation(0), maxGeneration(0), seed(0), numEvaluations(0),
+	diffWeight(0), crossoverProb(0), hasElite(false), eliteFitness(0), strategy(0), pBestRate(0),
+	archiveRate(0), memorySize(0), learningRate(0), initialDiffWeight(0), initialCrossoverProb(0),
+	minPopulationSize(0), memoryIndex(0), initialPopulationSize(0), archiveCapacity(0)
+{
+	std::memset(randomState, 0, sizeof(randomState));
+}
+
+
+void EC::WriteCheckpoint(const std::string& path, const CheckpointState& state)
+{
+	if (state.lowerBound.size() != state.chromosomeLength || state.upperBound.size() != state.chromosomeLength ||
+		state.fitness.size() != state.populationSize ||
+		state.genes.size() != static_cast<std::size_t>(state.populationSize) * state.stride ||
+		state.stride < state.chromosomeLength ||
+		(state.hasElite && state.eliteChromosome.size() != state.chromosomeLength) ||
+		state.memoryCrossoverProb.size() != state.memoryDiffWeight.size() ||
+		state.externalArchive.size() % (state.chromosomeLength > 0 ? state.chromosomeLength : 1) != 0)
+	{
+		throw std::invalid_argument("Inconsistent checkpoint state");
+	}
+
+	CheckpointHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, CheckpointMagic, sizeof(header.magic));
+	header.version = CheckpointVersion;
+	header.byteOrder = ByteOrderMark;
+	header.populationSize = state.populationSize;
+	header.chromosomeLength = state.chromosomeLength;
+	header.stride = state.stride;
+	header.generation = state.generation;
+	header.seed = state.seed;
+	header.numEvaluations = state.numEvaluations;
+	std::memcpy(header.randomState, state.randomState, sizeof(header.randomState));
+	header.diffWeight = state.diffWeight;
+	header.crossoverProb = state.crossoverProb;
+	header.eliteFitness = state.eliteFitness;
+	header.hasElite = state.hasElite ? 1 : 0;
+	header.maxGeneration = state.maxGeneration;
+	header.strategy = state.strategy;
+	header.memorySize = state.memorySize;
+	header.minPopulationSize = state.minPopulationSize;
+	header.numMemories = static_cast<uint32_t>(state.memoryDiffWeight.size());
+	header.memoryIndex = state.memoryIndex;
+	header.initialPopulationSize = state.initialPopulationSize;
+	header.archiveCapacity = state.archiveCapacity;
+	header.archiveSize = state.chromosomeLength > 0 ?
+		static_cast<uint32_t>(state.externalArchive.size() / state.chromosomeLength) : 0;
+	header.pBestRate = state.pBestRate;
+	header.archiveRate = state.archiveRate;
+	header.learningRate = state.learningRate;
+	header.initialDiffWeight = state.initialDiffWeight;
+	header.initialCrossoverProb = state.initialCrossoverProb;
+
+	std::size_t offsets[NumSections];
+	std::size_t fileSize = ComputeLayout(header, offsets);
+	const double* pElite = state.hasElite ? &state.eliteChromosome[0] : NULL;
+	std::size_t lengthBytes = state.chromosomeLength * sizeof(double);
+	Section sections[NumSections] = {
+		{ state.lowerBound.empty() ? NULL : &state.lowerBound[0], lengthBytes, 0 },
+		{ state.upperBound.empty() ? NULL : &state.upperBound[0], lengthBytes, 0 },
+		{ pElite, pElite != NULL ? lengthBytes : 0, 0 },
+		{ state.fitness.empty() ? NULL : &state.fitness[0], state.fitness.size() * sizeof(double), 0 },
+		{ state.genes.empty() ? NULL : &state.genes[0], state.genes.size() * sizeof(double), 0 },
+		{ state.memoryDiffWeight.empty() ? NULL : &state.memoryDiffWeight[0],
+			state.memoryDiffWeight.size() * sizeof(double), 0 },
+		{ state.memoryCrossoverProb.empty() ? NULL : &state.memoryCrossoverProb[0],
+			state.memoryCrossoverProb.size() * sizeof(double), 0 },
+		{ state.externalArchive.empty() ? NULL : &state.externalArchive[0],
+			state.externalArchive.size() * sizeof(double), 0 }
+	};
+	for (unsigned int s = 0; s < NumSections; s++)
+	{
+		std::size_t end = s + 1 < NumSections ? offsets[s + 1] : fileSize;
+		sections[s].paddedBytes = end - offsets[s];
+	}
+
+	header.payloadSize = fileSize - offsets[0];
+	uint64_t checksum = HeaderChecksum(header);
+	checksum = UpdateChecksumZeros(checksum, offsets[0] - sizeof(header));
+	for (unsigned int s = 0; s < NumSections; s++)
+	{
+		checksum = UpdateChecksum(checksum, sections[s].pData, sections[s].dataBytes);
+		checksum = UpdateChecksumZeros(checksum, sections[s].paddedBytes - sections[s].dataBytes);
+	}
+	header.checksum = checksum;
+
+	// Write under a temporary name, then rename over the previous checkpoint
+	std::string tempPath = path + ".tmp";
+	std::FILE* pFile = std::fopen(tempPath.c_str(), "wb");
+	if (pFile == NULL)
+	{
+		throw std::runtime_error("Can't open " + tempPath);
+	}
+	try
+	{
+		static const char zeros[SectionAlignment] = { 0 };
+		WriteAll(pFile, &header, sizeof(header), tempPath);
+		WriteAll(pFile, zeros, offsets[0] - sizeof(header), tempPath);
+		for (unsigned int s = 0; s < NumSections; s++)
+		{
+			WriteAll(pFile, sections[s].pData, sections[s].dataBytes, tempPath);
+			for (std::size_t padding = sections[s].paddedBytes - sections[s].dataBytes; padding > 0; )
+			{
+				std::size_t bytes = padding < SectionAlignment ? padding : SectionAlignment;
+				WriteAll(pFile, zeros, bytes, tempPath);
+				padding -= bytes;
+			}
+		}
+		if (std::fflush(pFile) != 0)
+		{
+			throw std::runtime_error("Can't write checkpoint " + tempPath);
+		}
+#ifdef EC_HAS_POSIX_FILES
+		if (fsync(fileno(pFile)) != 0)
+		{
+			throw std::runtime_error("Can't flush checkpoint " + tempPath);
+		}
+#endif
+	}
+	catch (...)
+	{
+		std::fclose(pFile);
+		std::remove(tempPath.c_str());
+		throw;
+	}
+	if (std::fclose(pFile) != 0)
+	{
+		std::remove(tempPath.c_str());
+		throw std::runtime_error("Can't write checkpoint " + tempPath);
+	}
+
+#ifndef EC_HAS_POSIX_FILES
+	// rename does not replace an existing file everywhere
+	std::remove(path.c_str());
+#endif
+	if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(tempPath.c_str());
+		throw std::runtime_error("Can't rename checkpoint to " + path);
+	}
+}
+
+
+EC::MappedCheckpoint::MappedCheckpoint(const std::string& path)
+	: m_pData(NULL), m_size(0), m_isMapped(false)
+{
+#ifdef EC_HAS_POSIX_FILES
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Can't open checkpoint " + path);
+	}
+	struct stat fileStatus;
+	if (fstat(fd, &fileStatus) != 0 || fileStatus.st_size < static_cast<off_t>(sizeof(CheckpointHeader)))
+	{
+		close(fd);
+		throw std::runtime_error("Truncated checkpoint " + path);
+	}
+	m_size = static_cast<std::size_t>(fileStatus.st_size);
+	void* pMap = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (pMap == MAP_FAILED)
+	{
+		throw std::runtime_error("Can't map checkpoint " + path);
+	}
+	m_pData = static_cast<const char*>(pMap);
+	m_isMapped = true;
+#else
+	std::FILE* pFile = std::fopen(path.c_str(), "rb");
+	if (pFile == NULL)
+	{
+		throw std::runtime_error("Can't open checkpoint " + path);
+	}
+	char chunk[1 << 16];
+	std::size_t bytes;
+	while ((bytes = std::fread(chunk, 1, sizeof(chunk), pFile)) > 0)
+	{
+		m_buffer.insert(m_buffer.end(), chunk, chunk + bytes);
+	}
+	std::fclose(pFile);
+	m_size = m_buffer.size();
+	if (m_size < sizeof(CheckpointHeader))
+	{
+		throw std::runtime_error("Truncated checkpoint " + path);
+	}
+	m_pData = &m_buffer[0];
+#endif
+
+	// Validate before anything is read from the sections
+	const CheckpointHeader& header = GetHeader();
+	const char* pError = NULL;
+	if (std::memcmp(header.magic, CheckpointMagic, sizeof(header.magic)) != 0)
+	{
+		pError = "Not a checkpoint: ";
+	}
+	else if (header.byteOrder != ByteOrderMark)
+	{
+		pError = "Checkpoint written with another byte order: ";
+	}
+	else if (header.version != CheckpointVersion)
+	{
+		pError = "Unsupported checkpoint version: ";
+	}
+	else if (header.stride < header.chromosomeLength ||
+		header.archiveSize > header.archiveCapacity ||
+		ComputeLayout(header, m_sectionOffsets) != m_size ||
+		header.payloadSize != m_size - m_sectionOffsets[0])
+	{
+		pError = "Truncated checkpoint: ";
+	}
+	else if (UpdateChecksum(HeaderChecksum(header), m_pData + sizeof(header), m_size - sizeof(header)) != header.checksum)
+	{
+		pError = "Corrupted checkpoint: ";
+	}
+	if (pError != NULL)
+	{
+#ifdef EC_HAS_POSIX_FILES
+		munmap(const_cast<char*>(m_pData), m_size);
+#endif
+		throw std::runtime_error(pError + path);
+	}
+}
+
+
+EC::MappedCheckpoint::~MappedCheckpoint()
+{
+#ifdef EC_HAS_POSIX_FILES
+	if (m_isMapped)
+	{
+		munmap(const_cast<char*>(m_pData), m_size);
+	}
+#endif
+}
+
+
+EC::CheckpointWriter::CheckpointWriter()
+	: m_hasPending(false), m_isWriting(false), m_stop(false), m_numWritten(0)
+{
+	m_thread = std::thread(&CheckpointWriter::Run, this);
+}
+
+
+EC::CheckpointWriter::~CheckpointWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+}
+
+
+void EC::CheckpointWriter::Submit(const std::string& path, CheckpointState& state)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::swap(m_pending, state);
+		m_pendingPath = path;
+		m_hasPending = true;
+	}
+	m_condition.notify_all();
+}
+
+
+void EC::CheckpointWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (m_hasPending || m_isWriting)
+	{
+		m_condition.wait(lock);
+	}
+	if (!m_error.empty())
+	{
+		std::string error;
+		error.swap(m_error);
+		throw std::runtime_error(error);
+	}
+}
+
+
+unsigned long long EC::CheckpointWriter::GetNumWritten()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_numWritten;
+}
+
+
+void EC::CheckpointWriter::Run()
+{
+	// Kept across iterations so its buffers are recycled through Submit
+	CheckpointState writing;
+	std::string path;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		while (!m_hasPending && !m_stop)
+		{
+			m_condition.wait(lock);
+		}
+		if (!m_hasPending)
+		{
+			return;
+		}
+		std::swap(writing, m_pending);
+		path.swap(m_pendingPath);
+		m_hasPending = false;
+		m_isWriting = true;
+		lock.unlock();
+
+		std::string error;
+		try
+		{
+			WriteCheckpoint(path, writing);
+		}
+		catch (const std::exception& e)
+		{
+			error = e.what();
+		}
+
+		lock.lock();
+		m_isWriting = false;
+		if (error.empty())
+		{
+			m_numWritten++;
+		}
+		else
+		{
+			m_error = error;
+		}
+		m_condition.notify_all();
+	}
+}
@@ -0,0 +1,671 @@
+#include "../include/CooperativeCoevolution.hpp"
+#include "../include/IndividualView.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+
+EC::SubspaceFunctor::SubspaceFunctor(BaseFitnessFunctor<double, double>* pFitnessFunc)
+	: m_pFitnessFunc(pFitnessFunc)
+{
+	if (pFitnessFunc == NULL)
+	{
+		throw std::invalid_argument("Invalid fitness function");
+	}
+}
+
+
+EC::SubspaceFunctor::~SubspaceFunctor()
+{ }
+
+
+void EC::SubspaceFunctor::SetContext(const std::vector<double>& context, const std::vector<unsigned int>& indexes)
+{
+	for (size_t k = 0; k < indexes.size(); k++)
+	{
+		if (indexes[k] >= context.size())
+		{
+			throw std::out_of_range("Variable index out of the context vector");
+		}
+	}
+	m_point = context;
+	m_indexes = indexes;
+}
+
+
+double EC::SubspaceFunctor::operator() (BaseIndividual<double, double>* pIndiv)
+{
+	for (size_t k = 0; k < m_indexes.size(); k++)
+	{
+		m_point[m_indexes[k]] = (*pIndiv)[static_cast<int>(k)];
+	}
+	double fitness;
+	unsigned int length = static_cast<unsigned int>(m_point.size());
+	m_pFitnessFunc->EvaluateBatch(&m_point[0], 1, length, length, &fitness);
+	return fitness;
+}
+
+
+void EC::SubspaceFunctor::EvaluateBatch(
+	const double* pChromosomes,
+	unsigned int numIndiv,
+	unsigned int,
+	unsigned int stride,
+	double* pFitness)
+{
+	unsigned int length = static_cast<unsigned int>(m_point.size());
+	unsigned int numIndexes = static_cast<unsigned int>(m_indexes.size());
+	for (unsigned int i = 0; i < numIndiv; i++)
+	{
+		const double* pGenes = pChromosomes + static_cast<size_t>(i) * stride;
+		for (unsigned int k = 0; k < numIndexes; k++)
+		{
+			m_point[m_indexes[k]] = pGenes[k];
+		}
+		m_pFitnessFunc->EvaluateBatch(&m_point[0], 1, length, length, pFitness + i);
+	}
+}
+
+
+bool EC::SubspaceFunctor::SupportsBoundedEvaluation() const
+{
+	return m_pFitnessFunc->SupportsBoundedEvaluation();
+}
+
+
+double EC::SubspaceFunctor::EvaluateBounded(BaseIndividual<double, double>* pIndiv, double bound, bool& isAborted)
+{
+	for (size_t k = 0; k < m_indexes.size(); k++)
+	{
+		m_point[m_indexes[k]] = (*pIndiv)[static_cast<int>(k)];
+	}
+	double fitness = 0;
+	IndividualView<double, double> point(&m_point[0], &fitness, static_cast<unsigned int>(m_point.size()));
+	return m_pFitnessFunc->EvaluateBounded(&point, bound, isAborted);
+}
+
+
+
+EC::CooperativeCoevolution::CooperativeCoevolution(GroupingMethod grouping)
+	: m_grouping(grouping), m_groupSize(100), m_generationsPerCycle(5), m_interactionThreshold(1e-3),
+	m_strategy(DE_RAND_1_BIN), m_numThreads(0), m_pFitnessFunc(NULL), m_populationSize(0),
+	m_contextFitness(0), m_cycle(0), m_numGroupingEvaluations(0), m_numContextEvaluations(0),
+	m_pThreadPool(NULL), m_stopReason(STOP_NONE), m_pElite(NULL)
+{
+	std::random_device randDevice;
+	m_seed = (static_cast<unsigned long long>(randDevice()) << 32) ^ randDevice();
+}
+
+
+EC::CooperativeCoevolution::~CooperativeCoevolution()
+{
+	ReleaseSubcomponents();
+	delete m_pThreadPool;
+	delete m_pElite;
+}
+
+
+void EC::CooperativeCoevolution::ReleaseSubcomponents()
+{
+	for (size_t g = 0; g < m_subcomponents.size(); g++)
+	{
+		delete m_subcomponents[g].pEvolver;
+		delete m_subcomponents[g].pFunctor;
+	}
+	m_subcomponents.clear();
+}
+
+
+void EC::CooperativeCoevolution::SetGroupSize(unsigned int groupSize)
+{
+	if (groupSize == 0)
+	{
+		throw std::invalid_argument("received non-positive group size");
+	}
+	m_groupSize = groupSize;
+}
+
+
+void EC::CooperativeCoevolution::SetGenerationsPerCycle(unsigned int numGenerations)
+{
+	if (numGenerations == 0)
+	{
+		throw std::invalid_argument("received non-positive number of generations per cycle");
+	}
+	m_generationsPerCycle = numGenerations;
+}
+
+
+void EC::CooperativeCoevolution::SetInteractionThreshold(double threshold)
+{
+	if (!(threshold >= 0))
+	{
+		throw std::invalid_argument("received negative interaction threshold");
+	}
+	m_interactionThreshold = threshold;
+}
+
+
+void EC::CooperativeCoevolution::SetStrategy(DEStrategy strategy, const AdaptiveParameters& parameters)
+{
+	if (strategy == DE_LSHADE)
+	{
+		throw std::invalid_argument("L-SHADE isn't supported by cooperative co-evolution");
+	}
+	// The parameters are checked when the subcomponents are created
+	m_strategy = strategy;
+	m_adaptive = parameters;
+}
+
+
+void EC::CooperativeCoevolution::SetSeed(unsigned long long seed)
+{
+	m_seed = seed;
+}
+
+
+EC::BaseIndividual<double, double>* EC::CooperativeCoevolution::GetElite()
+{
+	return m_pElite;
+}
+
+
+unsigned long long EC::CooperativeCoevolution::GetNumEvaluations() const
+{
+	unsigned long long numEvaluations = m_numGroupingEvaluations + m_numContextEvaluations;
+	for (size_t g = 0; g < m_subcomponents.size(); g++)
+	{
+		numEvaluations += m_subcomponents[g].pEvolver->GetNumEvaluations();
+	}
+	return numEvaluations;
+}
+
+
+void EC::CooperativeCoevolution::Evolve(
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	unsigned int maxCycle,
+	bool verbose)
+{
+	if (pFitnessFunc == NULL)
+	{
+		throw std::invalid_argument("Invalid fitness function");
+	}
+	if (lowerBound.size() != upperBound.size() || lowerBound.empty())
+	{
+		throw std::invalid_argument("Lower and upper bounds should have the same, non-zero size");
+	}
+	for (size_t k = 0; k < lowerBound.size(); k++)
+	{
+		if (lowerBound[k] > upperBound[k])
+		{
+			throw std::invalid_argument("Lower bound must be not bigger than the upper bound.");
+		}
+	}
+	if (populationSize < 4)
+	{
+		throw std::invalid_argument("received population smaller than 4");
+	}
+
+	m_pFitnessFunc = pFitnessFunc;
+	m_lowerBound = lowerBound;
+	m_upperBound = upperBound;
+	m_populationSize = populationSize;
+	unsigned int dim = static_cast<unsigned int>(lowerBound.size());
+
+	ReleaseSubcomponents();
+	m_groups.clear();
+	m_cycle = 0;
+	m_numGroupingEvaluations = 0;
+	m_numContextEvaluations = 0;
+	m_randomGenerator.Seed(m_seed);
+	delete m_pThreadPool;
+	m_pThreadPool = m_numThreads != 1 ? new ThreadPool(m_numThreads) : NULL;
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point startTime = Clock::now();
+	m_stopCriteria.Start(startTime);
+
+	if (m_grouping == GROUPING_DIFFERENTIAL)
+	{
+		m_groups = DifferentialGrouping(pFitnessFunc, m_lowerBound, m_upperBound, m_interactionThreshold,
+			m_groupSize, m_pThreadPool, m_numGroupingEvaluations);
+	}
+
+	// Initial population; the best individual is the first context
+	m_population.resize(static_cast<size_t>(populationSize) * dim);
+	for (unsigned int i = 0; i < populationSize; i++)
+	{
+		for (unsigned int k = 0; k < dim; k++)
+		{
+			m_population[static_cast<size_t>(i) * dim + k] = m_randomGenerator.Uniform(m_lowerBound[k], m_upperBound[k]);
+		}
+	}
+	std::vector<double> fitness(populationSize);
+	pFitnessFunc->EvaluateBatch(&m_population[0], populationSize, dim, dim, &fitness[0]);
+	m_numContextEvaluations += populationSize;
+	unsigned int best = static_cast<unsigned int>(std::min_element(fitness.begin(), fitness.end()) - fitness.begin());
+	m_context.assign(m_population.begin() + static_cast<size_t>(best) * dim,
+		m_population.begin() + static_cast<size_t>(best + 1) * dim);
+	m_contextFitness = fitness[best];
+
+	GenerationStatistics record = GenerationStatistics();
+	while (true)
+	{
+		record.generation = m_cycle;
+		record.numEvaluations = GetNumEvaluations();
+		record.bestFitness = m_contextFitness;
+		record.meanFitness = m_contextFitness;
+		record.elapsedSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+		if (m_stopCriteria.NeedsStatistics())
+		{
+			record.diversity = ComputeDiversity();
+		}
+		if (m_cycle >= maxCycle)
+		{
+			m_stopReason = STOP_MAX_GENERATION;
+			break;
+		}
+		m_stopReason = m_stopCriteria.Check(record);
+		if (m_stopReason != STOP_NONE)
+		{
+			break;
+		}
+
+		if (m_grouping == GROUPING_RANDOM)
+		{
+			RandomGrouping();
+		}
+		CreateSubcomponents();
+
+		// Every group against the same context, with an even share of the budget left
+		unsigned int numGroups = static_cast<unsigned int>(m_groups.size());
+		unsigned long long groupEvaluations = 0;
+		unsigned long long maxEvaluations = m_stopCriteria.GetMaxEvaluations();
+		if (maxEvaluations > 0)
+		{
+			unsigned long long numEvaluations = GetNumEvaluations();
+			unsigned long long remaining = maxEvaluations > numEvaluations ? maxEvaluations - numEvaluations : 0;
+			groupEvaluations = std::max(remaining / numGroups, 1ULL);
+		}
+		if (m_pThreadPool == NULL)
+		{
+			for (unsigned int g = 0; g < numGroups; g++)
+			{
+				RunSubcomponent(g, groupEvaluations);
+			}
+		}
+		else
+		{
+			m_pThreadPool->ParallelFor(numGroups, 1,
+				[this, groupEvaluations](unsigned int begin, unsigned int end, unsigned int)
+				{
+					for (unsigned int g = begin; g < end; g++)
+					{
+						RunSubcomponent(g, groupEvaluations);
+					}
+				});
+		}
+		MergeGroups();
+		m_cycle++;
+	}
+
+	if (m_pElite == NULL || m_pElite->Size() != static_cast<int>(dim))
+	{
+		delete m_pElite;
+		m_pElite = new RealCodedIndividual(dim);
+	}
+	for (unsigned int k = 0; k < dim; k++)
+	{
+		(*m_pElite)[k] = m_context[k];
+	}
+	m_pElite->SetFitness(m_contextFitness);
+
+	if (verbose)
+	{
+		std::cout << "Groups: " << m_groups.size()
+			<< ", cycles: " << m_cycle
+			<< ", evaluations: " << GetNumEvaluations()
+			<< ", best fitness: " << m_contextFitness << std::endl;
+	}
+}
+
+
+void EC::CooperativeCoevolution::RandomGrouping()
+{
+	unsigned int dim = static_cast<unsigned int>(m_lowerBound.size());
+	if (m_permutation.size() != dim)
+	{
+		m_permutation.resize(dim);
+		for (unsigned int k = 0; k < dim; k++)
+		{
+			m_permutation[k] = k;
+		}
+	}
+	for (unsigned int k = dim - 1; k > 0; k--)
+	{
+		std::swap(m_permutation[k], m_permutation[m_randomGenerator.NextInt(k + 1)]);
+	}
+
+	// Groups of balanced sizes, none larger than m_groupSize
+	unsigned int numGroups = (dim + m_groupSize - 1) / m_groupSize;
+	m_groups.resize(numGroups);
+	for (unsigned int g = 0; g < numGroups; g++)
+	{
+		size_t begin = static_cast<size_t>(g) * dim / numGroups;
+		size_t end = static_cast<size_t>(g + 1) * dim / numGroups;
+		m_groups[g].assign(m_permutation.begin() + begin, m_permutation.begin() + end);
+		std::sort(m_groups[g].begin(), m_groups[g].end());
+	}
+}
+
+
+void EC::CooperativeCoevolution::CreateSubcomponents()
+{
+	for (size_t g = m_subcomponents.size(); g < m_groups.size(); g++)
+	{
+		Subcomponent sub;
+		sub.pEvolver = new DifferentialEvolution();
+		sub.pEvolver->SetSeed(RandomGenerator(m_seed, g + 1).Next());
+		sub.pEvolver->SetStrategy(m_strategy, m_adaptive);
+		StopCriteria& criteria = sub.pEvolver->GetStopCriteria();
+		criteria.SetCancellationToken(m_stopCriteria.GetCancellationToken());
+		StopCriteria::Clock::time_point deadline;
+		if (m_stopCriteria.GetDeadline(deadline))
+		{
+			criteria.SetDeadline(deadline);
+		}
+		sub.pFunctor = new SubspaceFunctor(m_pFitnessFunc);
+		sub.bestFitness = 0;
+		m_subcomponents.push_back(sub);
+	}
+}
+
+
+void EC::CooperativeCoevolution::RunSubcomponent(unsigned int group, unsigned long long maxEvaluations)
+{
+	Subcomponent& sub = m_subcomponents[group];
+	const std::vector<unsigned int>& indexes = m_groups[group];
+	unsigned int size = static_cast<unsigned int>(indexes.size());
+	unsigned int dim = static_cast<unsigned int>(m_lowerBound.size());
+	sub.lowerBound.resize(size);
+	sub.upperBound.resize(size);
+	sub.bestGenes.resize(size);
+	for (unsigned int k = 0; k < size; k++)
+	{
+		sub.lowerBound[k] = m_lowerBound[indexes[k]];
+		sub.upperBound[k] = m_upperBound[indexes[k]];
+		sub.bestGenes[k] = m_context[indexes[k]];
+	}
+	sub.pFunctor->SetContext(m_context, indexes);
+
+	// Start from the columns of the group, plus the context
+	DifferentialEvolution* pEvolver = sub.pEvolver;
+	pEvolver->Initialize(m_populationSize, sub.lowerBound, sub.upperBound, sub.pFunctor);
+	ContiguousPopulation<double, double>* pPopulation =
+		static_cast<ContiguousPopulation<double, double>*>(pEvolver->GetPopulation());
+	for (unsigned int i = 0; i < m_populationSize; i++)
+	{
+		const double* pRow = &m_population[static_cast<size_t>(i) * dim];
+		double* pGenes = pPopulation->GetChromosome(i);
+		for (unsigned int k = 0; k < size; k++)
+		{
+			pGenes[k] = pRow[indexes[k]];
+		}
+	}
+	// Counters of the subcomponent go on across cycles
+	pEvolver->GetStopCriteria().SetMaxEvaluations(maxEvaluations > 0 ? pEvolver->GetNumEvaluations() + maxEvaluations : 0);
+	pEvolver->SetMaxGeneration(pEvolver->GetGeneration() + m_generationsPerCycle);
+	pEvolver->Start(false);
+	pEvolver->Immigrate(&sub.bestGenes[0], m_contextFitness);
+
+	while (!pEvolver->ShouldStop())
+	{
+		pEvolver->Step();
+	}
+
+	// Columns are disjoint between groups: written back without locks
+	pPopulation = static_cast<ContiguousPopulation<double, double>*>(pEvolver->GetPopulation());
+	for (unsigned int i = 0; i < m_populationSize; i++)
+	{
+		double* pRow = &m_population[static_cast<size_t>(i) * dim];
+		const double* pGenes = pPopulation->GetChromosome(i);
+		for (unsigned int k = 0; k < size; k++)
+		{
+			pRow[indexes[k]] = pGenes[k];
+		}
+	}
+	BaseIndividual<double, double>* pElite = pEvolver->GetElite();
+	for (unsigned int k = 0; k < size; k++)
+	{
+		sub.bestGenes[k] = (*pElite)[k];
+	}
+	sub.bestFitness = pElite->GetFitness();
+}
+
+
+void EC::CooperativeCoevolution::MergeGroups()
+{
+	unsigned int numGroups = static_cast<unsigned int>(m_groups.size());
+	unsigned int dim = static_cast<unsigned int>(m_context.size());
+	unsigned int numImproved = 0;
+	unsigned int best = 0;
+	for (unsigned int g = 0; g < numGroups; g++)
+	{
+		if (m_subcomponents[g].bestFitness < m_contextFitness)
+		{
+			numImproved++;
+		}
+		if (m_subcomponents[g].bestFitness < m_subcomponents[best].bestFitness)
+		{
+			best = g;
+		}
+	}
+	if (numImproved == 0)
+	{
+		return;
+	}
+
+	// The improvements were found separately: together they may interfere
+	if (numImproved > 1)
+	{
+		m_merged = m_context;
+		for (unsigned int g = 0; g < numGroups; g++)
+		{
+			const Subcomponent& sub = m_subcomponents[g];
+			if (sub.bestFitness < m_contextFitness)
+			{
+				for (size_t k = 0; k < m_groups[g].size(); k++)
+				{
+					m_merged[m_groups[g][k]] = sub.bestGenes[k];
+				}
+			}
+		}
+		double fitness;
+		m_pFitnessFunc->EvaluateBatch(&m_merged[0], 1, dim, dim, &fitness);
+		m_numContextEvaluations++;
+		if (fitness <= m_subcomponents[best].bestFitness)
+		{
+			m_context.swap(m_merged);
+			m_contextFitness = fitness;
+			return;
+		}
+	}
+
+	const Subcomponent& sub = m_subcomponents[best];
+	for (size_t k = 0; k < m_groups[best].size(); k++)
+	{
+		m_context[m_groups[best][k]] = sub.bestGenes[k];
+	}
+	m_contextFitness = sub.bestFitness;
+}
+
+
+double EC::CooperativeCoevolution::ComputeDiversity() const
+{
+	unsigned int dim = static_cast<unsigned int>(m_lowerBound.size());
+	std::vector<double> centroid(dim, 0);
+	for (unsigned int i = 0; i < m_populationSize; i++)
+	{
+		const double* pRow = &m_population[static_cast<size_t>(i) * dim];
+		for (unsigned int k = 0; k < dim; k++)
+		{
+			centroid[k] += pRow[k];
+		}
+	}
+	for (unsigned int k = 0; k < dim; k++)
+	{
+		centroid[k] /= m_populationSize;
+	}
+	double sumDistances = 0;
+	for (unsigned int i = 0; i < m_populationSize; i++)
+	{
+		const double* pRow = &m_population[static_cast<size_t>(i) * dim];
+		double squaredDistance = 0;
+		for (unsigned int k = 0; k < dim; k++)
+		{
+			double deviation = pRow[k] - centroid[k];
+			squaredDistance += deviation * deviation;
+		}
+		sumDistances += std::sqrt(squaredDistance);
+	}
+	return sumDistances / m_populationSize;
+}
+
+
+std::vector<std::vector<unsigned int> > EC::CooperativeCoevolution::DifferentialGrouping(
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	const std::vector<double>& lowerBound,
+	const std::vector<double>& upperBound,
+	double threshold,
+	unsigned int groupSize,
+	ThreadPool* pThreadPool,
+	unsigned long long& numEvaluations)
+{
+	if (pFitnessFunc == NULL)
+	{
+		throw std::invalid_argument("Invalid fitness function");
+	}
+	if (groupSize == 0)
+	{
+		throw std::invalid_argument("received non-positive group size");
+	}
+	unsigned int dim = static_cast<unsigned int>(lowerBound.size());
+	unsigned int numThreads = pThreadPool != NULL ? pThreadPool->GetNumThreads() : 1;
+	numEvaluations = 0;
+
+	// Effect of moving x_j to the middle of its range, from the lower corner. It doesn't
+	// depend on x_i, so it is computed once for every j.
+	std::vector<std::vector<double> > points(numThreads, lowerBound);
+	double cornerFitness;
+	pFitnessFunc->EvaluateBatch(&points[0][0], 1, dim, dim, &cornerFitness);
+	std::vector<double> middleFitness(dim);
+	ThreadPool::RangeFunction evaluateMiddles =
+		[&](unsigned int begin, unsigned int end, unsigned int threadIndex)
+		{
+			std::vector<double>& point = points[threadIndex];
+			for (unsigned int j = begin; j < end; j++)
+			{
+				point[j] = 0.5 * (lowerBound[j] + upperBound[j]);
+				pFitnessFunc->EvaluateBatch(&point[0], 1, dim, dim, &middleFitness[j]);
+				point[j] = lowerBound[j];
+			}
+		};
+	if (pThreadPool != NULL)
+	{
+		pThreadPool->ParallelFor(dim, 0, evaluateMiddles);
+	}
+	else
+	{
+		evaluateMiddles(0, dim, 0);
+	}
+	numEvaluations += 1 + dim;
+
+	std::vector<std::vector<unsigned int> > groups;
+	std::vector<unsigned int> separable;
+	std::vector<unsigned int> remaining(dim);
+	for (unsigned int k = 0; k < dim; k++)
+	{
+		remaining[k] = k;
+	}
+	std::vector<char> interacts;
+	while (!remaining.empty())
+	{
+		// Effect of moving x_i to its upper bound
+		unsigned int i = remaining[0];
+		for (unsigned int t = 0; t < numThreads; t++)
+		{
+			points[t][i] = upperBound[i];
+		}
+		double upperFitness;
+		pFitnessFunc->EvaluateBatch(&points[0][0], 1, dim, dim, &upperFitness);
+		double effect = upperFitness - cornerFitness;
+
+		// x_i and x_j interact if moving x_j changes the effect of x_i
+		unsigned int numCandidates = static_cast<unsigned int>(remaining.size()) - 1;
+		interacts.assign(numCandidates, 0);
+		ThreadPool::RangeFunction checkPairs =
+			[&](unsigned int begin, unsigned int end, unsigned int threadIndex)
+			{
+				std::vector<double>& point = points[threadIndex];
+				for (unsigned int c = begin; c < end; c++)
+				{
+					unsigned int j = remaining[c + 1];
+					double fitness;
+					point[j] = 0.5 * (lowerBound[j] + upperBound[j]);
+					pFitnessFunc->EvaluateBatch(&point[0], 1, dim, dim, &fitness);
+					point[j] = lowerBound[j];
+					interacts[c] = std::fabs(effect - (fitness - middleFitness[j])) > threshold;
+				}
+			};
+		if (pThreadPool != NULL && numCandidates > 0)
+		{
+			pThreadPool->ParallelFor(numCandidates, 0, checkPairs);
+		}
+		else
+		{
+			checkPairs(0, numCandidates, 0);
+		}
+		numEvaluations += 1 + numCandidates;
+
+		for (unsigned int t = 0; t < numThreads; t++)
+		{
+			points[t][i] = lowerBound[i];
+		}
+		std::vector<unsigned int> group(1, i);
+		unsigned int numKept = 0;
+		for (unsigned int c = 0; c < numCandidates; c++)
+		{
+			if (interacts[c])
+			{
+				group.push_back(remaining[c + 1]);
+			}
+			else
+			{
+				remaining[numKept++] = remaining[c + 1];
+			}
+		}
+		remaining.resize(numKept);
+		if (group.size() == 1)
+		{
+			separable.push_back(i);
+		}
+		else
+		{
+			groups.push_back(group);
+		}
+	}
+
+	// Separable variables can go together in any way
+	for (size_t begin = 0; begin < separable.size(); begin += groupSize)
+	{
+		size_t end = std::min(begin + groupSize, separable.size());
+		groups.push_back(std::vector<unsigned int>(separable.begin() + begin, separable.begin() + end));
+	}
+	return groups;
+}
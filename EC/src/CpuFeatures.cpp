@@ -0,0 +1,60 @@
+#include "../include/CpuFeatures.hpp"
+#include <atomic>
+
+namespace
+{
+	std::atomic<int> g_maxSimdLevel(EC::SIMD_AVX512);
+}
+
+
+EC::SimdLevel EC::DetectSimdLevel()
+{
+#ifdef EC_SIMD_X86
+	static const SimdLevel detected = []()
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+		{
+			return SIMD_AVX512;
+		}
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return SIMD_AVX2;
+		}
+		if (__builtin_cpu_supports("sse2"))
+		{
+			return SIMD_SSE2;
+		}
+		return SIMD_NONE;
+	}();
+	return detected;
+#else
+	return SIMD_NONE;
+#endif
+}
+
+
+EC::SimdLevel EC::GetSimdLevel()
+{
+	SimdLevel detected = DetectSimdLevel();
+	int maxLevel = g_maxSimdLevel.load(std::memory_order_relaxed);
+	return detected < maxLevel ? detected : static_cast<SimdLevel>(maxLevel);
+}
+
+
+void EC::SetMaxSimdLevel(SimdLevel level)
+{
+	g_maxSimdLevel.store(level, std::memory_order_relaxed);
+}
+
+
+const char* EC::GetSimdLevelName(SimdLevel level)
+{
+	switch (level)
+	{
+	case SIMD_SSE2:   return "SSE2";
+	case SIMD_AVX2:   return "AVX2";
+	case SIMD_AVX512: return "AVX-512";
+	default:          return "scalar";
+	}
+}
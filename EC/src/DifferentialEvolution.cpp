@@ -1,18 +1,32 @@
 #include "../include/DifferentialEvolution.hpp"
 #include "../include/BasePopulation.hpp"
+#include "../include/ContiguousPopulation.hpp"
 #include "../include/RealCodedIndividual.hpp"
+#include "../include/SimdKernels.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include <math.h>
 
 
 
 EC::DifferentialEvolution::DifferentialEvolution() 
-	: m_pElite(NULL), m_diffWeight(0.7), m_crossoverProb(0.2)
+	: m_pElite(NULL), m_diffWeight(0.7), m_crossoverProb(0.2),
+	m_strategy(DE_RAND_1_BIN), m_memoryIndex(0), m_externalArchiveSize(0), m_initialPopulationSize(0),
+	m_pSurrogate(NULL), m_isSurrogateSeeded(false), m_numScreenedOut(0), m_surrogateAccuracy(1),
+	m_screenedProgress(-1), m_unscreenedProgress(-1), m_numSurrogateGenerations(0),
+	m_archiveSize(1), m_isArchiveValid(false), m_pCheckpointWriter(NULL), m_checkpointInterval(0)
 { }
 
 
 EC::DifferentialEvolution::~DifferentialEvolution()
-{ }
+{
+	// Writes the pending checkpoint, if any
+	delete m_pCheckpointWriter;
+	delete m_pElite;
+	delete m_pPopulation;
+	delete m_pOffsprings;
+}
 
 /// \brief Create and initialize a population randomly. Overridden.
 ///		   WARNING: MUST BE CALLED BY OVERRIDDEN FUNCTION.
@@ -28,19 +42,166 @@ void EC::DifferentialEvolution::Initialize(
 {	
 	// Call base method to check the lower and upper bound
 	BaseEvolver<double, double>::Initialize(populationSize, lowerBound, upperBound, pFitnessFunc);
+	if (m_strategy != DE_RAND_1_BIN && populationSize < m_adaptive.minPopulationSize)
+	{
+		throw std::invalid_argument("received population smaller than the minimum population size");
+	}
 	
-	// Create and initialize population
+	// Create and initialize population. The trial buffer is allocated once here and
+	// swapped with the population on every selection.
 	unsigned int problemDim = lowerBound.size();
-	m_pPopulation = new BasePopulation<double, double>(populationSize);
+	delete m_pPopulation;
+	delete m_pOffsprings;
+	m_pOffsprings = new ContiguousPopulation<double, double>(populationSize, problemDim);
+	ContiguousPopulation<double, double>* pPopulation = 
+		new ContiguousPopulation<double, double>(populationSize, problemDim);
 	for(unsigned int i=0; i<populationSize; i++)
 	{		
-		RealCodedIndividual* pIndiv = new RealCodedIndividual(problemDim);
+		double* pGenes = pPopulation->GetChromosome(i);
 		for(unsigned int k=0; k<problemDim; k++)
 		{
-			(*pIndiv)[k] = RandUniform(m_lowerBound[k], m_upperBound[k]);
+			pGenes[k] = RandUniform(m_lowerBound[k], m_upperBound[k]);
 		}		
-		(*m_pPopulation)[i] = pIndiv;
 	}	
+	m_pPopulation = pPopulation;
+
+	m_archive.Reset(m_archiveSize, problemDim);
+	m_isArchiveValid = false;
+	ResetAdaptation(populationSize, problemDim);
+
+	ResetSurrogateState();
+}
+
+
+void EC::DifferentialEvolution::SetPopulation(BasePopulation<double, double>* pop)
+{
+	// Breeding and selection work on the contiguous storage
+	if (pop != NULL && dynamic_cast<ContiguousPopulation<double, double>*>(pop) == NULL)
+	{
+		throw std::invalid_argument("received population that is not a ContiguousPopulation");
+	}
+	if (pop != m_pPopulation)
+	{
+		delete m_pPopulation;
+	}
+	m_pPopulation = pop;
+}
+
+
+void EC::DifferentialEvolution::SetStrategy(DEStrategy strategy, const AdaptiveParameters& parameters)
+{
+	if (!(parameters.pBestRate > 0 && parameters.pBestRate <= 1))
+	{
+		throw std::invalid_argument("received pbest rate out of (0, 1]");
+	}
+	if (!(parameters.archiveRate >= 0))
+	{
+		throw std::invalid_argument("received negative archive rate");
+	}
+	if (parameters.memorySize == 0)
+	{
+		throw std::invalid_argument("received non-positive memory size");
+	}
+	if (!(parameters.learningRate > 0 && parameters.learningRate <= 1))
+	{
+		throw std::invalid_argument("received learning rate out of (0, 1]");
+	}
+	if (parameters.minPopulationSize < 4)
+	{
+		throw std::invalid_argument("received minimum population size smaller than 4");
+	}
+	m_strategy = strategy;
+	m_adaptive = parameters;
+}
+
+
+void EC::DifferentialEvolution::SetSurrogate(BaseSurrogate* pSurrogate, const SurrogateParameters& parameters)
+{
+	if (parameters.candidatesPerTarget == 0)
+	{
+		throw std::invalid_argument("received non-positive number of candidates");
+	}
+	if (!(parameters.minEvaluatedFraction >= 0 && parameters.minEvaluatedFraction <= 1))
+	{
+		throw std::invalid_argument("received evaluated fraction out of [0, 1]");
+	}
+	m_pSurrogate = pSurrogate;
+	m_surrogateParameters = parameters;
+	ResetSurrogateState();
+}
+
+
+void EC::DifferentialEvolution::ResetSurrogateState()
+{
+	m_isSurrogateSeeded = false;
+	m_surrogateAccuracy = 1;
+	m_screenedProgress = -1;
+	m_unscreenedProgress = -1;
+	m_numSurrogateGenerations = 0;
+	if (m_pSurrogate != NULL && !m_lowerBound.empty())
+	{
+		m_pSurrogate->Reset(m_lowerBound, m_upperBound);
+	}
+}
+
+
+void EC::DifferentialEvolution::ResetAdaptation(unsigned int populationSize, unsigned int chromosomeLength)
+{
+	unsigned int numMemories = m_strategy == DE_JADE ? 1 : m_adaptive.memorySize;
+	m_memoryDiffWeight.assign(numMemories, m_adaptive.initialDiffWeight);
+	m_memoryCrossoverProb.assign(numMemories, m_adaptive.initialCrossoverProb);
+	m_memoryIndex = 0;
+	m_trialDiffWeight.assign(populationSize, 0);
+	m_trialCrossoverProb.assign(populationSize, 0);
+	m_successDiffWeight.clear();
+	m_successCrossoverProb.clear();
+	m_successImprovement.clear();
+	m_successDiffWeight.reserve(populationSize);
+	m_successCrossoverProb.reserve(populationSize);
+	m_successImprovement.reserve(populationSize);
+
+	unsigned int archiveCapacity = static_cast<unsigned int>(m_adaptive.archiveRate * populationSize + 0.5);
+	m_externalArchive.assign(m_strategy == DE_RAND_1_BIN ? 0 : static_cast<size_t>(archiveCapacity) * chromosomeLength, 0);
+	m_externalArchiveSize = 0;
+	m_initialPopulationSize = populationSize;
+	m_rankOrder.resize(populationSize);
+	m_donorBase.assign(chromosomeLength, 0);
+}
+
+
+void EC::DifferentialEvolution::SetArchiveSize(unsigned int archiveSize)
+{
+	if (archiveSize == 0)
+	{
+		throw std::invalid_argument("received non-positive archive size");
+	}
+	m_archiveSize = archiveSize;
+	if (m_archive.GetCapacity() != 0)
+	{
+		m_archive.Reset(m_archiveSize, m_archive.GetChromosomeLength());
+		m_isArchiveValid = false;
+	}
+}
+
+
+void EC::DifferentialEvolution::ArchivePopulation()
+{
+	ContiguousPopulation<double, double>* pPopulation = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	if (pPopulation == NULL)
+	{
+		return;
+	}
+	if (m_archive.GetChromosomeLength() != pPopulation->GetChromosomeLength() || m_archive.GetCapacity() == 0)
+	{
+		m_archive.Reset(m_archiveSize, pPopulation->GetChromosomeLength());
+	}
+	const double* pFitness = pPopulation->GetFitnessData();
+	for (unsigned int i = 0; i < pPopulation->Size(); i++)
+	{
+		m_archive.Offer(pPopulation->GetChromosome(i), pFitness[i]);
+	}
+	m_isArchiveValid = true;
 }
 
 
@@ -56,102 +217,1006 @@ bool EC::DifferentialEvolution::CheckStopCriteria()
 
 void EC::DifferentialEvolution::Select()
 {
+	if (m_pOffsprings == NULL)
+	{
+		return;
+	}
+	ContiguousPopulation<double, double>* pPopulation = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	ContiguousPopulation<double, double>* pTrials = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pOffsprings);
+
+	// The first generation starts from the initial population
+	if (!m_isArchiveValid)
+	{
+		ArchivePopulation();
+	}
+
+	// Each trial competes with its target. Targets that survive are copied into the
+	// trial buffer, which then becomes the population. Accepted trials that would enter
+	// the archive are collected per thread, then merged below.
+	unsigned int popSize = pPopulation->Size();
+	double* pTrialFitness = pTrials->GetFitnessData();
+	unsigned int numPartials = m_numThreads == 1 ? 1 : GetThreadPool()->GetNumThreads();
+	if (m_archiveCandidates.size() < numPartials)
+	{
+		m_archiveCandidates.resize(numPartials);
+	}
+	for (unsigned int t = 0; t < numPartials; t++)
+	{
+		m_archiveCandidates[t].clear();
+	}
+	if (m_strategy != DE_RAND_1_BIN)
+	{
+		RecordSuccesses(pPopulation, pTrials);
+	}
+	if (numPartials == 1)
+	{
+		SelectRange(0, popSize, 0);
+	}
+	else
+	{
+		// Only this is captured, so std::function stores it without allocating
+		GetThreadPool()->ParallelFor(popSize, m_chunkSize,
+			[this](unsigned int begin, unsigned int end, unsigned int threadIndex)
+			{
+				SelectRange(begin, end, threadIndex);
+			});
+	}
+
+	// Reduction: best candidates first, so the first rejection ends the merge
+	std::vector<unsigned int>& candidates = m_archiveCandidates[0];
+	for (unsigned int t = 1; t < numPartials; t++)
+	{
+		candidates.insert(candidates.end(), m_archiveCandidates[t].begin(), m_archiveCandidates[t].end());
+	}
+	std::sort(candidates.begin(), candidates.end(),
+		[pTrialFitness](unsigned int a, unsigned int b) { return pTrialFitness[a] < pTrialFitness[b]; });
+	for (size_t c = 0; c < candidates.size() && m_archive.IsCandidate(pTrialFitness[candidates[c]]); c++)
+	{
+		m_archive.Offer(pTrials->GetChromosome(candidates[c]), pTrialFitness[candidates[c]]);
+	}
+
+	std::swap(m_pPopulation, m_pOffsprings);
+
+	if (m_strategy != DE_RAND_1_BIN)
+	{
+		AdaptParameters();
+	}
+	if (m_strategy == DE_LSHADE)
+	{
+		ReducePopulation();
+	}
+}
+
+
+void EC::DifferentialEvolution::SelectRange(unsigned int begin, unsigned int end, unsigned int threadIndex)
+{
+	ContiguousPopulation<double, double>* pPopulation = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	ContiguousPopulation<double, double>* pTrials = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pOffsprings);
+	size_t rowBytes = pPopulation->GetStride() * sizeof(double);
+	const double* pParentFitness = pPopulation->GetFitnessData();
+	double* pTrialFitness = pTrials->GetFitnessData();
+	std::vector<unsigned int>& candidates = m_archiveCandidates[threadIndex];
+	for (unsigned int i = begin; i < end; i++)
+	{
+		if (!(pTrialFitness[i] < pParentFitness[i]))
+		{
+			std::memcpy(pTrials->GetChromosome(i), pPopulation->GetChromosome(i), rowBytes);
+			pTrialFitness[i] = pParentFitness[i];
+		}
+		else if (m_archive.IsCandidate(pTrialFitness[i]))
+		{
+			candidates.push_back(i);
+		}
+	}
+}
+
+
+void EC::DifferentialEvolution::RecordSuccesses(
+	ContiguousPopulation<double, double>* pPopulation,
+	ContiguousPopulation<double, double>* pTrials)
+{
+	m_successDiffWeight.clear();
+	m_successCrossoverProb.clear();
+	m_successImprovement.clear();
+
+	unsigned int popSize = pPopulation->Size();
+	unsigned int indivLength = pPopulation->GetChromosomeLength();
+	unsigned int archiveCapacity = static_cast<unsigned int>(m_externalArchive.size() / indivLength);
+	const double* pParentFitness = pPopulation->GetFitnessData();
+	const double* pTrialFitness = pTrials->GetFitnessData();
+	RandomGenerator& rng = GetRandomGenerator();
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		if (!(pTrialFitness[i] < pParentFitness[i]))
+		{
+			continue;
+		}
+		m_successDiffWeight.push_back(m_trialDiffWeight[i]);
+		m_successCrossoverProb.push_back(m_trialCrossoverProb[i]);
+		m_successImprovement.push_back(pParentFitness[i] - pTrialFitness[i]);
+
+		// The replaced parent goes to the archive, over a random entry once it is full
+		if (archiveCapacity > 0)
+		{
+			unsigned int slot = m_externalArchiveSize < archiveCapacity ? m_externalArchiveSize++ : rng.NextInt(archiveCapacity);
+			std::memcpy(&m_externalArchive[static_cast<size_t>(slot) * indivLength], pPopulation->GetChromosome(i),
+				indivLength * sizeof(double));
+		}
+	}
+}
+
+
+void EC::DifferentialEvolution::AdaptParameters()
+{
+	size_t numSuccesses = m_successDiffWeight.size();
+	if (numSuccesses == 0)
+	{
+		return;
+	}
+
+	// Weights of the successes: uniform for JADE, the fitness improvements for SHADE
+	double totalImprovement = 0;
+	for (size_t s = 0; s < numSuccesses; s++)
+	{
+		totalImprovement += m_successImprovement[s];
+	}
+	bool isWeighted = m_strategy != DE_JADE && totalImprovement > 0 && totalImprovement < HUGE_VAL;
+
+	double sumCrossoverProb = 0, sumSquaredCrossoverProb = 0, maxCrossoverProb = 0;
+	double sumDiffWeight = 0, sumSquaredDiffWeight = 0, sumWeights = 0;
+	for (size_t s = 0; s < numSuccesses; s++)
+	{
+		double weight = isWeighted ? m_successImprovement[s] / totalImprovement : 1.0;
+		double crossoverProb = m_successCrossoverProb[s];
+		double diffWeight = m_successDiffWeight[s];
+		sumWeights += weight;
+		sumCrossoverProb += weight * crossoverProb;
+		sumSquaredCrossoverProb += weight * crossoverProb * crossoverProb;
+		sumDiffWeight += weight * diffWeight;
+		sumSquaredDiffWeight += weight * diffWeight * diffWeight;
+		maxCrossoverProb = std::max(maxCrossoverProb, crossoverProb);
+	}
+	// Lehmer mean for F: biased towards large steps
+	double meanDiffWeight = sumSquaredDiffWeight / sumDiffWeight;
+
+	if (m_strategy == DE_JADE)
+	{
+		double c = m_adaptive.learningRate;
+		m_memoryCrossoverProb[0] = (1 - c) * m_memoryCrossoverProb[0] + c * sumCrossoverProb / sumWeights;
+		m_memoryDiffWeight[0] = (1 - c) * m_memoryDiffWeight[0] + c * meanDiffWeight;
+		return;
+	}
+
+	double& memoryCrossoverProb = m_memoryCrossoverProb[m_memoryIndex];
+	if (m_strategy == DE_LSHADE)
+	{
+		// Once only CR = 0 succeeds, the entry stays frozen at 0
+		if (memoryCrossoverProb < 0 || maxCrossoverProb == 0)
+		{
+			memoryCrossoverProb = -1;
+		}
+		else
+		{
+			memoryCrossoverProb = sumSquaredCrossoverProb / sumCrossoverProb;
+		}
+	}
+	else
+	{
+		memoryCrossoverProb = sumCrossoverProb / sumWeights;
+	}
+	m_memoryDiffWeight[m_memoryIndex] = meanDiffWeight;
+	m_memoryIndex = (m_memoryIndex + 1) % m_memoryDiffWeight.size();
+}
+
+
+void EC::DifferentialEvolution::ReducePopulation()
+{
+	ContiguousPopulation<double, double>* pPopulation = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	ContiguousPopulation<double, double>* pTrials = 
+		static_cast<ContiguousPopulation<double, double>*>(m_pOffsprings);
+	if (m_maxGeneration == 0)
+	{
+		return;
+	}
+
+	// Linear schedule from the initial to the minimum size over the maximum generation
+	unsigned int popSize = pPopulation->Size();
+	double progress = std::min(1.0, (m_generation + 1.0) / m_maxGeneration);
+	double minSize = m_adaptive.minPopulationSize;
+	unsigned int targetSize = static_cast<unsigned int>(
+		m_initialPopulationSize + (minSize - m_initialPopulationSize) * progress + 0.5);
+	if (targetSize >= popSize)
+	{
+		return;
+	}
+
+	// Keep the best targetSize individuals, in their current order. Rows only move
+	// towards the front, so the compaction is done in place.
+	double* pFitness = pPopulation->GetFitnessData();
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		m_rankOrder[i] = i;
+	}
+	std::nth_element(m_rankOrder.begin(), m_rankOrder.begin() + targetSize, m_rankOrder.begin() + popSize,
+		[pFitness](unsigned int a, unsigned int b) { return pFitness[a] < pFitness[b]; });
+	std::sort(m_rankOrder.begin(), m_rankOrder.begin() + targetSize);
+	size_t rowBytes = pPopulation->GetStride() * sizeof(double);
+	for (unsigned int j = 0; j < targetSize; j++)
+	{
+		unsigned int i = m_rankOrder[j];
+		if (i != j)
+		{
+			std::memcpy(pPopulation->GetChromosome(j), pPopulation->GetChromosome(i), rowBytes);
+			pFitness[j] = pFitness[i];
+		}
+	}
+	pPopulation->Truncate(targetSize);
+	pTrials->Truncate(targetSize);
+
+	// The archive shrinks with the population, losing random entries
+	unsigned int indivLength = pPopulation->GetChromosomeLength();
+	unsigned int archiveCapacity = static_cast<unsigned int>(m_adaptive.archiveRate * targetSize + 0.5);
+	RandomGenerator& rng = GetRandomGenerator();
+	while (m_externalArchiveSize > archiveCapacity)
+	{
+		unsigned int victim = rng.NextInt(m_externalArchiveSize);
+		m_externalArchiveSize--;
+		if (victim != m_externalArchiveSize)
+		{
+			std::memcpy(&m_externalArchive[static_cast<size_t>(victim) * indivLength],
+				&m_externalArchive[static_cast<size_t>(m_externalArchiveSize) * indivLength],
+				indivLength * sizeof(double));
+		}
+	}
+	m_externalArchive.resize(static_cast<size_t>(archiveCapacity) * indivLength);
 }
 
 
 void EC::DifferentialEvolution::Breed()
 {
-	if (m_pPopulation == NULL || (*m_pPopulation)[0] == NULL)
+	ContiguousPopulation<double, double>* pPopulation = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	if (pPopulation == NULL || pPopulation->Size() == 0)
 	{
 		throw std::runtime_error("Empty population. Can't do breeding");
 	}
 
-	// Mutation, Crossover and Select
-	unsigned int popSize = m_pPopulation->Size();
-	unsigned int indivLength = (*m_pPopulation)[0]->Size();
+	unsigned int popSize = pPopulation->Size();
+	unsigned int indivLength = pPopulation->GetChromosomeLength();
+
+	// Only reallocated if the population was replaced by SetPopulation
+	ContiguousPopulation<double, double>* pTrials = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pOffsprings);
+	if (pTrials == NULL || pTrials->Size() != popSize || pTrials->GetChromosomeLength() != indivLength)
+	{
+		delete m_pOffsprings;
+		pTrials = new ContiguousPopulation<double, double>(popSize, indivLength);
+		m_pOffsprings = pTrials;
+	}
+
+	unsigned int numMaskWords = (indivLength + 63) / 64;
+	if (m_crossoverMask.size() < numMaskWords)
+	{
+		m_crossoverMask.resize(numMaskWords);
+	}
 
+	bool isChecked = false;  // Generation of a trained surrogate, not screened
+	if (m_pSurrogate != NULL)
+	{
+		// The initial population is the first training set
+		if (!m_isSurrogateSeeded)
+		{
+			const double* pFitness = pPopulation->GetFitnessData();
+			for (unsigned int i = 0; i < popSize; i++)
+			{
+				m_pSurrogate->Add(pPopulation->GetChromosome(i), pFitness[i]);
+			}
+			m_isSurrogateSeeded = true;
+		}
+		unsigned int minTrainingPoints = m_surrogateParameters.minTrainingPoints > 0 ?
+			m_surrogateParameters.minTrainingPoints : 2 * (indivLength + 1);
+		if (m_pSurrogate->Size() >= minTrainingPoints)
+		{
+			if (ChooseScreening())
+			{
+				BreedScreened(pPopulation, pTrials);
+				return;
+			}
+			isChecked = true;
+		}
+	}
+
+	GenerateTrials(pPopulation, pTrials);
+
+	// A trained surrogate is still checked on the trials it doesn't screen, so that
+	// screening resumes once it ranks them well again
+	if (isChecked)
+	{
+		PredictTrials(pPopulation, pTrials);
+	}
+
+	// Evaluate all trials at once, so that they can be spread over threads. A trial
+	// only survives if it beats its parent, so the parent's fitness bounds it.
+	Evaluate(m_pOffsprings, pPopulation->GetFitnessData());
+
+	if (m_pSurrogate != NULL)
+	{
+		const double* pFitness = pTrials->GetFitnessData();
+		if (isChecked)
+		{
+			UpdateSurrogateAccuracy(pPopulation->GetFitnessData(), pFitness, NULL, popSize);
+			RecordProgress(false, pPopulation->GetFitnessData(), pFitness, popSize, popSize);
+		}
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			m_pSurrogate->Add(pTrials->GetChromosome(i), pFitness[i]);
+		}
+	}
+}
+
+
+void EC::DifferentialEvolution::GenerateTrials(
+	ContiguousPopulation<double, double>* pPopulation,
+	ContiguousPopulation<double, double>* pTrials)
+{
+	if (m_strategy != DE_RAND_1_BIN)
+	{
+		BreedAdaptive(pPopulation, pTrials);
+		return;
+	}
+
+	// Mutation and Crossover, written in place into the trial buffer. The crossover
+	// mask is drawn in bulk, then the vectorized kernel blends donor and target.
+	unsigned int popSize = pPopulation->Size();
+	unsigned int indivLength = pPopulation->GetChromosomeLength();
+	uint64_t* pMask = &m_crossoverMask[0];
+	RandomGenerator& rng = GetRandomGenerator();
+
+	int trialIndexes[3];
 	for (unsigned int i = 0; i < popSize; i++)
 	{
-		int* pTrialIndexes = RandIntegerWithoutReplacement(0, popSize, 3);
-		BaseIndividual<double, double>* x0 = (*m_pPopulation)[pTrialIndexes[0]];
-		BaseIndividual<double, double>* x1 = (*m_pPopulation)[pTrialIndexes[1]];
-		BaseIndividual<double, double>* x2 = (*m_pPopulation)[pTrialIndexes[2]];
-		BaseIndividual<double, double>* trial = (*m_pPopulation)[i]->DeepCopy();
+		RandIntegerWithoutReplacement(0, popSize, 3, trialIndexes);
+
+		rng.FillBernoulliMask(pMask, indivLength, m_crossoverProb);
+		unsigned int randIndex = rng.NextInt(indivLength);
+		pMask[randIndex >> 6] |= static_cast<uint64_t>(1) << (randIndex & 63);
+
+		SimdKernels::DifferentialTrial(
+			pPopulation->GetChromosome(i),
+			pPopulation->GetChromosome(trialIndexes[0]),
+			pPopulation->GetChromosome(trialIndexes[1]),
+			pPopulation->GetChromosome(trialIndexes[2]),
+			pMask,
+			indivLength,
+			m_diffWeight,
+			pTrials->GetChromosome(i));
+	}
+}
+
 
-		int* pRandIndex = RandIntegerWithoutReplacement(0, indivLength, 1);
-		for (unsigned int j = 0; j < indivLength; j++)
+void EC::DifferentialEvolution::BreedScreened(
+	ContiguousPopulation<double, double>* pPopulation,
+	ContiguousPopulation<double, double>* pTrials)
+{
+	unsigned int popSize = pPopulation->Size();
+	unsigned int stride = pPopulation->GetStride();
+	unsigned int numCandidates = m_surrogateParameters.candidatesPerTarget;
+	size_t matrixSize = static_cast<size_t>(popSize) * stride;
+	if (m_candidates.size() < numCandidates * matrixSize)
+	{
+		m_candidates.resize(numCandidates * matrixSize);
+		m_candidateDiffWeight.resize(static_cast<size_t>(numCandidates) * popSize);
+		m_candidateCrossoverProb.resize(static_cast<size_t>(numCandidates) * popSize);
+		m_candidateScores.resize(static_cast<size_t>(numCandidates) * popSize);
+		m_screenedRows.resize(popSize);
+	}
+	if (m_predictedGains.size() < popSize)
+	{
+		m_predictedGains.resize(popSize);
+	}
+
+	// Generate the candidates one trial matrix at a time and score them
+	for (unsigned int c = 0; c < numCandidates; c++)
+	{
+		GenerateTrials(pPopulation, pTrials);
+		std::memcpy(&m_candidates[c * matrixSize], pTrials->GetChromosomeData(), matrixSize * sizeof(double));
+		if (m_strategy != DE_RAND_1_BIN)
+		{
+			std::memcpy(&m_candidateDiffWeight[c * popSize], &m_trialDiffWeight[0], popSize * sizeof(double));
+			std::memcpy(&m_candidateCrossoverProb[c * popSize], &m_trialCrossoverProb[0], popSize * sizeof(double));
+		}
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			double mean, std;
+			m_pSurrogate->Predict(pTrials->GetChromosome(i), mean, std);
+			m_candidateScores[c * popSize + i] = mean - m_surrogateParameters.explorationWeight * std;
+		}
+	}
+
+	// Keep the most promising candidate of every target. The last one is in place.
+	const double* pParentFitness = pPopulation->GetFitnessData();
+	double* pTrialFitness = pTrials->GetFitnessData();
+	double* pGains = &m_predictedGains[0];
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		unsigned int best = numCandidates - 1;
+		for (unsigned int c = 0; c + 1 < numCandidates; c++)
 		{
-			if(j == (unsigned int)pRandIndex[0] || RandUniform(0.0, 1.0) < m_crossoverProb)
+			if (m_candidateScores[c * popSize + i] < m_candidateScores[best * popSize + i])
 			{
-				(*trial)[j] = (*x0)[j] + m_diffWeight * ((*x1)[j] - (*x2)[j]);
+				best = c;
 			}
 		}
-		// Evaluate new trial and compare it with the current one
-		Evaluate(trial);
-		if (trial->GetFitness() < (*m_pPopulation)[i]->GetFitness())
+		if (best != numCandidates - 1)
 		{
-			delete (*m_pPopulation)[i];
-			(*m_pPopulation)[i] = trial;
+			std::memcpy(pTrials->GetChromosome(i), &m_candidates[best * matrixSize + static_cast<size_t>(i) * stride],
+				stride * sizeof(double));
+			if (m_strategy != DE_RAND_1_BIN)
+			{
+				m_trialDiffWeight[i] = m_candidateDiffWeight[best * popSize + i];
+				m_trialCrossoverProb[i] = m_candidateCrossoverProb[best * popSize + i];
+			}
 		}
+		pGains[i] = m_candidateScores[best * popSize + i] - pParentFitness[i];
+	}
+
+	// Evaluate the trials predicted to win, and at least a few of the best ranked
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		m_screenedRows[i] = i;
+	}
+	std::sort(m_screenedRows.begin(), m_screenedRows.begin() + popSize,
+		[pGains](unsigned int a, unsigned int b) { return pGains[a] < pGains[b]; });
+	unsigned int minEvaluated = static_cast<unsigned int>(std::ceil(m_surrogateParameters.minEvaluatedFraction * popSize));
+	unsigned int numEvaluated = 0;
+	while (numEvaluated < popSize && (numEvaluated < minEvaluated || pGains[m_screenedRows[numEvaluated]] < 0))
+	{
+		numEvaluated++;
+	}
+	for (unsigned int r = numEvaluated; r < popSize; r++)
+	{
+		pTrialFitness[m_screenedRows[r]] = HUGE_VAL;
+	}
+	m_numScreenedOut += popSize - numEvaluated;
+	std::sort(m_screenedRows.begin(), m_screenedRows.begin() + numEvaluated);
+	Evaluate(pTrials, &m_screenedRows[0], numEvaluated, pParentFitness);
+
+	UpdateSurrogateAccuracy(pParentFitness, pTrialFitness, &m_screenedRows[0], numEvaluated);
+	RecordProgress(true, pParentFitness, pTrialFitness, popSize, numEvaluated);
+	for (unsigned int r = 0; r < numEvaluated; r++)
+	{
+		unsigned int i = m_screenedRows[r];
+		m_pSurrogate->Add(pTrials->GetChromosome(i), pTrialFitness[i]);
 	}
 }
 
 
-void EC::DifferentialEvolution::SaveElite()
+bool EC::DifferentialEvolution::ChooseScreening()
 {
-	// Smaller, better
-	double minValue = 1e100;
-	int minIndex = 0;
-	int popSize = m_pPopulation->Size();
-	for (int i = 0; i < popSize; i++)
+	if (m_surrogateAccuracy < m_surrogateParameters.minRankAccuracy)
+	{
+		return false;
+	}
+	// The mode that progresses faster, and the other one every probeInterval generations
+	bool isScreenedFaster = !(m_unscreenedProgress > m_screenedProgress);
+	unsigned int probeInterval = m_surrogateParameters.probeInterval;
+	m_numSurrogateGenerations++;
+	bool isProbe = probeInterval > 0 && m_numSurrogateGenerations % probeInterval == 0;
+	return isScreenedFaster != isProbe;
+}
+
+
+void EC::DifferentialEvolution::RecordProgress(
+	bool isScreened,
+	const double* pParentFitness,
+	const double* pTrialFitness,
+	unsigned int popSize,
+	unsigned int numEvaluated)
+{
+	// Fitness gained per evaluation, in units of the spread of the parents' fitness so
+	// that generations far apart in the run compare
+	double sumFitness = 0, bestFitness = HUGE_VAL, gain = 0;
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		sumFitness += pParentFitness[i];
+		bestFitness = std::min(bestFitness, pParentFitness[i]);
+		if (pTrialFitness[i] < pParentFitness[i])
+		{
+			gain += pParentFitness[i] - pTrialFitness[i];
+		}
+	}
+	double spread = sumFitness / popSize - bestFitness;
+	if (numEvaluated == 0 || !(spread > 0 && spread < HUGE_VAL && gain < HUGE_VAL))
+	{
+		return;
+	}
+	double progress = gain / (spread * numEvaluated);
+	double& average = isScreened ? m_screenedProgress : m_unscreenedProgress;
+	const double rate = 0.3;  // Weight of the last generation in the moving average
+	average = average < 0 ? progress : average + rate * (progress - average);
+}
+
+
+void EC::DifferentialEvolution::PredictTrials(
+	ContiguousPopulation<double, double>* pPopulation,
+	ContiguousPopulation<double, double>* pTrials)
+{
+	unsigned int popSize = pPopulation->Size();
+	if (m_predictedGains.size() < popSize)
+	{
+		m_predictedGains.resize(popSize);
+	}
+	const double* pParentFitness = pPopulation->GetFitnessData();
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		double mean, std;
+		m_pSurrogate->Predict(pTrials->GetChromosome(i), mean, std);
+		m_predictedGains[i] = mean - m_surrogateParameters.explorationWeight * std - pParentFitness[i];
+	}
+}
+
+
+void EC::DifferentialEvolution::UpdateSurrogateAccuracy(
+	const double* pParentFitness,
+	const double* pTrialFitness,
+	const unsigned int* pRows,
+	unsigned int numRows)
+{
+	// Area under the ROC curve of the predicted gains, as a classifier of the trials
+	// that beat their target. Only the outcome is used: it is exact even when the
+	// evaluation of a failed trial was aborted early.
+	const double* pGains = &m_predictedGains[0];
+	unsigned long long numPairs = 0;
+	double numConcordant = 0;
+	for (unsigned int a = 0; a < numRows; a++)
 	{
-		if ((*m_pPopulation)[i]->GetFitness() < minValue)
+		unsigned int i = pRows != NULL ? pRows[a] : a;
+		if (!(pTrialFitness[i] < pParentFitness[i]))
 		{
-			minValue = (*m_pPopulation)[i]->GetFitness();
-			minIndex = i;
+			continue;
 		}
+		for (unsigned int b = 0; b < numRows; b++)
+		{
+			unsigned int j = pRows != NULL ? pRows[b] : b;
+			if (pTrialFitness[j] < pParentFitness[j])
+			{
+				continue;
+			}
+			numPairs++;
+			numConcordant += pGains[i] < pGains[j] ? 1.0 : (pGains[i] == pGains[j] ? 0.5 : 0.0);
+		}
+	}
+	if (numPairs > 0)
+	{
+		const double rate = 0.3;  // Weight of the last generation in the moving average
+		m_surrogateAccuracy += rate * (numConcordant / numPairs - m_surrogateAccuracy);
+	}
+}
+
+
+void EC::DifferentialEvolution::BreedAdaptive(
+	ContiguousPopulation<double, double>* pPopulation,
+	ContiguousPopulation<double, double>* pTrials)
+{
+	unsigned int popSize = pPopulation->Size();
+	unsigned int indivLength = pPopulation->GetChromosomeLength();
+	if (popSize < 3)
+	{
+		throw std::runtime_error("Population too small for current-to-pbest/1");
+	}
+	// Only reset if the population was replaced by SetPopulation
+	if (m_donorBase.size() != indivLength || m_rankOrder.size() < popSize)
+	{
+		ResetAdaptation(popSize, indivLength);
 	}
-	m_pElite = (*m_pPopulation)[minIndex];
 
-	std::cout << m_pElite->GetFitness() << std::endl;
+	// The pbest individual is one of the best p * N, at least two
+	const double* pFitness = pPopulation->GetFitnessData();
+	unsigned int numBest = static_cast<unsigned int>(m_adaptive.pBestRate * popSize + 0.5);
+	numBest = std::min(std::max(numBest, 2u), popSize);
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		m_rankOrder[i] = i;
+	}
+	std::partial_sort(m_rankOrder.begin(), m_rankOrder.begin() + numBest, m_rankOrder.begin() + popSize,
+		[pFitness](unsigned int a, unsigned int b) { return pFitness[a] < pFitness[b]; });
+
+	uint64_t* pMask = &m_crossoverMask[0];
+	double* pDonorBase = &m_donorBase[0];
+	RandomGenerator& rng = GetRandomGenerator();
+	unsigned int numMemories = static_cast<unsigned int>(m_memoryDiffWeight.size());
+	for (unsigned int i = 0; i < popSize; i++)
+	{
+		// F and CR around a random entry of the history
+		unsigned int r = numMemories == 1 ? 0 : rng.NextInt(numMemories);
+		double crossoverProb = 0;
+		if (m_memoryCrossoverProb[r] >= 0)
+		{
+			crossoverProb = std::min(1.0, std::max(0.0, rng.Normal(m_memoryCrossoverProb[r], 0.1)));
+		}
+		double diffWeight;
+		do
+		{
+			diffWeight = rng.Cauchy(m_memoryDiffWeight[r], 0.1);
+		} while (!(diffWeight > 0));
+		diffWeight = std::min(diffWeight, 1.0);
+		m_trialDiffWeight[i] = diffWeight;
+		m_trialCrossoverProb[i] = crossoverProb;
+
+		// current-to-pbest/1: x_i + F (x_pbest - x_i) + F (x_r1 - x_r2), with x_r2 drawn
+		// from the population and the archive
+		unsigned int best = m_rankOrder[rng.NextInt(numBest)];
+		unsigned int r1, r2;
+		do
+		{
+			r1 = rng.NextInt(popSize);
+		} while (r1 == i);
+		do
+		{
+			r2 = rng.NextInt(popSize + m_externalArchiveSize);
+		} while (r2 == i || r2 == r1);
+		const double* pX2 = r2 < popSize ? pPopulation->GetChromosome(r2) :
+			&m_externalArchive[static_cast<size_t>(r2 - popSize) * indivLength];
+
+		const double* pTarget = pPopulation->GetChromosome(i);
+		const double* pBest = pPopulation->GetChromosome(best);
+		for (unsigned int k = 0; k < indivLength; k++)
+		{
+			pDonorBase[k] = pTarget[k] + diffWeight * (pBest[k] - pTarget[k]);
+		}
+
+		rng.FillBernoulliMask(pMask, indivLength, crossoverProb);
+		unsigned int randIndex = rng.NextInt(indivLength);
+		pMask[randIndex >> 6] |= static_cast<uint64_t>(1) << (randIndex & 63);
+
+		double* pTrial = pTrials->GetChromosome(i);
+		SimdKernels::DifferentialTrial(pTarget, pDonorBase, pPopulation->GetChromosome(r1), pX2,
+			pMask, indivLength, diffWeight, pTrial);
+
+		// Genes out of the domain are put halfway between the bound and the target
+		for (unsigned int k = 0; k < indivLength; k++)
+		{
+			if (pTrial[k] < m_lowerBound[k])
+			{
+				pTrial[k] = 0.5 * (m_lowerBound[k] + pTarget[k]);
+			}
+			else if (pTrial[k] > m_upperBound[k])
+			{
+				pTrial[k] = 0.5 * (m_upperBound[k] + pTarget[k]);
+			}
+		}
+	}
+}
+
+
+void EC::DifferentialEvolution::SaveElite()
+{
+	// The archive is kept up to date by Select: no scan of the population
+	if (!m_isArchiveValid)
+	{
+		ArchivePopulation();
+	}
+	if (m_archive.Size() == 0)
+	{
+		return;
+	}
+
+	// Keep a copy. The archive may change in later generations.
+	int length = static_cast<int>(m_archive.GetChromosomeLength());
+	if (m_pElite == NULL || m_pElite->Size() != length)
+	{
+		delete m_pElite;
+		m_pElite = new RealCodedIndividual(length);
+	}
+	const double* pBest = m_archive.GetChromosome(0);
+	for (int k = 0; k < length; k++)
+	{
+		(*m_pElite)[k] = pBest[k];
+	}
+	m_pElite->SetFitness(m_archive.GetFitness(0));
 }
 
 
 
 // Generate a few random integers without replacement
-int* EC::DifferentialEvolution::RandIntegerWithoutReplacement(
+void EC::DifferentialEvolution::RandIntegerWithoutReplacement(
 	unsigned int min,
 	unsigned int max,
-	unsigned int numInteger
+	unsigned int numInteger,
+	int* pIntegers
 	)
 {
-	int* intArr = new int[numInteger];
-	intArr[0] = std::floor(RandUniform(min, max));
-	unsigned int count = 1;
-	for (unsigned int i = 1; i < numInteger; i++)
+	for (unsigned int i = 0; i < numInteger; i++)
 	{
 		bool integerIsGood = false;
 		while (!integerIsGood)
 		{
-			int val = static_cast<int>(RandUniform(min, max));
+			int val = static_cast<int>(min + GetRandomGenerator().NextInt(max - min));
 			// Check whether val is good
 			integerIsGood = true;
-			for (unsigned int j = 0; j < count; j++)
+			for (unsigned int j = 0; j < i; j++)
 			{
-				if (val == intArr[j])
+				if (val == pIntegers[j])
 				{ 
 					integerIsGood = false; 
 					break;
 				}
 			}				
-			intArr[i] = val;
+			pIntegers[i] = val;
 		}
-		count++;
 	}
-	return intArr;
 }
 
 EC::BaseIndividual<double, double>* EC::DifferentialEvolution::GetElite()
 {
 	return m_pElite;
 }
+
+
+bool EC::DifferentialEvolution::Immigrate(const double* pGenes, double fitness)
+{
+	ContiguousPopulation<double, double>* pPopulation = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	if (pPopulation == NULL || pPopulation->Size() == 0)
+	{
+		throw std::runtime_error("Empty population. Can't take immigrants");
+	}
+
+	// Smaller, better
+	double* pFitness = pPopulation->GetFitnessData();
+	unsigned int popSize = pPopulation->Size();
+	unsigned int worstIndex = 0;
+	for (unsigned int i = 1; i < popSize; i++)
+	{
+		if (pFitness[i] > pFitness[worstIndex])
+		{
+			worstIndex = i;
+		}
+	}
+	if (!(fitness < pFitness[worstIndex]))
+	{
+		return false;
+	}
+
+	unsigned int length = pPopulation->GetChromosomeLength();
+	std::memcpy(pPopulation->GetChromosome(worstIndex), pGenes, length * sizeof(double));
+	pFitness[worstIndex] = fitness;
+
+	if (m_isArchiveValid)
+	{
+		m_archive.Offer(pGenes, fitness);
+	}
+	if (m_pSurrogate != NULL && m_isSurrogateSeeded)
+	{
+		m_pSurrogate->Add(pGenes, fitness);
+	}
+	if (m_pElite != NULL && fitness < m_pElite->GetFitness())
+	{
+		for (unsigned int k = 0; k < length; k++)
+		{
+			(*m_pElite)[k] = pGenes[k];
+		}
+		m_pElite->SetFitness(fitness);
+	}
+	return true;
+}
+
+
+void EC::DifferentialEvolution::Step()
+{
+	BaseEvolver<double, double>::Step();
+	m_archive.Publish(m_generation);
+
+	if (m_checkpointInterval > 0 && m_generation % m_checkpointInterval == 0)
+	{
+		if (m_pCheckpointWriter == NULL)
+		{
+			m_pCheckpointWriter = new CheckpointWriter();
+		}
+		CaptureState(m_checkpointState);
+		m_pCheckpointWriter->Submit(m_checkpointPath, m_checkpointState);
+	}
+}
+
+
+void EC::DifferentialEvolution::SetCheckpointing(const std::string& path, unsigned int interval)
+{
+	m_checkpointPath = path;
+	m_checkpointInterval = interval;
+}
+
+
+void EC::DifferentialEvolution::FlushCheckpoints()
+{
+	if (m_pCheckpointWriter != NULL)
+	{
+		m_pCheckpointWriter->Flush();
+	}
+}
+
+
+void EC::DifferentialEvolution::SaveCheckpoint(const std::string& path)
+{
+	CheckpointState state;
+	CaptureState(state);
+	WriteCheckpoint(path, state);
+}
+
+
+void EC::DifferentialEvolution::CaptureState(CheckpointState& state)
+{
+	ContiguousPopulation<double, double>* pPopulation = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	if (pPopulation == NULL)
+	{
+		throw std::runtime_error("Empty population. Nothing to checkpoint");
+	}
+
+	state.populationSize = pPopulation->Size();
+	state.chromosomeLength = pPopulation->GetChromosomeLength();
+	state.stride = pPopulation->GetStride();
+	state.generation = m_generation;
+	state.maxGeneration = m_maxGeneration;
+	state.seed = GetSeed();
+	state.numEvaluations = m_numEvaluations;
+	GetRandomGenerator().GetState(state.randomState);
+	state.diffWeight = m_diffWeight;
+	state.crossoverProb = m_crossoverProb;
+	state.lowerBound = m_lowerBound;
+	state.upperBound = m_upperBound;
+
+	state.strategy = m_strategy;
+	state.pBestRate = m_adaptive.pBestRate;
+	state.archiveRate = m_adaptive.archiveRate;
+	state.memorySize = m_adaptive.memorySize;
+	state.learningRate = m_adaptive.learningRate;
+	state.initialDiffWeight = m_adaptive.initialDiffWeight;
+	state.initialCrossoverProb = m_adaptive.initialCrossoverProb;
+	state.minPopulationSize = m_adaptive.minPopulationSize;
+	state.memoryIndex = m_memoryIndex;
+	state.initialPopulationSize = m_initialPopulationSize;
+	state.memoryDiffWeight.clear();
+	state.memoryCrossoverProb.clear();
+	state.externalArchive.clear();
+	state.archiveCapacity = 0;
+	if (m_strategy != DE_RAND_1_BIN)
+	{
+		state.memoryDiffWeight = m_memoryDiffWeight;
+		state.memoryCrossoverProb = m_memoryCrossoverProb;
+		state.archiveCapacity = static_cast<unsigned int>(m_externalArchive.size() / state.chromosomeLength);
+		state.externalArchive.assign(m_externalArchive.begin(),
+			m_externalArchive.begin() + static_cast<size_t>(m_externalArchiveSize) * state.chromosomeLength);
+	}
+
+	state.hasElite = m_pElite != NULL;
+	state.eliteFitness = 0;
+	state.eliteChromosome.clear();
+	if (state.hasElite)
+	{
+		state.eliteFitness = m_pElite->GetFitness();
+		for (int k = 0; k < m_pElite->Size(); k++)
+		{
+			state.eliteChromosome.push_back((*m_pElite)[k]);
+		}
+	}
+
+	// The whole matrix in one copy, padding included
+	const double* pFitness = pPopulation->GetFitnessData();
+	state.fitness.assign(pFitness, pFitness + state.populationSize);
+	const double* pGenes = pPopulation->GetChromosomeData();
+	state.genes.assign(pGenes, pGenes + static_cast<size_t>(state.populationSize) * state.stride);
+}
+
+
+void EC::DifferentialEvolution::LoadCheckpoint(
+	const std::string& path,
+	BaseFitnessFunctor<double, double>* pFitnessFunc)
+{
+	MappedCheckpoint checkpoint(path);
+	const CheckpointHeader& header = checkpoint.GetHeader();
+	unsigned int popSize = header.populationSize;
+	unsigned int problemDim = header.chromosomeLength;
+
+	std::vector<double> lowerBound(checkpoint.GetLowerBound(), checkpoint.GetLowerBound() + problemDim);
+	std::vector<double> upperBound(checkpoint.GetUpperBound(), checkpoint.GetUpperBound() + problemDim);
+	BaseEvolver<double, double>::Initialize(popSize, lowerBound, upperBound, pFitnessFunc);
+
+	// Copy the mapped sections straight into the population buffer
+	ContiguousPopulation<double, double>* pPopulation = 
+		dynamic_cast<ContiguousPopulation<double, double>*>(m_pPopulation);
+	if (pPopulation == NULL || pPopulation->Size() != popSize || pPopulation->GetChromosomeLength() != problemDim)
+	{
+		delete m_pPopulation;
+		delete m_pOffsprings;
+		m_pOffsprings = new ContiguousPopulation<double, double>(popSize, problemDim);
+		pPopulation = new ContiguousPopulation<double, double>(popSize, problemDim);
+		m_pPopulation = pPopulation;
+	}
+	if (pPopulation->GetStride() == header.stride)
+	{
+		std::memcpy(pPopulation->GetChromosomeData(), checkpoint.GetGenes(),
+			static_cast<size_t>(popSize) * header.stride * sizeof(double));
+	}
+	else
+	{
+		// Written by a build with another SIMD padding
+		for (unsigned int i = 0; i < popSize; i++)
+		{
+			std::memcpy(pPopulation->GetChromosome(i), checkpoint.GetGenes() + static_cast<size_t>(i) * header.stride,
+				problemDim * sizeof(double));
+		}
+	}
+	std::memcpy(pPopulation->GetFitnessData(), checkpoint.GetFitness(), popSize * sizeof(double));
+
+	delete m_pElite;
+	m_pElite = NULL;
+	if (header.hasElite)
+	{
+		m_pElite = new RealCodedIndividual(problemDim);
+		for (unsigned int k = 0; k < problemDim; k++)
+		{
+			(*m_pElite)[k] = checkpoint.GetEliteChromosome()[k];
+		}
+		m_pElite->SetFitness(header.eliteFitness);
+	}
+	// Rebuilt from the population at the next selection
+	m_archive.Reset(m_archiveSize, problemDim);
+	m_isArchiveValid = false;
+	if (m_pElite != NULL)
+	{
+		m_archive.Offer(checkpoint.GetEliteChromosome(), header.eliteFitness);
+	}
+
+	// Strategy and adaptation state: memories of F and CR, external archive
+	AdaptiveParameters adaptive;
+	adaptive.pBestRate = header.pBestRate;
+	adaptive.archiveRate = header.archiveRate;
+	adaptive.memorySize = header.memorySize;
+	adaptive.learningRate = header.learningRate;
+	adaptive.initialDiffWeight = header.initialDiffWeight;
+	adaptive.initialCrossoverProb = header.initialCrossoverProb;
+	adaptive.minPopulationSize = header.minPopulationSize;
+	if (header.strategy > DE_LSHADE)
+	{
+		throw std::runtime_error("Unknown strategy in checkpoint " + path);
+	}
+	DEStrategy strategy = static_cast<DEStrategy>(header.strategy);
+	if (strategy == DE_RAND_1_BIN)
+	{
+		m_strategy = DE_RAND_1_BIN;
+		ResetAdaptation(popSize, problemDim);
+	}
+	else
+	{
+		SetStrategy(strategy, adaptive);
+		ResetAdaptation(header.initialPopulationSize, problemDim);
+		if (header.numMemories != m_memoryDiffWeight.size() || header.memoryIndex >= header.numMemories ||
+			header.initialPopulationSize < popSize)
+		{
+			throw std::runtime_error("Inconsistent adaptation state in checkpoint " + path);
+		}
+		std::copy(checkpoint.GetMemoryDiffWeight(), checkpoint.GetMemoryDiffWeight() + header.numMemories,
+			m_memoryDiffWeight.begin());
+		std::copy(checkpoint.GetMemoryCrossoverProb(), checkpoint.GetMemoryCrossoverProb() + header.numMemories,
+			m_memoryCrossoverProb.begin());
+		m_memoryIndex = header.memoryIndex;
+		m_externalArchive.assign(static_cast<size_t>(header.archiveCapacity) * problemDim, 0);
+		std::copy(checkpoint.GetExternalArchive(),
+			checkpoint.GetExternalArchive() + static_cast<size_t>(header.archiveSize) * problemDim,
+			m_externalArchive.begin());
+		m_externalArchiveSize = header.archiveSize;
+	}
+	ResetSurrogateState();
+	m_diffWeight = header.diffWeight;
+	m_crossoverProb = header.crossoverProb;
+	m_generation = header.generation;
+	m_maxGeneration = header.maxGeneration;
+	m_numEvaluations = header.numEvaluations;
+	SetSeed(header.seed);
+	GetRandomGenerator().SetState(header.randomState);
+}
@@ -0,0 +1,140 @@
+#include "../include/EliteArchive.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+
+EC::EliteArchive::EliteArchive()
+	: m_capacity(0), m_chromosomeLength(0), m_size(0), m_sequence(0), m_publishedGeneration(0),
+	m_publishedSize(0)
+{ }
+
+
+void EC::EliteArchive::Reset(unsigned int capacity, unsigned int chromosomeLength)
+{
+	if (capacity == 0)
+	{
+		throw std::invalid_argument("received non-positive archive capacity");
+	}
+	m_capacity = capacity;
+	m_chromosomeLength = chromosomeLength;
+	m_size = 0;
+	m_fitness.assign(capacity, 0);
+	m_genes.assign(static_cast<size_t>(capacity) * chromosomeLength, 0);
+
+	m_pPublishedFitness.reset(new std::atomic<double>[capacity]);
+	m_pPublishedGenes.reset(new std::atomic<double>[static_cast<size_t>(capacity) * chromosomeLength]);
+	m_publishedSize.store(0, std::memory_order_relaxed);
+	m_sequence.store(0, std::memory_order_release);
+}
+
+
+void EC::EliteArchive::Clear()
+{
+	m_size = 0;
+}
+
+
+bool EC::EliteArchive::Offer(const double* pGenes, double fitness)
+{
+	if (!IsCandidate(fitness))
+	{
+		return false;
+	}
+
+	// Rank of the newcomer: after every solution that is not worse
+	unsigned int rank = m_size;
+	while (rank > 0 && !(m_fitness[rank - 1] <= fitness))
+	{
+		rank--;
+	}
+	size_t rowBytes = m_chromosomeLength * sizeof(double);
+	for (unsigned int r = rank; r > 0 && m_fitness[r - 1] == fitness; r--)
+	{
+		if (std::memcmp(GetChromosome(r - 1), pGenes, rowBytes) == 0)
+		{
+			return false;
+		}
+	}
+
+	// Shift the worse ones down, dropping the last one if full
+	unsigned int last = m_size < m_capacity ? m_size : m_capacity - 1;
+	for (unsigned int r = last; r > rank; r--)
+	{
+		m_fitness[r] = m_fitness[r - 1];
+		std::memcpy(&m_genes[static_cast<size_t>(r) * m_chromosomeLength], GetChromosome(r - 1), rowBytes);
+	}
+	m_fitness[rank] = fitness;
+	std::memcpy(&m_genes[static_cast<size_t>(rank) * m_chromosomeLength], pGenes, rowBytes);
+	if (m_size < m_capacity)
+	{
+		m_size++;
+	}
+	return true;
+}
+
+
+void EC::EliteArchive::Publish(unsigned int generation)
+{
+	if (m_capacity == 0)
+	{
+		return;
+	}
+	unsigned long long sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	m_publishedGeneration.store(generation, std::memory_order_relaxed);
+	m_publishedSize.store(m_size, std::memory_order_relaxed);
+	for (unsigned int r = 0; r < m_size; r++)
+	{
+		m_pPublishedFitness[r].store(m_fitness[r], std::memory_order_relaxed);
+	}
+	size_t numGenes = static_cast<size_t>(m_size) * m_chromosomeLength;
+	for (size_t k = 0; k < numGenes; k++)
+	{
+		m_pPublishedGenes[k].store(m_genes[k], std::memory_order_relaxed);
+	}
+
+	m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+bool EC::EliteArchive::ReadSnapshot(EliteSnapshot& snapshot) const
+{
+	while (true)
+	{
+		unsigned long long sequence = m_sequence.load(std::memory_order_acquire);
+		if (sequence == 0)
+		{
+			return false;
+		}
+		if (sequence & 1)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		unsigned int size = m_publishedSize.load(std::memory_order_relaxed);
+		snapshot.generation = m_publishedGeneration.load(std::memory_order_relaxed);
+		snapshot.size = size;
+		snapshot.chromosomeLength = m_chromosomeLength;
+		snapshot.fitness.resize(size);
+		for (unsigned int r = 0; r < size; r++)
+		{
+			snapshot.fitness[r] = m_pPublishedFitness[r].load(std::memory_order_relaxed);
+		}
+		size_t numGenes = static_cast<size_t>(size) * m_chromosomeLength;
+		snapshot.genes.resize(numGenes);
+		for (size_t k = 0; k < numGenes; k++)
+		{
+			snapshot.genes[k] = m_pPublishedGenes[k].load(std::memory_order_relaxed);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(std::memory_order_relaxed) == sequence)
+		{
+			return true;
+		}
+	}
+}
@@ -0,0 +1,287 @@
+#include "../include/IslandModel.hpp"
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+
+EC::IslandModel::IslandModel(unsigned int numIslands, MigrationTopology topology)
+	: m_topology(topology), m_migrationInterval(10), m_migrationBufferSize(4),
+	m_numMigrations(0), m_pElite(NULL)
+{
+	if (numIslands == 0)
+	{
+		throw std::invalid_argument("received non-positive number of islands");
+	}
+	for (unsigned int i = 0; i < numIslands; i++)
+	{
+		m_islands.push_back(new DifferentialEvolution());
+	}
+
+	std::random_device randDevice;
+	m_seed = (static_cast<unsigned long long>(randDevice()) << 32) ^ randDevice();
+
+	m_neighbours = BuildTopology(numIslands, topology);
+}
+
+
+EC::IslandModel::~IslandModel()
+{
+	ReleaseChannels();
+	for (size_t i = 0; i < m_islands.size(); i++)
+	{
+		delete m_islands[i];
+	}
+	delete m_pElite;
+}
+
+
+void EC::IslandModel::ReleaseChannels()
+{
+	for (size_t i = 0; i < m_channels.size(); i++)
+	{
+		delete m_channels[i];
+	}
+	m_channels.clear();
+	m_outgoingChannels.clear();
+	m_incomingChannels.clear();
+}
+
+
+void EC::IslandModel::BuildChannels()
+{
+	ReleaseChannels();
+	unsigned int numIslands = GetNumIslands();
+	m_outgoingChannels.resize(numIslands);
+	m_incomingChannels.resize(numIslands);
+	for (unsigned int i = 0; i < numIslands; i++)
+	{
+		for (size_t k = 0; k < m_neighbours[i].size(); k++)
+		{
+			unsigned int channel = static_cast<unsigned int>(m_channels.size());
+			SpscQueue<Migrant>* pChannel = new SpscQueue<Migrant>(m_migrationBufferSize);
+			m_channels.push_back(pChannel);
+			m_outgoingChannels[i].push_back(channel);
+			m_incomingChannels[m_neighbours[i][k]].push_back(channel);
+		}
+	}
+}
+
+
+void EC::IslandModel::Evolve(
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	unsigned int maxGeneration,
+	bool verbose)
+{
+	unsigned int numIslands = GetNumIslands();
+	BuildChannels();
+	m_numMigrations = 0;
+
+	// One thread per island. Errors are collected and the first one is rethrown.
+	std::vector<std::exception_ptr> errors(numIslands);
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < numIslands; i++)
+	{
+		threads.push_back(std::thread([=, &errors, &lowerBound, &upperBound]()
+		{
+			try
+			{
+				RunIsland(i, populationSize, lowerBound, upperBound, pFitnessFunc, maxGeneration);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		}));
+	}
+	for (unsigned int i = 0; i < numIslands; i++)
+	{
+		threads[i].join();
+	}
+	for (unsigned int i = 0; i < numIslands; i++)
+	{
+		if (errors[i])
+		{
+			std::rethrow_exception(errors[i]);
+		}
+	}
+
+	// Best over all islands
+	BaseIndividual<double, double>* pBest = NULL;
+	for (unsigned int i = 0; i < numIslands; i++)
+	{
+		BaseIndividual<double, double>* pElite = m_islands[i]->GetElite();
+		if (pElite != NULL && (pBest == NULL || pElite->GetFitness() < pBest->GetFitness()))
+		{
+			pBest = pElite;
+		}
+	}
+	if (pBest != NULL)
+	{
+		delete m_pElite;
+		m_pElite = static_cast<RealCodedIndividual*>(pBest->DeepCopy());
+	}
+
+	if (verbose && m_pElite != NULL)
+	{
+		std::cout << "Islands: " << numIslands 
+			<< ", migrants accepted: " << GetNumMigrations()
+			<< ", best fitness: " << m_pElite->GetFitness() << std::endl;
+	}
+}
+
+
+void EC::IslandModel::RunIsland(
+	unsigned int island,
+	unsigned int populationSize,
+	std::vector<double> lowerBound,
+	std::vector<double> upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	unsigned int maxGeneration)
+{
+	DifferentialEvolution* pIsland = m_islands[island];
+	pIsland->SetSeed(RandomGenerator(m_seed, island).Next());
+	pIsland->SetNumThreads(1);
+	pIsland->Initialize(populationSize, lowerBound, upperBound, pFitnessFunc);
+	pIsland->SetMaxGeneration(maxGeneration);
+	pIsland->Start(false);
+
+	const std::vector<unsigned int>& outgoing = m_outgoingChannels[island];
+	const std::vector<unsigned int>& incoming = m_incomingChannels[island];
+	Migrant migrant;
+	migrant.genes.resize(lowerBound.size());
+
+	// The island's own stop criteria, set through GetIsland, can end it early
+	while (!pIsland->ShouldStop())
+	{
+		pIsland->Step();
+
+		if (m_migrationInterval == 0 || pIsland->GetGeneration() % m_migrationInterval != 0)
+		{
+			continue;
+		}
+
+		// Emigration: the elite goes to every neighbour that has room
+		BaseIndividual<double, double>* pElite = pIsland->GetElite();
+		for (size_t k = 0; k < migrant.genes.size(); k++)
+		{
+			migrant.genes[k] = (*pElite)[k];
+		}
+		migrant.fitness = pElite->GetFitness();
+		for (size_t k = 0; k < outgoing.size(); k++)
+		{
+			m_channels[outgoing[k]]->TryPush(migrant);
+		}
+
+		// Immigration: whatever has arrived so far
+		for (size_t k = 0; k < incoming.size(); k++)
+		{
+			while (m_channels[incoming[k]]->TryPop(migrant))
+			{
+				if (pIsland->Immigrate(&migrant.genes[0], migrant.fitness))
+				{
+					m_numMigrations++;
+				}
+			}
+		}
+	}
+}
+
+
+std::vector<std::vector<unsigned int> > EC::IslandModel::BuildTopology(
+	unsigned int numIslands, 
+	MigrationTopology topology)
+{
+	std::vector<std::vector<unsigned int> > edges(numIslands);
+	for (unsigned int i = 0; i < numIslands && numIslands > 1; i++)
+	{
+		std::vector<unsigned int>& neighbours = edges[i];
+		if (topology == TOPOLOGY_RING)
+		{
+			neighbours.push_back((i + 1) % numIslands);
+		}
+		else if (topology == TOPOLOGY_TORUS)
+		{
+			// Most square grid: rows is the largest divisor not above sqrt(numIslands)
+			unsigned int rows = static_cast<unsigned int>(std::sqrt(static_cast<double>(numIslands)));
+			while (numIslands % rows != 0)
+			{
+				rows--;
+			}
+			unsigned int cols = numIslands / rows;
+			unsigned int r = i / cols;
+			unsigned int c = i % cols;
+			unsigned int candidates[4] = {
+				((r + rows - 1) % rows) * cols + c,
+				((r + 1) % rows) * cols + c,
+				r * cols + (c + cols - 1) % cols,
+				r * cols + (c + 1) % cols
+			};
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				bool isNew = candidates[k] != i;
+				for (size_t m = 0; m < neighbours.size(); m++)
+				{
+					isNew = isNew && neighbours[m] != candidates[k];
+				}
+				if (isNew)
+				{
+					neighbours.push_back(candidates[k]);
+				}
+			}
+		}
+		else
+		{
+			for (unsigned int k = 0; k < numIslands; k++)
+			{
+				if (k != i)
+				{
+					neighbours.push_back(k);
+				}
+			}
+		}
+	}
+	return edges;
+}
+
+
+EC::BaseIndividual<double, double>* EC::IslandModel::GetElite()
+{
+	return m_pElite;
+}
+
+
+EC::DifferentialEvolution* EC::IslandModel::GetIsland(unsigned int island)
+{
+	if (island >= m_islands.size())
+	{
+		throw std::out_of_range("Index out of bound");
+	}
+	return m_islands[island];
+}
+
+
+const std::vector<unsigned int>& EC::IslandModel::GetNeighbours(unsigned int island) const
+{
+	if (island >= m_neighbours.size())
+	{
+		throw std::out_of_range("Index out of bound");
+	}
+	return m_neighbours[island];
+}
+
+
+unsigned long long EC::IslandModel::GetNumEvaluations() const
+{
+	unsigned long long numEvaluations = 0;
+	for (size_t i = 0; i < m_islands.size(); i++)
+	{
+		numEvaluations += m_islands[i]->GetNumEvaluations();
+	}
+	return numEvaluations;
+}
@@ -0,0 +1,515 @@
+#include "../include/ProcessIslandModel.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+
+#ifdef EC_HAS_POSIX_PROCESSES
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+		"Shared-memory migration needs lock-free 64-bit atomics");
+
+	const unsigned int MaxReadAttempts = 1 << 16;  // Of ReadElite, before giving up on a writer
+	const unsigned int WaitIntervalMs = 5;         // Between two polls of the workers
+
+	inline size_t RoundUp(size_t bytes)
+	{
+		return (bytes + 63) / 64 * 64;
+	}
+
+	/// Per-island block of the shared region, followed by the elite genes
+	struct IslandStatus
+	{
+		std::atomic<uint64_t> sequence;        // Odd while the elite is being written
+		std::atomic<uint64_t> generation;
+		std::atomic<uint64_t> numEvaluations;
+		std::atomic<uint64_t> numMigrations;
+		double                eliteFitness;
+	};
+
+	/// Per-edge ring of the shared region, followed by the slots.
+	/// A slot is the fitness followed by the genes.
+	struct RingHeader
+	{
+		std::atomic<uint64_t> head;            // Written by the receiving island
+		char                  padding0[56];
+		std::atomic<uint64_t> tail;            // Written by the sending island
+		char                  padding1[56];
+	};
+
+	/// Offsets of the blocks inside the shared region
+	class SharedLayout
+	{
+	public:
+		SharedLayout(unsigned int numIslands, unsigned int numEdges, unsigned int dim, unsigned int capacity)
+			: m_dim(dim), m_numSlots(capacity + 1)
+		{
+			m_statusBytes = RoundUp(sizeof(IslandStatus) + dim * sizeof(double));
+			m_ringBytes = RoundUp(sizeof(RingHeader) + m_numSlots * (dim + 1) * sizeof(double));
+			m_ringOffset = numIslands * m_statusBytes;
+			m_totalBytes = m_ringOffset + numEdges * m_ringBytes;
+		}
+
+		inline size_t GetTotalBytes() const { return m_totalBytes; }
+
+		inline IslandStatus* Status(void* pRegion, unsigned int island) const
+		{
+			return reinterpret_cast<IslandStatus*>(static_cast<char*>(pRegion) + island * m_statusBytes);
+		}
+
+		inline double* EliteGenes(IslandStatus* pStatus) const
+		{
+			return reinterpret_cast<double*>(reinterpret_cast<char*>(pStatus) + sizeof(IslandStatus));
+		}
+
+		inline RingHeader* Ring(void* pRegion, unsigned int edge) const
+		{
+			return reinterpret_cast<RingHeader*>(static_cast<char*>(pRegion) + m_ringOffset + edge * m_ringBytes);
+		}
+
+		inline double* Slot(RingHeader* pRing, uint64_t index) const
+		{
+			return reinterpret_cast<double*>(reinterpret_cast<char*>(pRing) + sizeof(RingHeader)) 
+				+ index * (m_dim + 1);
+		}
+
+		/// Write the elite of an island under its sequence lock
+		void PublishElite(IslandStatus* pStatus, const double* pGenes, double fitness) const
+		{
+			uint64_t sequence = pStatus->sequence.load(std::memory_order_relaxed);
+			pStatus->sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			std::memcpy(EliteGenes(pStatus), pGenes, m_dim * sizeof(double));
+			pStatus->eliteFitness = fitness;
+			pStatus->sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+		/// Read a consistent copy of the elite of an island
+		/// \return False if the island has not published an elite yet, or its sequence
+		///         stayed odd: the writer died in the middle of PublishElite
+		bool ReadElite(IslandStatus* pStatus, double* pGenes, double& fitness) const
+		{
+			for (unsigned int attempt = 0; attempt < MaxReadAttempts; attempt++)
+			{
+				uint64_t before = pStatus->sequence.load(std::memory_order_acquire);
+				if (before == 0)
+				{
+					return false;
+				}
+				if (before % 2 == 1)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				std::memcpy(pGenes, EliteGenes(pStatus), m_dim * sizeof(double));
+				fitness = pStatus->eliteFitness;
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (pStatus->sequence.load(std::memory_order_relaxed) == before)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/// Send a migrant. Only the sending island calls it for a given ring.
+		bool TryPush(RingHeader* pRing, const double* pGenes, double fitness) const
+		{
+			uint64_t tail = pRing->tail.load(std::memory_order_relaxed);
+			uint64_t next = (tail + 1) % m_numSlots;
+			if (next == pRing->head.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			double* pSlot = Slot(pRing, tail);
+			pSlot[0] = fitness;
+			std::memcpy(pSlot + 1, pGenes, m_dim * sizeof(double));
+			pRing->tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		/// Receive a migrant. Only the receiving island calls it for a given ring.
+		bool TryPop(RingHeader* pRing, double* pGenes, double& fitness) const
+		{
+			uint64_t head = pRing->head.load(std::memory_order_relaxed);
+			if (head == pRing->tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			const double* pSlot = Slot(pRing, head);
+			fitness = pSlot[0];
+			std::memcpy(pGenes, pSlot + 1, m_dim * sizeof(double));
+			pRing->head.store((head + 1) % m_numSlots, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		unsigned int m_dim;
+		unsigned int m_numSlots;
+		size_t       m_statusBytes;
+		size_t       m_ringBytes;
+		size_t       m_ringOffset;
+		size_t       m_totalBytes;
+	};
+}
+
+
+EC::ProcessIslandModel::ProcessIslandModel(unsigned int numIslands, MigrationTopology topology)
+	: m_numIslands(numIslands), m_migrationInterval(10), m_migrationBufferSize(4), m_maxRestarts(2),
+	m_numCrashes(0), m_numFailedIslands(0), m_numMigrations(0), m_numEvaluations(0), m_pElite(NULL)
+{
+	if (numIslands == 0)
+	{
+		throw std::invalid_argument("received non-positive number of islands");
+	}
+	m_neighbours = IslandModel::BuildTopology(numIslands, topology);
+
+	std::random_device randDevice;
+	m_seed = (static_cast<unsigned long long>(randDevice()) << 32) ^ randDevice();
+}
+
+
+EC::ProcessIslandModel::~ProcessIslandModel()
+{
+	delete m_pElite;
+}
+
+
+EC::BaseIndividual<double, double>* EC::ProcessIslandModel::GetElite()
+{
+	return m_pElite;
+}
+
+
+#ifdef EC_HAS_POSIX_PROCESSES
+
+namespace
+{
+	/// Edge lists of a topology: the rings an island writes to and reads from
+	void NumberEdges(
+		const std::vector<std::vector<unsigned int> >& neighbours,
+		std::vector<std::vector<unsigned int> >& outgoing,
+		std::vector<std::vector<unsigned int> >& incoming,
+		unsigned int& numEdges)
+	{
+		outgoing.assign(neighbours.size(), std::vector<unsigned int>());
+		incoming.assign(neighbours.size(), std::vector<unsigned int>());
+		numEdges = 0;
+		for (size_t i = 0; i < neighbours.size(); i++)
+		{
+			for (size_t k = 0; k < neighbours[i].size(); k++)
+			{
+				outgoing[i].push_back(numEdges);
+				incoming[neighbours[i][k]].push_back(numEdges);
+				numEdges++;
+			}
+		}
+	}
+}
+
+
+void EC::ProcessIslandModel::Evolve(
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	unsigned int maxGeneration,
+	bool verbose)
+{
+	if (lowerBound.empty() || lowerBound.size() != upperBound.size())
+	{
+		throw std::invalid_argument("Lower and upper bounds should have the same size");
+	}
+	unsigned int dim = static_cast<unsigned int>(lowerBound.size());
+	std::vector<std::vector<unsigned int> > outgoing, incoming;
+	unsigned int numEdges;
+	NumberEdges(m_neighbours, outgoing, incoming, numEdges);
+	SharedLayout layout(m_numIslands, numEdges, dim, m_migrationBufferSize);
+
+	// Anonymous shared mapping, inherited by the workers. Zero-filled, which is the
+	// initial state of every block; the atomics are constructed in place.
+	void* pRegion = mmap(NULL, layout.GetTotalBytes(), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (pRegion == MAP_FAILED)
+	{
+		throw std::runtime_error("Can't map the shared migration region");
+	}
+	for (unsigned int i = 0; i < m_numIslands; i++)
+	{
+		IslandStatus* pStatus = layout.Status(pRegion, i);
+		new (&pStatus->sequence) std::atomic<uint64_t>(0);
+		new (&pStatus->generation) std::atomic<uint64_t>(0);
+		new (&pStatus->numEvaluations) std::atomic<uint64_t>(0);
+		new (&pStatus->numMigrations) std::atomic<uint64_t>(0);
+	}
+	for (unsigned int e = 0; e < numEdges; e++)
+	{
+		RingHeader* pRing = layout.Ring(pRegion, e);
+		new (&pRing->head) std::atomic<uint64_t>(0);
+		new (&pRing->tail) std::atomic<uint64_t>(0);
+	}
+
+	m_numCrashes = 0;
+	m_numFailedIslands = 0;
+	std::vector<pid_t> pids(m_numIslands, -1);
+	std::vector<unsigned int> attempts(m_numIslands, 0);
+
+	// Buffered output would otherwise be written again by every worker
+	std::cout.flush();
+	fflush(NULL);
+
+	unsigned int numRunning = 0;
+	for (unsigned int i = 0; i < m_numIslands; i++)
+	{
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			RunWorker(pRegion, i, 0, populationSize, lowerBound, upperBound, pFitnessFunc, maxGeneration);
+		}
+		if (pid < 0)
+		{
+			// Workers already started still run to completion below
+			if (verbose)
+			{
+				std::cout << "Island " << i << ": fork failed" << std::endl;
+			}
+			m_numFailedIslands++;
+			continue;
+		}
+		pids[i] = pid;
+		numRunning++;
+	}
+
+	// Coordinator: wait for the workers and restart the ones that die
+	while (numRunning > 0)
+	{
+		// Only the workers are reaped: other children of the caller keep their exit status
+		int status = 0;
+		unsigned int island = m_numIslands;
+		for (unsigned int i = 0; i < m_numIslands && island == m_numIslands; i++)
+		{
+			if (pids[i] <= 0)
+			{
+				continue;
+			}
+			pid_t pid = waitpid(pids[i], &status, WNOHANG);
+			if (pid == pids[i])
+			{
+				island = i;
+			}
+			else if (pid < 0 && errno == ECHILD)
+			{
+				// Reaped elsewhere, e.g. SIGCHLD ignored by the caller: its exit status is lost
+				status = 0;
+				island = i;
+			}
+		}
+		if (island == m_numIslands)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(WaitIntervalMs));
+			continue;
+		}
+		numRunning--;
+		pids[island] = -1;
+
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		{
+			continue;
+		}
+		m_numCrashes++;
+
+		// A worker killed inside PublishElite leaves a torn elite and an odd sequence:
+		// drop the elite, the restarted worker starts without it
+		IslandStatus* pDeadStatus = layout.Status(pRegion, island);
+		if (pDeadStatus->sequence.load() % 2 == 1)
+		{
+			pDeadStatus->sequence.store(0);
+		}
+		if (verbose)
+		{
+			std::cout << "Island " << island << ": worker died at generation "
+				<< layout.Status(pRegion, island)->generation.load() << std::endl;
+		}
+		if (attempts[island] >= m_maxRestarts)
+		{
+			m_numFailedIslands++;
+			continue;
+		}
+		attempts[island]++;
+		std::cout.flush();
+		fflush(NULL);
+		pid_t newPid = fork();
+		if (newPid == 0)
+		{
+			RunWorker(pRegion, island, attempts[island], populationSize, lowerBound, upperBound, pFitnessFunc, maxGeneration);
+		}
+		if (newPid < 0)
+		{
+			m_numFailedIslands++;
+			continue;
+		}
+		pids[island] = newPid;
+		numRunning++;
+	}
+
+	// Collect the results
+	m_numMigrations = 0;
+	m_numEvaluations = 0;
+	std::vector<double> genes(dim);
+	double bestFitness = 0;
+	bool hasElite = false;
+	for (unsigned int i = 0; i < m_numIslands; i++)
+	{
+		IslandStatus* pStatus = layout.Status(pRegion, i);
+		m_numMigrations += pStatus->numMigrations.load();
+		m_numEvaluations += pStatus->numEvaluations.load();
+		double fitness;
+		if (layout.ReadElite(pStatus, &genes[0], fitness) && (!hasElite || fitness < bestFitness))
+		{
+			if (m_pElite == NULL || static_cast<unsigned int>(m_pElite->Size()) != dim)
+			{
+				delete m_pElite;
+				m_pElite = new RealCodedIndividual(dim);
+			}
+			for (unsigned int k = 0; k < dim; k++)
+			{
+				(*m_pElite)[k] = genes[k];
+			}
+			m_pElite->SetFitness(fitness);
+			bestFitness = fitness;
+			hasElite = true;
+		}
+	}
+	munmap(pRegion, layout.GetTotalBytes());
+
+	if (verbose && hasElite)
+	{
+		std::cout << "Islands: " << m_numIslands 
+			<< ", crashes: " << m_numCrashes
+			<< ", migrants accepted: " << m_numMigrations
+			<< ", best fitness: " << bestFitness << std::endl;
+	}
+}
+
+
+void EC::ProcessIslandModel::RunWorker(
+	void* pRegion,
+	unsigned int island,
+	unsigned int attempt,
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	unsigned int maxGeneration)
+{
+	int exitCode = 0;
+	try
+	{
+		unsigned int dim = static_cast<unsigned int>(lowerBound.size());
+		std::vector<std::vector<unsigned int> > outgoing, incoming;
+		unsigned int numEdges;
+		NumberEdges(m_neighbours, outgoing, incoming, numEdges);
+		SharedLayout layout(m_numIslands, numEdges, dim, m_migrationBufferSize);
+		IslandStatus* pStatus = layout.Status(pRegion, island);
+
+		// A restarted island gets a fresh stream, continues from its last published state and
+		// runs the generations left
+		unsigned long long previousEvaluations = pStatus->numEvaluations.load();
+		unsigned int firstGeneration = static_cast<unsigned int>(pStatus->generation.load());
+		DifferentialEvolution de;
+		de.SetSeed(RandomGenerator(m_seed, island + static_cast<unsigned long long>(attempt) * m_numIslands).Next());
+		de.SetNumThreads(1);
+		de.Initialize(populationSize, lowerBound, upperBound, pFitnessFunc);
+		de.SetMaxGeneration(maxGeneration > firstGeneration ? maxGeneration - firstGeneration : 0);
+		de.Start(false);
+
+		std::vector<double> genes(dim);
+		double fitness;
+		if (layout.ReadElite(pStatus, &genes[0], fitness))
+		{
+			de.Immigrate(&genes[0], fitness);
+		}
+
+		while (!de.ShouldStop())
+		{
+			de.Step();
+			unsigned int generation = firstGeneration + de.GetGeneration();
+
+			BaseIndividual<double, double>* pElite = de.GetElite();
+			for (unsigned int k = 0; k < dim; k++)
+			{
+				genes[k] = (*pElite)[k];
+			}
+			layout.PublishElite(pStatus, &genes[0], pElite->GetFitness());
+			pStatus->generation.store(generation);
+			pStatus->numEvaluations.store(previousEvaluations + de.GetNumEvaluations());
+
+			if (m_migrationInterval == 0 || generation % m_migrationInterval != 0)
+			{
+				continue;
+			}
+			for (size_t k = 0; k < outgoing[island].size(); k++)
+			{
+				layout.TryPush(layout.Ring(pRegion, outgoing[island][k]), &genes[0], pElite->GetFitness());
+			}
+			for (size_t k = 0; k < incoming[island].size(); k++)
+			{
+				RingHeader* pRing = layout.Ring(pRegion, incoming[island][k]);
+				while (layout.TryPop(pRing, &genes[0], fitness))
+				{
+					if (de.Immigrate(&genes[0], fitness))
+					{
+						pStatus->numMigrations++;
+					}
+				}
+			}
+		}
+	}
+	catch (...)
+	{
+		exitCode = 2;
+	}
+	// Skip the destructors and atexit handlers inherited from the coordinator
+	_exit(exitCode);
+}
+
+#else
+
+void EC::ProcessIslandModel::Evolve(
+	unsigned int,
+	std::vector<double>&,
+	std::vector<double>&,
+	BaseFitnessFunctor<double, double>*,
+	unsigned int,
+	bool)
+{
+	throw std::runtime_error("ProcessIslandModel needs POSIX processes");
+}
+
+
+void EC::ProcessIslandModel::RunWorker(
+	void*,
+	unsigned int,
+	unsigned int,
+	unsigned int,
+	std::vector<double>&,
+	std::vector<double>&,
+	BaseFitnessFunctor<double, double>*,
+	unsigned int)
+{ }
+
+#endif
@@ -0,0 +1,191 @@
+#include "../include/RandomGenerator.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	inline uint64_t SplitMix64(uint64_t& x)
+	{
+		uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	const double TwoPi = 6.283185307179586476925286766559;
+}
+
+
+EC::RandomGenerator::RandomGenerator(uint64_t seed, uint64_t stream)
+{
+	Seed(seed, stream);
+}
+
+
+void EC::RandomGenerator::Seed(uint64_t seed, uint64_t stream)
+{
+	// Hash the stream id into the seed, then expand with SplitMix64 as recommended
+	// by the xoshiro authors. The all-zero state cannot come out of SplitMix64.
+	uint64_t streamHash = stream;
+	uint64_t x = seed ^ SplitMix64(streamHash);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		m_state[i] = SplitMix64(x);
+	}
+	m_hasSpareNormal = false;
+	m_spareNormal = 0.0;
+}
+
+
+void EC::RandomGenerator::Jump()
+{
+	static const uint64_t JumpPolynomial[] = {
+		0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+	};
+
+	uint64_t s[4] = { 0, 0, 0, 0 };
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		for (int b = 0; b < 64; b++)
+		{
+			if (JumpPolynomial[i] & (static_cast<uint64_t>(1) << b))
+			{
+				for (unsigned int k = 0; k < 4; k++)
+				{
+					s[k] ^= m_state[k];
+				}
+			}
+			Next();
+		}
+	}
+	for (unsigned int k = 0; k < 4; k++)
+	{
+		m_state[k] = s[k];
+	}
+	m_hasSpareNormal = false;
+}
+
+
+double EC::RandomGenerator::Normal(double mean, double std)
+{
+	if (m_hasSpareNormal)
+	{
+		m_hasSpareNormal = false;
+		return mean + std * m_spareNormal;
+	}
+	// Box-Muller. 1 - u keeps the logarithm finite.
+	double radius = std::sqrt(-2.0 * std::log(1.0 - NextDouble()));
+	double angle = TwoPi * NextDouble();
+	m_spareNormal = radius * std::sin(angle);
+	m_hasSpareNormal = true;
+	return mean + std * radius * std::cos(angle);
+}
+
+
+double EC::RandomGenerator::Cauchy(double location, double scale)
+{
+	// Inverse transform. u is in [0, 1), so the tangent stays finite.
+	return location + scale * std::tan(0.5 * TwoPi * (NextDouble() - 0.5));
+}
+
+
+void EC::RandomGenerator::FillUniform(double* pOut, size_t count, double min, double max)
+{
+	const double scale = (max - min) * (1.0 / 9007199254740992.0);
+	for (size_t i = 0; i < count; i++)
+	{
+		pOut[i] = min + (Next() >> 11) * scale;
+	}
+}
+
+
+void EC::RandomGenerator::FillNormal(double* pOut, size_t count, double mean, double std)
+{
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2)
+	{
+		double radius = std::sqrt(-2.0 * std::log(1.0 - NextDouble()));
+		double angle = TwoPi * NextDouble();
+		pOut[i] = mean + std * radius * std::cos(angle);
+		pOut[i + 1] = mean + std * radius * std::sin(angle);
+	}
+	if (i < count)
+	{
+		pOut[i] = Normal(mean, std);
+	}
+}
+
+
+void EC::RandomGenerator::FillInt(int* pOut, size_t count, int min, int max)
+{
+	uint32_t range = static_cast<uint32_t>(max - min);
+	for (size_t i = 0; i < count; i++)
+	{
+		pOut[i] = min + static_cast<int>(NextInt(range));
+	}
+}
+
+
+void EC::RandomGenerator::FillBits(uint64_t* pOut, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		pOut[i] = Next();
+	}
+}
+
+
+void EC::RandomGenerator::FillBernoulliMask(uint64_t* pMask, size_t numBits, double prob)
+{
+	size_t numWords = (numBits + 63) / 64;
+	if (prob <= 0.0 || prob >= 1.0)
+	{
+		uint64_t fill = prob >= 1.0 ? ~static_cast<uint64_t>(0) : 0;
+		for (size_t w = 0; w < numWords; w++)
+		{
+			pMask[w] = fill;
+		}
+	}
+	else
+	{
+		// One 32-bit draw per bit, two bits per 64-bit draw
+		const uint64_t threshold = static_cast<uint64_t>(prob * 4294967296.0);
+		for (size_t w = 0; w < numWords; w++)
+		{
+			uint64_t word = 0;
+			for (unsigned int b = 0; b < 64; b += 2)
+			{
+				uint64_t r = Next();
+				word |= static_cast<uint64_t>((r & 0xFFFFFFFFULL) < threshold) << b;
+				word |= static_cast<uint64_t>((r >> 32) < threshold) << (b + 1);
+			}
+			pMask[w] = word;
+		}
+	}
+	if (numBits % 64 != 0)
+	{
+		pMask[numWords - 1] &= (static_cast<uint64_t>(1) << (numBits % 64)) - 1;
+	}
+}
+
+
+void EC::RandomGenerator::GetState(uint64_t* pState) const
+{
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		pState[i] = m_state[i];
+	}
+	std::memcpy(&pState[4], &m_spareNormal, sizeof(double));
+	pState[5] = m_hasSpareNormal ? 1 : 0;
+}
+
+
+void EC::RandomGenerator::SetState(const uint64_t* pState)
+{
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		m_state[i] = pState[i];
+	}
+	std::memcpy(&m_spareNormal, &pState[4], sizeof(double));
+	m_hasSpareNormal = pState[5] != 0;
+}
@@ -0,0 +1,488 @@
+#include "../include/RestartPortfolio.hpp"
+#include "../include/CMAEvolutionStrategy.hpp"
+#include "../include/RandomGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+
+namespace
+{
+	const unsigned int MaxPopulationSize = 1u << 20;
+
+	EC::BaseEvolver<double, double>* CreateEvolutionStrategy(const EC::RestartRun& run)
+	{
+		EC::CMAEvolutionStrategy* pEvolver = new EC::CMAEvolutionStrategy();
+		pEvolver->SetInitialStepSize(run.stepSize);
+		return pEvolver;
+	}
+}
+
+
+EC::RestartPortfolio::RunMonitor::RunMonitor(
+	RestartPortfolio* pPortfolio,
+	unsigned int run,
+	bool isSmall,
+	BaseEvolver<double, double>* pEvolver)
+	: m_pPortfolio(pPortfolio), m_run(run), m_isSmall(isSmall), m_pEvolver(pEvolver), m_numEvaluations(0),
+	m_bestFitness(HUGE_VAL), m_isDominated(false)
+{ }
+
+
+bool EC::RestartPortfolio::RunMonitor::Check(const GenerationStatistics& record)
+{
+	if (record.numEvaluations > m_numEvaluations)
+	{
+		m_pPortfolio->AddEvaluations(m_isSmall, record.numEvaluations - m_numEvaluations);
+		m_numEvaluations = record.numEvaluations;
+	}
+	if (record.bestFitness < m_bestFitness)
+	{
+		m_bestFitness = record.bestFitness;
+		m_pPortfolio->Publish(m_run, m_pEvolver, record.generation);
+	}
+	m_isDominated = m_pPortfolio->IsDominated(m_run, m_bestFitness, record.generation);
+	return m_isDominated;
+}
+
+
+void EC::RestartPortfolio::RunMonitor::Finish()
+{
+	// Check isn't called after a generation cut short by the budget or the token
+	unsigned long long numEvaluations = m_pEvolver->GetNumEvaluations();
+	if (numEvaluations > m_numEvaluations)
+	{
+		m_pPortfolio->AddEvaluations(m_isSmall, numEvaluations - m_numEvaluations);
+		m_numEvaluations = numEvaluations;
+	}
+	BasePopulation<double, double>* pPopulation = m_pEvolver->GetPopulation();
+	for (unsigned int i = 0; pPopulation != NULL && i < pPopulation->Size(); i++)
+	{
+		m_bestFitness = std::min(m_bestFitness, (*pPopulation)[i]->GetFitness());
+	}
+	m_pPortfolio->Publish(m_run, m_pEvolver, m_pEvolver->GetGeneration());
+}
+
+
+EC::RestartPortfolio::RestartPortfolio(RestartStrategy strategy)
+	: m_strategy(strategy), m_populationFactor(2), m_initialStepSize(0.3), m_maxEvaluations(0), m_timeLimit(0),
+	m_maxRuns(0), m_hasTargetFitness(false), m_targetFitness(0), m_dominanceFactor(3), m_dominanceMinGenerations(100),
+	m_numThreads(0), m_pFitnessFunc(NULL), m_populationSize(0), m_verbose(false), m_numLargeRuns(0),
+	m_numSmallRuns(0), m_largePopulation(0), m_largeRunEvaluations(0), m_numDominatedRuns(0), m_numEvaluations(0),
+	m_stopReason(STOP_NONE), m_bestFitness(HUGE_VAL), m_bestRun(0), m_bestGeneration(0), m_isTargetReached(false),
+	m_pElite(NULL)
+{
+	m_regimeEvaluations[0] = 0;
+	m_regimeEvaluations[1] = 0;
+
+	std::random_device randDevice;
+	m_seed = (static_cast<unsigned long long>(randDevice()) << 32) ^ randDevice();
+}
+
+
+EC::RestartPortfolio::~RestartPortfolio()
+{
+	delete m_pElite;
+}
+
+
+void EC::RestartPortfolio::SetEvolverFactory(const EvolverFactory& factory)
+{
+	m_factory = factory;
+}
+
+
+void EC::RestartPortfolio::SetPopulationFactor(double factor)
+{
+	if (!(factor >= 1))
+	{
+		throw std::invalid_argument("received population factor smaller than 1");
+	}
+	m_populationFactor = factor;
+}
+
+
+void EC::RestartPortfolio::SetInitialStepSize(double stepSize)
+{
+	if (!(stepSize > 0))
+	{
+		throw std::invalid_argument("received non-positive step size");
+	}
+	m_initialStepSize = stepSize;
+}
+
+
+void EC::RestartPortfolio::SetMaxEvaluations(unsigned long long maxEvaluations)
+{
+	m_maxEvaluations = maxEvaluations;
+}
+
+
+void EC::RestartPortfolio::SetTimeLimit(double seconds)
+{
+	if (seconds < 0)
+	{
+		throw std::invalid_argument("received negative time limit");
+	}
+	m_timeLimit = seconds;
+}
+
+
+void EC::RestartPortfolio::SetTargetFitness(double targetFitness)
+{
+	m_hasTargetFitness = true;
+	m_targetFitness = targetFitness;
+}
+
+
+void EC::RestartPortfolio::SetDominance(double factor, unsigned int minGenerations)
+{
+	if (factor < 0)
+	{
+		throw std::invalid_argument("received negative dominance factor");
+	}
+	m_dominanceFactor = factor;
+	m_dominanceMinGenerations = minGenerations;
+}
+
+
+void EC::RestartPortfolio::Evolve(
+	unsigned int populationSize,
+	std::vector<double>& lowerBound,
+	std::vector<double>& upperBound,
+	BaseFitnessFunctor<double, double>* pFitnessFunc,
+	bool verbose)
+{
+	if (pFitnessFunc == NULL)
+	{
+		throw std::invalid_argument("Invalid fitness function");
+	}
+	if (lowerBound.size() != upperBound.size() || lowerBound.empty())
+	{
+		throw std::invalid_argument("Lower and upper bounds should have the same, non-zero size");
+	}
+	if (m_maxEvaluations == 0 && m_timeLimit == 0 && m_maxRuns == 0)
+	{
+		throw std::invalid_argument("received no evaluation, time or run budget");
+	}
+	unsigned int problemDim = static_cast<unsigned int>(lowerBound.size());
+	if (populationSize == 0)
+	{
+		populationSize = 4 + static_cast<unsigned int>(3 * std::log(static_cast<double>(problemDim)));
+	}
+
+	m_pFitnessFunc = pFitnessFunc;
+	m_lowerBound = lowerBound;
+	m_upperBound = upperBound;
+	m_populationSize = populationSize;
+	m_verbose = verbose;
+
+	m_runs.clear();
+	m_numLargeRuns = 0;
+	m_numSmallRuns = 0;
+	m_largePopulation = populationSize;
+	m_largeRunEvaluations = 0;
+	m_numDominatedRuns = 0;
+	m_numEvaluations = 0;
+	m_regimeEvaluations[0] = 0;
+	m_regimeEvaluations[1] = 0;
+	m_token.Reset();
+	m_stopReason = STOP_NONE;
+	m_bestFitness = HUGE_VAL;
+	m_bestRun = 0;
+	m_bestGeneration = 0;
+	m_isTargetReached = false;
+	delete m_pElite;
+	m_pElite = new RealCodedIndividual(problemDim);
+	m_pElite->SetFitness(HUGE_VAL);
+	m_deadline = Clock::now() +
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_timeLimit));
+
+	unsigned int numThreads = m_numThreads;
+	if (numThreads == 0)
+	{
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (m_maxRuns > 0)
+	{
+		numThreads = std::min(numThreads, m_maxRuns);
+	}
+
+	// Errors are collected, stop the other threads, and the first one is rethrown
+	std::vector<std::exception_ptr> errors(numThreads);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < numThreads; t++)
+	{
+		threads.push_back(std::thread([this, t, &errors]()
+		{
+			try
+			{
+				RunThread();
+			}
+			catch (...)
+			{
+				errors[t] = std::current_exception();
+				m_token.Cancel();
+			}
+		}));
+	}
+	for (unsigned int t = 0; t < numThreads; t++)
+	{
+		threads[t].join();
+	}
+	for (unsigned int t = 0; t < numThreads; t++)
+	{
+		if (errors[t])
+		{
+			std::rethrow_exception(errors[t]);
+		}
+	}
+
+	if (m_isTargetReached)
+	{
+		m_stopReason = STOP_TARGET_FITNESS;
+	}
+	else if (m_maxEvaluations > 0 && m_numEvaluations >= m_maxEvaluations)
+	{
+		m_stopReason = STOP_MAX_EVALUATIONS;
+	}
+	else if (m_timeLimit > 0 && Clock::now() >= m_deadline)
+	{
+		m_stopReason = STOP_DEADLINE;
+	}
+	else
+	{
+		m_stopReason = STOP_MAX_GENERATION;
+	}
+
+	if (verbose)
+	{
+		std::cout << "Runs: " << m_runs.size()
+			<< ", dominated: " << m_numDominatedRuns
+			<< ", evaluations: " << GetNumEvaluations()
+			<< ", best fitness: " << m_pElite->GetFitness()
+			<< ", stopped: " << GetStopReasonName(m_stopReason) << std::endl;
+	}
+}
+
+
+void EC::RestartPortfolio::RunThread()
+{
+	unsigned int run;
+	while (LaunchRun(run))
+	{
+		RunEvolver(run);
+	}
+}
+
+
+bool EC::RestartPortfolio::LaunchRun(unsigned int& run)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	unsigned long long numEvaluations = m_numEvaluations;
+	if (m_token.IsCancelled() ||
+		(m_maxRuns > 0 && m_runs.size() >= m_maxRuns) ||
+		(m_timeLimit > 0 && Clock::now() >= m_deadline) ||
+		(m_maxEvaluations > 0 && numEvaluations >= m_maxEvaluations))
+	{
+		return false;
+	}
+
+	RestartRun settings = RestartRun();
+	settings.index = static_cast<unsigned int>(m_runs.size());
+	RandomGenerator generator(m_seed, settings.index);
+	settings.seed = generator.Next();
+	double u = generator.NextDouble();
+	settings.stepSize = m_initialStepSize;
+
+	// BIPOP: the regime that has spent fewer evaluations, counting the runs going on. Small
+	// runs are budgeted on the last large run, so none starts before a large one has finished.
+	if (m_strategy == RESTART_BIPOP && m_largeRunEvaluations > 0)
+	{
+		unsigned long long largeEvaluations = m_regimeEvaluations[0];
+		unsigned long long smallEvaluations = m_regimeEvaluations[1];
+		settings.isSmall = smallEvaluations < largeEvaluations ||
+			(smallEvaluations == largeEvaluations && m_numSmallRuns < m_numLargeRuns);
+	}
+
+	double populationSize;
+	if (settings.isSmall)
+	{
+		// Population between the first one and half the last large one, smaller steps
+		double ratio = std::max(1.0, 0.5 * m_largePopulation / m_populationSize);
+		populationSize = m_populationSize * std::pow(ratio, u * u);
+		settings.stepSize *= std::pow(10.0, -2 * u);
+		settings.maxEvaluations = std::max(m_largeRunEvaluations / 2, 1ULL);
+		m_numSmallRuns++;
+	}
+	else
+	{
+		unsigned int numIncreases = m_strategy == RESTART_IPOP ? settings.index : m_numLargeRuns;
+		populationSize = m_populationSize * std::pow(m_populationFactor, static_cast<double>(numIncreases));
+		m_numLargeRuns++;
+	}
+	settings.populationSize = static_cast<unsigned int>(std::min(populationSize, static_cast<double>(MaxPopulationSize)));
+	if (!settings.isSmall)
+	{
+		m_largePopulation = settings.populationSize;
+	}
+	if (m_maxEvaluations > 0)
+	{
+		unsigned long long remaining = m_maxEvaluations - numEvaluations;
+		settings.maxEvaluations = settings.maxEvaluations > 0 ? std::min(settings.maxEvaluations, remaining) : remaining;
+	}
+
+	settings.bestFitness = HUGE_VAL;
+	settings.stopReason = STOP_NONE;
+	m_runs.push_back(settings);
+	run = settings.index;
+	return true;
+}
+
+
+void EC::RestartPortfolio::RunEvolver(unsigned int run)
+{
+	RestartRun settings;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		settings = m_runs[run];
+	}
+	BaseEvolver<double, double>* pEvolver = m_factory ? m_factory(settings) : CreateEvolutionStrategy(settings);
+	if (pEvolver == NULL)
+	{
+		throw std::runtime_error("Evolver factory returned NULL");
+	}
+
+	RunMonitor monitor(this, run, settings.isSmall, pEvolver);
+	try
+	{
+		pEvolver->SetSeed(settings.seed);
+		pEvolver->SetNumThreads(1);
+		StopCriteria& criteria = pEvolver->GetStopCriteria();
+		criteria.SetCancellationToken(&m_token);
+		if (settings.maxEvaluations > 0)
+		{
+			criteria.SetMaxEvaluations(settings.maxEvaluations);
+		}
+		if (m_timeLimit > 0)
+		{
+			criteria.SetDeadline(m_deadline);
+		}
+		criteria.AddCondition(&monitor);
+
+		std::vector<double> lowerBound(m_lowerBound);
+		std::vector<double> upperBound(m_upperBound);
+		pEvolver->Initialize(settings.populationSize, lowerBound, upperBound, m_pFitnessFunc);
+		pEvolver->Evolve(std::numeric_limits<unsigned int>::max(), false);
+		monitor.Finish();
+	}
+	catch (...)
+	{
+		delete pEvolver;
+		throw;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		RestartRun& result = m_runs[run];
+		result.bestFitness = monitor.GetBestFitness();
+		result.numEvaluations = pEvolver->GetNumEvaluations();
+		result.numGenerations = pEvolver->GetGeneration();
+		result.stopReason = pEvolver->GetStopReason();
+		result.isDominated = monitor.IsDominated();
+		if (result.isDominated)
+		{
+			m_numDominatedRuns++;
+		}
+		if (!result.isSmall)
+		{
+			m_largeRunEvaluations = result.numEvaluations;
+		}
+		if (m_verbose)
+		{
+			std::cout << "Run " << run << (result.isSmall ? " (small)" : " (large)")
+				<< ": population " << result.populationSize
+				<< ", evaluations: " << result.numEvaluations
+				<< ", best fitness: " << result.bestFitness
+				<< ", stopped: " << (result.isDominated ? "dominated" : GetStopReasonName(result.stopReason))
+				<< std::endl;
+		}
+	}
+	delete pEvolver;
+}
+
+
+void EC::RestartPortfolio::AddEvaluations(bool isSmall, unsigned long long numEvaluations)
+{
+	m_regimeEvaluations[isSmall ? 1 : 0] += numEvaluations;
+	unsigned long long total = (m_numEvaluations += numEvaluations);
+	if (m_maxEvaluations > 0 && total >= m_maxEvaluations)
+	{
+		m_token.Cancel();
+	}
+}
+
+
+void EC::RestartPortfolio::Publish(unsigned int run, BaseEvolver<double, double>* pEvolver, unsigned int generation)
+{
+	BasePopulation<double, double>* pPopulation = pEvolver->GetPopulation();
+	if (pPopulation == NULL || pPopulation->Size() == 0)
+	{
+		return;
+	}
+	unsigned int best = 0;
+	for (unsigned int i = 1; i < pPopulation->Size(); i++)
+	{
+		if ((*pPopulation)[i]->GetFitness() < (*pPopulation)[best]->GetFitness())
+		{
+			best = i;
+		}
+	}
+	BaseIndividual<double, double>* pBest = (*pPopulation)[best];
+	double fitness = pBest->GetFitness();
+	if (!(fitness < m_bestFitness.load()))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_eliteMutex);
+	if (!(fitness < m_bestFitness.load()))
+	{
+		return;
+	}
+	for (int k = 0; k < m_pElite->Size(); k++)
+	{
+		(*m_pElite)[k] = (*pBest)[k];
+	}
+	m_pElite->SetFitness(fitness);
+	m_bestFitness = fitness;
+	m_bestRun = run;
+	m_bestGeneration = generation;
+	if (m_hasTargetFitness && fitness <= m_targetFitness)
+	{
+		m_isTargetReached = true;
+		m_token.Cancel();
+	}
+}
+
+
+bool EC::RestartPortfolio::IsDominated(unsigned int run, double bestFitness, unsigned int generation)
+{
+	if (m_dominanceFactor == 0 || generation < m_dominanceMinGenerations || bestFitness <= m_bestFitness.load())
+	{
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_eliteMutex);
+	return run != m_bestRun && generation >= m_dominanceFactor * m_bestGeneration && bestFitness > m_bestFitness.load();
+}
+
+
+EC::BaseIndividual<double, double>* EC::RestartPortfolio::GetElite()
+{
+	return m_pElite;
+}
@@ -0,0 +1,382 @@
+#include "../include/SimdKernels.hpp"
+#include <cstddef>
+
+#ifdef EC_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Sum of squares
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	double SumOfSquaresScalar(const double* x, unsigned int length)
+	{
+		double sum = 0;
+		for (unsigned int j = 0; j < length; j++)
+		{
+			sum += x[j] * x[j];
+		}
+		return sum;
+	}
+
+#ifdef EC_SIMD_X86
+	__attribute__((target("sse2")))
+	double SumOfSquaresSse2(const double* x, unsigned int length)
+	{
+		__m128d acc0 = _mm_setzero_pd();
+		__m128d acc1 = _mm_setzero_pd();
+		unsigned int j = 0;
+		for (; j + 4 <= length; j += 4)
+		{
+			__m128d v0 = _mm_loadu_pd(x + j);
+			__m128d v1 = _mm_loadu_pd(x + j + 2);
+			acc0 = _mm_add_pd(acc0, _mm_mul_pd(v0, v0));
+			acc1 = _mm_add_pd(acc1, _mm_mul_pd(v1, v1));
+		}
+		acc0 = _mm_add_pd(acc0, acc1);
+		double lanes[2];
+		_mm_storeu_pd(lanes, acc0);
+		return lanes[0] + lanes[1] + SumOfSquaresScalar(x + j, length - j);
+	}
+
+	__attribute__((target("avx2,fma")))
+	double SumOfSquaresAvx2(const double* x, unsigned int length)
+	{
+		__m256d acc0 = _mm256_setzero_pd();
+		__m256d acc1 = _mm256_setzero_pd();
+		unsigned int j = 0;
+		for (; j + 8 <= length; j += 8)
+		{
+			__m256d v0 = _mm256_loadu_pd(x + j);
+			__m256d v1 = _mm256_loadu_pd(x + j + 4);
+			acc0 = _mm256_fmadd_pd(v0, v0, acc0);
+			acc1 = _mm256_fmadd_pd(v1, v1, acc1);
+		}
+		for (; j + 4 <= length; j += 4)
+		{
+			__m256d v0 = _mm256_loadu_pd(x + j);
+			acc0 = _mm256_fmadd_pd(v0, v0, acc0);
+		}
+		acc0 = _mm256_add_pd(acc0, acc1);
+		__m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+		half = _mm_add_sd(half, _mm_unpackhi_pd(half, half));
+		return _mm_cvtsd_f64(half) + SumOfSquaresScalar(x + j, length - j);
+	}
+
+	__attribute__((target("avx512f")))
+	double SumOfSquaresAvx512(const double* x, unsigned int length)
+	{
+		__m512d acc0 = _mm512_setzero_pd();
+		__m512d acc1 = _mm512_setzero_pd();
+		unsigned int j = 0;
+		for (; j + 16 <= length; j += 16)
+		{
+			__m512d v0 = _mm512_loadu_pd(x + j);
+			__m512d v1 = _mm512_loadu_pd(x + j + 8);
+			acc0 = _mm512_fmadd_pd(v0, v0, acc0);
+			acc1 = _mm512_fmadd_pd(v1, v1, acc1);
+		}
+		if (j + 8 <= length)
+		{
+			__m512d v0 = _mm512_loadu_pd(x + j);
+			acc0 = _mm512_fmadd_pd(v0, v0, acc0);
+			j += 8;
+		}
+		if (j < length)
+		{
+			// Masked load of the tail, no scalar loop
+			__mmask8 mask = static_cast<__mmask8>((1u << (length - j)) - 1);
+			__m512d v0 = _mm512_maskz_loadu_pd(mask, x + j);
+			acc1 = _mm512_fmadd_pd(v0, v0, acc1);
+		}
+		double lanes[8];
+		_mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+		return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+	}
+#endif
+
+	typedef double (*RowKernel)(const double*, unsigned int);
+
+	RowKernel SelectSumOfSquares()
+	{
+#ifdef EC_SIMD_X86
+		switch (EC::GetSimdLevel())
+		{
+		case EC::SIMD_AVX512: return SumOfSquaresAvx512;
+		case EC::SIMD_AVX2:   return SumOfSquaresAvx2;
+		case EC::SIMD_SSE2:   return SumOfSquaresSse2;
+		default:              break;
+		}
+#endif
+		return SumOfSquaresScalar;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// Rosenbrock
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	inline double RosenbrockTerm(double x0, double x1)
+	{
+		double a = x1 - x0 * x0;
+		double b = 1 - x0;
+		return 100 * a * a + b * b;
+	}
+
+	double RosenbrockScalar(const double* x, unsigned int length)
+	{
+		double sum = 0;
+		for (unsigned int j = 0; j + 1 < length; j++)
+		{
+			sum += RosenbrockTerm(x[j], x[j + 1]);
+		}
+		return sum;
+	}
+
+#ifdef EC_SIMD_X86
+	__attribute__((target("sse2")))
+	double RosenbrockSse2(const double* x, unsigned int length)
+	{
+		const __m128d hundred = _mm_set1_pd(100);
+		const __m128d one = _mm_set1_pd(1);
+		__m128d acc = _mm_setzero_pd();
+		unsigned int j = 0;
+		for (; j + 3 <= length; j += 2)
+		{
+			__m128d x0 = _mm_loadu_pd(x + j);
+			__m128d x1 = _mm_loadu_pd(x + j + 1);
+			__m128d a = _mm_sub_pd(x1, _mm_mul_pd(x0, x0));
+			__m128d b = _mm_sub_pd(one, x0);
+			acc = _mm_add_pd(acc, _mm_add_pd(_mm_mul_pd(hundred, _mm_mul_pd(a, a)), _mm_mul_pd(b, b)));
+		}
+		double lanes[2];
+		_mm_storeu_pd(lanes, acc);
+		return lanes[0] + lanes[1] + RosenbrockScalar(x + j, length - j);
+	}
+
+	__attribute__((target("avx2,fma")))
+	double RosenbrockAvx2(const double* x, unsigned int length)
+	{
+		const __m256d hundred = _mm256_set1_pd(100);
+		const __m256d one = _mm256_set1_pd(1);
+		__m256d acc = _mm256_setzero_pd();
+		unsigned int j = 0;
+		for (; j + 5 <= length; j += 4)
+		{
+			__m256d x0 = _mm256_loadu_pd(x + j);
+			__m256d x1 = _mm256_loadu_pd(x + j + 1);
+			__m256d a = _mm256_fnmadd_pd(x0, x0, x1);
+			__m256d b = _mm256_sub_pd(one, x0);
+			acc = _mm256_fmadd_pd(_mm256_mul_pd(hundred, a), a, _mm256_fmadd_pd(b, b, acc));
+		}
+		__m128d half = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+		half = _mm_add_sd(half, _mm_unpackhi_pd(half, half));
+		return _mm_cvtsd_f64(half) + RosenbrockScalar(x + j, length - j);
+	}
+
+	__attribute__((target("avx512f")))
+	double RosenbrockAvx512(const double* x, unsigned int length)
+	{
+		const __m512d hundred = _mm512_set1_pd(100);
+		const __m512d one = _mm512_set1_pd(1);
+		__m512d acc = _mm512_setzero_pd();
+		for (unsigned int j = 0; j + 1 < length; j += 8)
+		{
+			// Terms j .. length - 2 exist; the tail is masked
+			unsigned int numTerms = length - 1 - j;
+			__mmask8 active = numTerms >= 8 ? 0xFF : static_cast<__mmask8>((1u << numTerms) - 1);
+			__m512d x0 = _mm512_maskz_loadu_pd(active, x + j);
+			__m512d x1 = _mm512_maskz_loadu_pd(active, x + j + 1);
+			__m512d a = _mm512_fnmadd_pd(x0, x0, x1);
+			__m512d b = _mm512_maskz_sub_pd(active, one, x0);
+			acc = _mm512_fmadd_pd(_mm512_mul_pd(hundred, a), a, _mm512_fmadd_pd(b, b, acc));
+		}
+		double lanes[8];
+		_mm512_storeu_pd(lanes, acc);
+		return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+	}
+#endif
+
+	RowKernel SelectRosenbrock()
+	{
+#ifdef EC_SIMD_X86
+		switch (EC::GetSimdLevel())
+		{
+		case EC::SIMD_AVX512: return RosenbrockAvx512;
+		case EC::SIMD_AVX2:   return RosenbrockAvx2;
+		case EC::SIMD_SSE2:   return RosenbrockSse2;
+		default:              break;
+		}
+#endif
+		return RosenbrockScalar;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////
+	// DE trial generation
+	//
+	// The donor x0 + w * (x1 - x2) is computed with a separate multiply and add, and
+	// contraction into FMA is disabled, so every code path produces the same bits. Clang
+	// ignores the GCC optimize pragma and has its own; it stays in effect until reset below.
+	///////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+	inline bool MaskBit(const uint64_t* pMask, unsigned int j)
+	{
+		return ((pMask[j >> 6] >> (j & 63)) & 1) != 0;
+	}
+
+	void DifferentialTrialScalar(const double* pTarget, const double* pX0, const double* pX1,
+		const double* pX2, const uint64_t* pMask, unsigned int length, double weight, double* pTrial)
+	{
+		for (unsigned int j = 0; j < length; j++)
+		{
+			pTrial[j] = MaskBit(pMask, j) ? pX0[j] + weight * (pX1[j] - pX2[j]) : pTarget[j];
+		}
+	}
+
+#ifdef EC_SIMD_X86
+	__attribute__((target("sse2")))
+	void DifferentialTrialSse2(const double* pTarget, const double* pX0, const double* pX1,
+		const double* pX2, const uint64_t* pMask, unsigned int length, double weight, double* pTrial)
+	{
+		const __m128d w = _mm_set1_pd(weight);
+		const __m128i laneBits = _mm_set_epi32(0, 2, 0, 1);
+		unsigned int j = 0;
+		for (; j + 2 <= length; j += 2)
+		{
+			long long bits = static_cast<long long>((pMask[j >> 6] >> (j & 63)) & 0x3);
+			// Lane k is all ones if bit k is set. SSE2 has no 64-bit compare: compare the
+			// 32-bit halves, then AND each half with its neighbour.
+			__m128i sel = _mm_and_si128(_mm_set1_epi64x(bits), laneBits);
+			__m128i halves = _mm_cmpeq_epi32(sel, laneBits);
+			halves = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128d mask = _mm_castsi128_pd(halves);
+
+			__m128d donor = _mm_add_pd(_mm_loadu_pd(pX0 + j),
+				_mm_mul_pd(w, _mm_sub_pd(_mm_loadu_pd(pX1 + j), _mm_loadu_pd(pX2 + j))));
+			__m128d target = _mm_loadu_pd(pTarget + j);
+			_mm_storeu_pd(pTrial + j, _mm_or_pd(_mm_and_pd(mask, donor), _mm_andnot_pd(mask, target)));
+		}
+		for (; j < length; j++)
+		{
+			pTrial[j] = MaskBit(pMask, j) ? pX0[j] + weight * (pX1[j] - pX2[j]) : pTarget[j];
+		}
+	}
+
+	__attribute__((target("avx2")))
+	void DifferentialTrialAvx2(const double* pTarget, const double* pX0, const double* pX1,
+		const double* pX2, const uint64_t* pMask, unsigned int length, double weight, double* pTrial)
+	{
+		const __m256d w = _mm256_set1_pd(weight);
+		const __m256i laneBits = _mm256_setr_epi64x(1, 2, 4, 8);
+		unsigned int j = 0;
+		for (; j + 4 <= length; j += 4)
+		{
+			long long bits = static_cast<long long>((pMask[j >> 6] >> (j & 63)) & 0xF);
+			__m256i sel = _mm256_and_si256(_mm256_set1_epi64x(bits), laneBits);
+			__m256d mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(sel, laneBits));
+
+			__m256d donor = _mm256_add_pd(_mm256_loadu_pd(pX0 + j),
+				_mm256_mul_pd(w, _mm256_sub_pd(_mm256_loadu_pd(pX1 + j), _mm256_loadu_pd(pX2 + j))));
+			_mm256_storeu_pd(pTrial + j, _mm256_blendv_pd(_mm256_loadu_pd(pTarget + j), donor, mask));
+		}
+		for (; j < length; j++)
+		{
+			pTrial[j] = MaskBit(pMask, j) ? pX0[j] + weight * (pX1[j] - pX2[j]) : pTarget[j];
+		}
+	}
+
+	__attribute__((target("avx512f")))
+	void DifferentialTrialAvx512(const double* pTarget, const double* pX0, const double* pX1,
+		const double* pX2, const uint64_t* pMask, unsigned int length, double weight, double* pTrial)
+	{
+		const __m512d w = _mm512_set1_pd(weight);
+		for (unsigned int j = 0; j < length; j += 8)
+		{
+			// The crossover bits are the blend mask; the tail uses masked loads and stores
+			__mmask8 active = length - j >= 8 ? 0xFF : static_cast<__mmask8>((1u << (length - j)) - 1);
+			__mmask8 cross = static_cast<__mmask8>(pMask[j >> 6] >> (j & 63)) & active;
+
+			__m512d x0 = _mm512_maskz_loadu_pd(active, pX0 + j);
+			__m512d x1 = _mm512_maskz_loadu_pd(active, pX1 + j);
+			__m512d x2 = _mm512_maskz_loadu_pd(active, pX2 + j);
+			__m512d donor = _mm512_add_pd(x0, _mm512_mul_pd(w, _mm512_sub_pd(x1, x2)));
+			__m512d trial = _mm512_mask_blend_pd(cross, _mm512_maskz_loadu_pd(active, pTarget + j), donor);
+			_mm512_mask_storeu_pd(pTrial + j, active, trial);
+		}
+	}
+#endif
+
+#if defined(__clang__)
+#pragma clang fp contract(on)
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+	typedef void (*TrialKernel)(const double*, const double*, const double*, const double*,
+		const uint64_t*, unsigned int, double, double*);
+
+	TrialKernel SelectDifferentialTrial()
+	{
+#ifdef EC_SIMD_X86
+		switch (EC::GetSimdLevel())
+		{
+		case EC::SIMD_AVX512: return DifferentialTrialAvx512;
+		case EC::SIMD_AVX2:   return DifferentialTrialAvx2;
+		case EC::SIMD_SSE2:   return DifferentialTrialSse2;
+		default:              break;
+		}
+#endif
+		return DifferentialTrialScalar;
+	}
+
+}
+
+
+void EC::SimdKernels::SumOfSquaresBatch(
+	const double* pRows,
+	unsigned int numRows,
+	unsigned int length,
+	unsigned int stride,
+	double* pOut)
+{
+	RowKernel kernel = SelectSumOfSquares();
+	for (unsigned int i = 0; i < numRows; i++)
+	{
+		pOut[i] = kernel(pRows + static_cast<std::size_t>(i) * stride, length);
+	}
+}
+
+
+void EC::SimdKernels::RosenbrockBatch(
+	const double* pRows,
+	unsigned int numRows,
+	unsigned int length,
+	unsigned int stride,
+	double* pOut)
+{
+	RowKernel kernel = SelectRosenbrock();
+	for (unsigned int i = 0; i < numRows; i++)
+	{
+		pOut[i] = kernel(pRows + static_cast<std::size_t>(i) * stride, length);
+	}
+}
+
+
+void EC::SimdKernels::DifferentialTrial(
+	const double* pTarget,
+	const double* pX0,
+	const double* pX1,
+	const double* pX2,
+	const uint64_t* pMask,
+	unsigned int length,
+	double weight,
+	double* pTrial)
+{
+	SelectDifferentialTrial()(pTarget, pX0, pX1, pX2, pMask, length, weight, pTrial);
+}
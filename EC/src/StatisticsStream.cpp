@@ -0,0 +1,181 @@
+#include "../include/StatisticsStream.hpp"
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace
+{
+	/// Write a number as JSON, which has no representation for NaN and infinity
+	void WriteJsonNumber(std::ostream& stream, double value)
+	{
+		if (std::isfinite(value))
+		{
+			stream << value;
+		}
+		else
+		{
+			stream << "null";
+		}
+	}
+}
+
+
+EC::CsvStatisticsSink::CsvStatisticsSink(std::ostream& stream)
+	: m_stream(stream), m_hasHeader(false)
+{ }
+
+
+void EC::CsvStatisticsSink::Write(const GenerationStatistics& record)
+{
+	if (!m_hasHeader)
+	{
+		m_stream << "generation,evaluations,best,mean,std,diversity,"
+			"breed_seconds,evaluation_seconds,select_seconds,save_elite_seconds,elapsed_seconds\n";
+		m_hasHeader = true;
+	}
+	m_stream << record.generation << ',' << record.numEvaluations << ','
+		<< record.bestFitness << ',' << record.meanFitness << ',' << record.stdFitness << ','
+		<< record.diversity << ',' << record.breedSeconds << ',' << record.evaluationSeconds << ','
+		<< record.selectSeconds << ',' << record.saveEliteSeconds << ',' << record.elapsedSeconds << '\n';
+}
+
+
+void EC::CsvStatisticsSink::Flush()
+{
+	m_stream.flush();
+}
+
+
+EC::JsonLinesStatisticsSink::JsonLinesStatisticsSink(std::ostream& stream)
+	: m_stream(stream)
+{ }
+
+
+void EC::JsonLinesStatisticsSink::Write(const GenerationStatistics& record)
+{
+	const char* names[] = { "best", "mean", "std", "diversity", "breed_seconds", "evaluation_seconds",
+		"select_seconds", "save_elite_seconds", "elapsed_seconds" };
+	const double values[] = { record.bestFitness, record.meanFitness, record.stdFitness, record.diversity,
+		record.breedSeconds, record.evaluationSeconds, record.selectSeconds, record.saveEliteSeconds,
+		record.elapsedSeconds };
+
+	m_stream << "{\"generation\":" << record.generation << ",\"evaluations\":" << record.numEvaluations;
+	for (int i = 0; i < 9; i++)
+	{
+		m_stream << ",\"" << names[i] << "\":";
+		WriteJsonNumber(m_stream, values[i]);
+	}
+	m_stream << "}\n";
+}
+
+
+void EC::JsonLinesStatisticsSink::Flush()
+{
+	m_stream.flush();
+}
+
+
+EC::CallbackStatisticsSink::CallbackStatisticsSink(
+	const std::function<void(const GenerationStatistics&)>& callback)
+	: m_callback(callback)
+{ }
+
+
+void EC::CallbackStatisticsSink::Write(const GenerationStatistics& record)
+{
+	m_callback(record);
+}
+
+
+EC::StatisticsStream::StatisticsStream(size_t capacity)
+	: m_queue(capacity), m_stop(false), m_numPublished(0), m_numFlushed(0), m_numDropped(0)
+{ }
+
+
+EC::StatisticsStream::~StatisticsStream()
+{
+	if (m_thread.joinable())
+	{
+		m_stop.store(true, std::memory_order_release);
+		m_thread.join();
+	}
+}
+
+
+void EC::StatisticsStream::AddSink(StatisticsSink* pSink)
+{
+	if (m_thread.joinable())
+	{
+		throw std::runtime_error("Sinks must be added before the first record is published");
+	}
+	if (pSink != NULL)
+	{
+		m_sinks.push_back(pSink);
+	}
+}
+
+
+bool EC::StatisticsStream::Publish(const GenerationStatistics& record)
+{
+	if (!m_thread.joinable())
+	{
+		m_thread = std::thread(&StatisticsStream::Run, this);
+	}
+	if (!m_queue.TryPush(record))
+	{
+		m_numDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	m_numPublished.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+
+void EC::StatisticsStream::Flush()
+{
+	unsigned long long numPublished = m_numPublished.load(std::memory_order_acquire);
+	while (m_numFlushed.load(std::memory_order_acquire) < numPublished)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+
+void EC::StatisticsStream::Run()
+{
+	GenerationStatistics record;
+	unsigned long long numWritten = 0;
+	while (true)
+	{
+		// Read the flag first: records published before the stop are still delivered
+		bool stop = m_stop.load(std::memory_order_acquire);
+		bool hasWritten = false;
+		while (m_queue.TryPop(record))
+		{
+			for (size_t s = 0; s < m_sinks.size(); s++)
+			{
+				m_sinks[s]->Write(record);
+			}
+			numWritten++;
+			hasWritten = true;
+		}
+		if (hasWritten)
+		{
+			for (size_t s = 0; s < m_sinks.size(); s++)
+			{
+				m_sinks[s]->Flush();
+			}
+			m_numFlushed.store(numWritten, std::memory_order_release);
+		}
+		if (stop)
+		{
+			return;
+		}
+		if (!hasWritten)
+		{
+			// Generations are much longer than this; polling keeps Publish wait-free
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
@@ -0,0 +1,199 @@
+#include "../include/StopCriteria.hpp"
+#include <stdexcept>
+
+
+const char* EC::GetStopReasonName(StopReason reason)
+{
+	switch (reason)
+	{
+	case STOP_NONE:               return "none";
+	case STOP_MAX_GENERATION:     return "max generation";
+	case STOP_TARGET_FITNESS:     return "target fitness";
+	case STOP_STAGNATION:         return "stagnation";
+	case STOP_DIVERSITY_COLLAPSE: return "diversity collapse";
+	case STOP_MAX_EVALUATIONS:    return "max evaluations";
+	case STOP_DEADLINE:           return "deadline";
+	case STOP_CANCELLED:          return "cancelled";
+	case STOP_CUSTOM:             return "custom";
+	}
+	return "unknown";
+}
+
+
+EC::StopCriteria::StopCriteria()
+	: m_hasTargetFitness(false), m_targetFitness(0), m_stagnationGenerations(0), m_stagnationTolerance(0),
+	m_minDiversity(0), m_maxEvaluations(0), m_timeLimit(0), m_hasFixedDeadline(false), m_pToken(NULL),
+	m_hasDeadline(false), m_hasBestFitness(false), m_bestFitness(0), m_bestGeneration(0), m_reason(STOP_NONE)
+{ }
+
+
+void EC::StopCriteria::SetTargetFitness(double targetFitness)
+{
+	m_hasTargetFitness = true;
+	m_targetFitness = targetFitness;
+}
+
+
+void EC::StopCriteria::SetStagnation(unsigned int numGenerations, double tolerance)
+{
+	if (tolerance < 0)
+	{
+		throw std::invalid_argument("received negative stagnation tolerance");
+	}
+	m_stagnationGenerations = numGenerations;
+	m_stagnationTolerance = tolerance;
+}
+
+
+void EC::StopCriteria::SetMinDiversity(double minDiversity)
+{
+	if (minDiversity < 0)
+	{
+		throw std::invalid_argument("received negative diversity");
+	}
+	m_minDiversity = minDiversity;
+}
+
+
+void EC::StopCriteria::SetMaxEvaluations(unsigned long long maxEvaluations)
+{
+	m_maxEvaluations = maxEvaluations;
+}
+
+
+void EC::StopCriteria::SetTimeLimit(double seconds)
+{
+	if (seconds < 0)
+	{
+		throw std::invalid_argument("received negative time limit");
+	}
+	m_timeLimit = seconds;
+}
+
+
+void EC::StopCriteria::SetDeadline(Clock::time_point deadline)
+{
+	m_hasFixedDeadline = true;
+	m_fixedDeadline = deadline;
+}
+
+
+void EC::StopCriteria::SetCancellationToken(const CancellationToken* pToken)
+{
+	m_pToken = pToken;
+}
+
+
+void EC::StopCriteria::AddCondition(StopCondition* pCondition)
+{
+	if (pCondition == NULL)
+	{
+		throw std::invalid_argument("received null stop condition");
+	}
+	m_conditions.push_back(pCondition);
+}
+
+
+void EC::StopCriteria::Clear()
+{
+	m_hasTargetFitness = false;
+	m_stagnationGenerations = 0;
+	m_minDiversity = 0;
+	m_maxEvaluations = 0;
+	m_timeLimit = 0;
+	m_hasFixedDeadline = false;
+	m_pToken = NULL;
+	m_conditions.clear();
+}
+
+
+void EC::StopCriteria::Start(Clock::time_point startTime)
+{
+	m_hasDeadline = m_hasFixedDeadline;
+	m_deadline = m_fixedDeadline;
+	if (m_timeLimit > 0)
+	{
+		Clock::time_point limit = startTime +
+			std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_timeLimit));
+		if (!m_hasDeadline || limit < m_deadline)
+		{
+			m_deadline = limit;
+		}
+		m_hasDeadline = true;
+	}
+	m_hasBestFitness = false;
+	m_bestGeneration = 0;
+	m_reason.store(STOP_NONE, std::memory_order_relaxed);
+	for (size_t c = 0; c < m_conditions.size(); c++)
+	{
+		m_conditions[c]->Reset();
+	}
+}
+
+
+void EC::StopCriteria::Latch(StopReason reason)
+{
+	int expected = STOP_NONE;
+	m_reason.compare_exchange_strong(expected, reason, std::memory_order_relaxed);
+}
+
+
+bool EC::StopCriteria::Poll(unsigned long long numEvaluations)
+{
+	if (m_reason.load(std::memory_order_relaxed) != STOP_NONE)
+	{
+		return true;
+	}
+	if (m_pToken != NULL && m_pToken->IsCancelled())
+	{
+		Latch(STOP_CANCELLED);
+	}
+	else if (m_maxEvaluations > 0 && numEvaluations >= m_maxEvaluations)
+	{
+		Latch(STOP_MAX_EVALUATIONS);
+	}
+	else if (m_hasDeadline && Clock::now() >= m_deadline)
+	{
+		Latch(STOP_DEADLINE);
+	}
+	return m_reason.load(std::memory_order_relaxed) != STOP_NONE;
+}
+
+
+EC::StopReason EC::StopCriteria::Check(const GenerationStatistics& record)
+{
+	if (Poll(record.numEvaluations))
+	{
+		return GetReason();
+	}
+
+	if (m_hasTargetFitness && record.bestFitness <= m_targetFitness)
+	{
+		Latch(STOP_TARGET_FITNESS);
+	}
+	else if (m_minDiversity > 0 && record.diversity < m_minDiversity)
+	{
+		Latch(STOP_DIVERSITY_COLLAPSE);
+	}
+	else if (m_stagnationGenerations > 0)
+	{
+		if (!m_hasBestFitness || record.bestFitness < m_bestFitness - m_stagnationTolerance)
+		{
+			m_hasBestFitness = true;
+			m_bestFitness = record.bestFitness;
+			m_bestGeneration = record.generation;
+		}
+		else if (record.generation - m_bestGeneration >= m_stagnationGenerations)
+		{
+			Latch(STOP_STAGNATION);
+		}
+	}
+	for (size_t c = 0; c < m_conditions.size() && GetReason() == STOP_NONE; c++)
+	{
+		if (m_conditions[c]->Check(record))
+		{
+			Latch(STOP_CUSTOM);
+		}
+	}
+	return GetReason();
+}
@@ -0,0 +1,276 @@
+#include "../include/Surrogate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace
+{
+	const double Nugget = 1e-6;               // Added to the kernel diagonal, for conditioning
+	const double MinPivot = 1e-9;             // Smaller pivots mean a redundant point
+	const double InitialLengthScale = 0.5;    // Until the first rebuild
+	const double LengthScaleFactor = 2.0;     // Length scale, in nearest-neighbour distances
+	const unsigned int MinRebuildSize = 8;
+}
+
+
+EC::KrigingSurrogate::KrigingSurrogate(unsigned int capacity)
+	: m_capacity(capacity), m_dimension(0), m_size(0), m_sizeAtRebuild(0), m_lengthScale(InitialLengthScale),
+	m_isSolved(false), m_mean(0), m_variance(0)
+{
+	if (capacity < 2)
+	{
+		throw std::invalid_argument("received surrogate capacity smaller than 2");
+	}
+}
+
+
+EC::KrigingSurrogate::~KrigingSurrogate()
+{ }
+
+
+void EC::KrigingSurrogate::Reset(const std::vector<double>& lowerBound, const std::vector<double>& upperBound)
+{
+	if (lowerBound.size() != upperBound.size() || lowerBound.empty())
+	{
+		throw std::invalid_argument("Lower and upper bounds should have the same, non-zero size");
+	}
+	m_dimension = static_cast<unsigned int>(lowerBound.size());
+	m_lowerBound = lowerBound;
+	m_scale.resize(m_dimension);
+	for (unsigned int k = 0; k < m_dimension; k++)
+	{
+		double width = upperBound[k] - lowerBound[k];
+		m_scale[k] = width > 0 ? 1.0 / width : 1.0;
+	}
+
+	m_size = 0;
+	m_sizeAtRebuild = 0;
+	m_lengthScale = InitialLengthScale;
+	m_points.assign(static_cast<size_t>(m_capacity) * m_dimension, 0);
+	m_fitness.assign(m_capacity, 0);
+	m_cholesky.assign(static_cast<size_t>(m_capacity) * m_capacity, 0);
+	m_weights.assign(m_capacity, 0);
+	m_work.assign(m_capacity, 0);
+	m_scaledPoint.assign(m_dimension, 0);
+	m_isSolved = false;
+}
+
+
+double EC::KrigingSurrogate::Kernel(const double* pA, const double* pB) const
+{
+	double squaredDistance = 0;
+	for (unsigned int k = 0; k < m_dimension; k++)
+	{
+		double d = pA[k] - pB[k];
+		squaredDistance += d * d;
+	}
+	return std::exp(-0.5 * squaredDistance / (m_lengthScale * m_lengthScale));
+}
+
+
+void EC::KrigingSurrogate::ForwardSubstitution(double* pB) const
+{
+	for (unsigned int i = 0; i < m_size; i++)
+	{
+		const double* pRow = &m_cholesky[static_cast<size_t>(i) * m_capacity];
+		double sum = pB[i];
+		for (unsigned int j = 0; j < i; j++)
+		{
+			sum -= pRow[j] * pB[j];
+		}
+		pB[i] = sum / pRow[i];
+	}
+}
+
+
+void EC::KrigingSurrogate::BackSubstitution(double* pB) const
+{
+	for (unsigned int i = m_size; i-- > 0; )
+	{
+		double sum = pB[i];
+		for (unsigned int j = i + 1; j < m_size; j++)
+		{
+			sum -= m_cholesky[static_cast<size_t>(j) * m_capacity + i] * pB[j];
+		}
+		pB[i] = sum / m_cholesky[static_cast<size_t>(i) * m_capacity + i];
+	}
+}
+
+
+bool EC::KrigingSurrogate::Append(const double* pPoint, double fitness)
+{
+	// New row of the factor: L z = k, pivot sqrt(k(x, x) - z.z)
+	double* pRow = &m_cholesky[static_cast<size_t>(m_size) * m_capacity];
+	for (unsigned int j = 0; j < m_size; j++)
+	{
+		pRow[j] = Kernel(pPoint, &m_points[static_cast<size_t>(j) * m_dimension]);
+	}
+	ForwardSubstitution(pRow);
+	double pivot = 1.0 + Nugget;
+	for (unsigned int j = 0; j < m_size; j++)
+	{
+		pivot -= pRow[j] * pRow[j];
+	}
+	if (!(pivot > MinPivot))
+	{
+		return false;
+	}
+	pRow[m_size] = std::sqrt(pivot);
+	std::memmove(&m_points[static_cast<size_t>(m_size) * m_dimension], pPoint, m_dimension * sizeof(double));
+	m_fitness[m_size] = fitness;
+	m_size++;
+	m_isSolved = false;
+	return true;
+}
+
+
+void EC::KrigingSurrogate::Rebuild(unsigned int numKept)
+{
+	// Keep the newest points, at the front
+	unsigned int first = m_size - numKept;
+	if (first > 0)
+	{
+		std::memmove(&m_points[0], &m_points[static_cast<size_t>(first) * m_dimension],
+			static_cast<size_t>(numKept) * m_dimension * sizeof(double));
+		std::memmove(&m_fitness[0], &m_fitness[first], numKept * sizeof(double));
+	}
+
+	// Length scale from the mean distance between nearest neighbours
+	double sumDistances = 0;
+	for (unsigned int i = 0; i < numKept; i++)
+	{
+		const double* pA = &m_points[static_cast<size_t>(i) * m_dimension];
+		double nearest = HUGE_VAL;
+		for (unsigned int j = 0; j < numKept; j++)
+		{
+			if (j == i)
+			{
+				continue;
+			}
+			const double* pB = &m_points[static_cast<size_t>(j) * m_dimension];
+			double squaredDistance = 0;
+			for (unsigned int k = 0; k < m_dimension; k++)
+			{
+				double d = pA[k] - pB[k];
+				squaredDistance += d * d;
+			}
+			nearest = std::min(nearest, squaredDistance);
+		}
+		sumDistances += std::sqrt(nearest);
+	}
+	double meanDistance = numKept > 1 ? sumDistances / numKept : 0;
+	if (meanDistance > 0)
+	{
+		m_lengthScale = LengthScaleFactor * meanDistance;
+	}
+
+	// Factorize again, point by point. A point only moves to a lower index.
+	m_size = 0;
+	for (unsigned int i = 0; i < numKept; i++)
+	{
+		std::memcpy(&m_scaledPoint[0], &m_points[static_cast<size_t>(i) * m_dimension], m_dimension * sizeof(double));
+		Append(&m_scaledPoint[0], m_fitness[i]);
+	}
+	m_sizeAtRebuild = m_size;
+	m_isSolved = false;
+}
+
+
+void EC::KrigingSurrogate::Add(const double* pGenes, double fitness)
+{
+	if (m_dimension == 0)
+	{
+		throw std::runtime_error("Surrogate used before Reset");
+	}
+	if (!(std::fabs(fitness) < HUGE_VAL))
+	{
+		return;
+	}
+	if (m_size == m_capacity)
+	{
+		Rebuild(m_capacity / 2);
+	}
+
+	for (unsigned int k = 0; k < m_dimension; k++)
+	{
+		m_scaledPoint[k] = (pGenes[k] - m_lowerBound[k]) * m_scale[k];
+	}
+	Append(&m_scaledPoint[0], fitness);
+
+	if (m_size >= MinRebuildSize && m_size >= 2 * m_sizeAtRebuild)
+	{
+		Rebuild(m_size);
+	}
+}
+
+
+void EC::KrigingSurrogate::Solve()
+{
+	// a = K^-1 y, b = K^-1 1; the mean is 1'K^-1 y / 1'K^-1 1 and the weights
+	// K^-1 (y - mean) = a - mean b
+	double* pA = &m_weights[0];
+	double* pB = &m_work[0];
+	for (unsigned int i = 0; i < m_size; i++)
+	{
+		pA[i] = m_fitness[i];
+		pB[i] = 1.0;
+	}
+	ForwardSubstitution(pA);
+	BackSubstitution(pA);
+	ForwardSubstitution(pB);
+	BackSubstitution(pB);
+
+	double sumA = 0, sumB = 0;
+	for (unsigned int i = 0; i < m_size; i++)
+	{
+		sumA += pA[i];
+		sumB += pB[i];
+	}
+	m_mean = sumB != 0 ? sumA / sumB : 0;
+	double sumSquares = 0;
+	for (unsigned int i = 0; i < m_size; i++)
+	{
+		pA[i] -= m_mean * pB[i];
+		sumSquares += (m_fitness[i] - m_mean) * pA[i];
+	}
+	m_variance = std::max(0.0, sumSquares / m_size);
+	m_isSolved = true;
+}
+
+
+void EC::KrigingSurrogate::Predict(const double* pGenes, double& mean, double& std)
+{
+	if (m_size == 0)
+	{
+		mean = 0;
+		std = 0;
+		return;
+	}
+	if (!m_isSolved)
+	{
+		Solve();
+	}
+
+	for (unsigned int k = 0; k < m_dimension; k++)
+	{
+		m_scaledPoint[k] = (pGenes[k] - m_lowerBound[k]) * m_scale[k];
+	}
+	double* pKernel = &m_work[0];
+	mean = m_mean;
+	for (unsigned int i = 0; i < m_size; i++)
+	{
+		pKernel[i] = Kernel(&m_scaledPoint[0], &m_points[static_cast<size_t>(i) * m_dimension]);
+		mean += pKernel[i] * m_weights[i];
+	}
+
+	// Kriging variance: sigma^2 (k(x, x) - k' K^-1 k)
+	ForwardSubstitution(pKernel);
+	double explained = 0;
+	for (unsigned int i = 0; i < m_size; i++)
+	{
+		explained += pKernel[i] * pKernel[i];
+	}
+	std = std::sqrt(m_variance * std::max(0.0, 1.0 + Nugget - explained));
+}
@@ -0,0 +1,150 @@
+#include "../include/ThreadPool.hpp"
+
+
+EC::ThreadPool::ThreadPool(unsigned int numThreads)
+	: m_pFunc(NULL), m_count(0), m_chunkSize(1), m_nextIndex(0), m_jobId(0),
+	m_activeWorkers(0), m_stop(false)
+{
+	if (numThreads == 0)
+	{
+		numThreads = std::thread::hardware_concurrency();
+		if (numThreads == 0)
+		{
+			numThreads = 1;
+		}
+	}
+	for (unsigned int i = 1; i < numThreads; i++)
+	{
+		m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+	}
+}
+
+
+EC::ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_startCondition.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+}
+
+
+void EC::ThreadPool::ParallelFor(unsigned int count, unsigned int chunkSize, const RangeFunction& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (chunkSize == 0)
+	{
+		// A few chunks per thread keeps the tail short when item costs vary
+		chunkSize = count / (GetNumThreads() * 4);
+		if (chunkSize == 0)
+		{
+			chunkSize = 1;
+		}
+	}
+
+	// Nothing to share, run on the caller
+	if (m_workers.empty() || count <= chunkSize)
+	{
+		func(0, count, 0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> jobLock(m_jobMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pFunc = &func;
+		m_count = count;
+		m_chunkSize = chunkSize;
+		m_nextIndex = 0;
+		m_exception = std::exception_ptr();
+		m_activeWorkers = static_cast<unsigned int>(m_workers.size());
+		m_jobId++;
+	}
+	m_startCondition.notify_all();
+
+	RunChunks(0);
+
+	std::exception_ptr exception;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_activeWorkers > 0)
+		{
+			m_doneCondition.wait(lock);
+		}
+		m_pFunc = NULL;
+		exception = m_exception;
+	}
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+
+void EC::ThreadPool::WorkerLoop(unsigned int threadIndex)
+{
+	unsigned int lastJobId = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (!m_stop && m_jobId == lastJobId)
+			{
+				m_startCondition.wait(lock);
+			}
+			if (m_stop)
+			{
+				return;
+			}
+			lastJobId = m_jobId;
+		}
+
+		RunChunks(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_activeWorkers--;
+		}
+		m_doneCondition.notify_one();
+	}
+}
+
+
+void EC::ThreadPool::RunChunks(unsigned int threadIndex)
+{
+	while (true)
+	{
+		unsigned int begin = m_nextIndex.fetch_add(m_chunkSize);
+		if (begin >= m_count)
+		{
+			return;
+		}
+		unsigned int end = begin + m_chunkSize;
+		if (end > m_count || end < begin)
+		{
+			end = m_count;
+		}
+		try
+		{
+			(*m_pFunc)(begin, end, threadIndex);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_exception)
+			{
+				m_exception = std::current_exception();
+			}
+			// Skip the remaining chunks
+			m_nextIndex = m_count;
+		}
+	}
+}
@@ -1,12 +1,331 @@
 #include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "Logger.hpp"
 
 using namespace Util;
 
 #ifdef FILE_LOG_TO_FILE
 	FILE* pFile = fopen("My.log", "w");
-	FILE* OutputToFile::m_pStream = pFile;
+	std::atomic<FILE*> OutputToFile::m_pStream(pFile);
 #else
-	FILE* OutputToFile::m_pStream = stdout;
+	std::atomic<FILE*> OutputToFile::m_pStream(stdout);
 #endif
 
+
+namespace
+{
+	/// One queued message
+	struct LogRecord
+	{
+		long long    timestamp;   // steady_clock, nanoseconds
+		LogLevel     level;
+		unsigned int threadIndex;
+		std::string  message;
+	};
+
+	inline bool EarlierRecord(const LogRecord* pLeft, const LogRecord* pRight)
+	{
+		return pLeft->timestamp < pRight->timestamp;
+	}
+
+	/// Single-producer single-consumer ring owned by one logging thread. The strings of
+	/// the slots keep their capacity, so a warm queue doesn't allocate.
+	struct ThreadQueue
+	{
+		static const size_t Capacity = 4096;
+
+		explicit ThreadQueue(unsigned int index)
+			: slots(Capacity + 1), head(0), tail(0), isRetired(false), threadIndex(index)
+		{ }
+
+		std::vector<LogRecord> slots;
+		char                padding0[64];
+		std::atomic<size_t> head;       // Written by the writer thread
+		char                padding1[64];
+		std::atomic<size_t> tail;       // Written by the logging thread
+		char                padding2[64];
+		std::atomic<bool>   isRetired;  // The logging thread has exited
+		unsigned int        threadIndex;
+	};
+
+
+	/// Registry of the thread queues and background writer
+	class AsyncWriter
+	{
+	public:
+		static AsyncWriter& Instance()
+		{
+			static AsyncWriter writer;
+			return writer;
+		}
+
+		/// Queue of the calling thread, created on first use
+		ThreadQueue* GetThreadQueue();
+
+		/// Called by the logging thread when it exits
+		void Retire(ThreadQueue* pQueue)
+		{
+			pQueue->isRetired.store(true, std::memory_order_release);
+		}
+
+		void Enqueue(LogLevel level, long long timestamp, const std::string& message);
+
+		/// Wait until every record queued so far is written
+		void Flush();
+
+		~AsyncWriter();
+
+	private:
+		AsyncWriter();
+
+		void Run();
+
+		/// Move queued records to the batch. Returns the number of records taken.
+		size_t Drain();
+
+		/// Write the batch to the current stream
+		void WriteBatch(FILE* pStream);
+
+	private:
+		std::mutex                m_mutex;        // Guards m_queues
+		std::vector<ThreadQueue*> m_queues;
+		unsigned int              m_numThreads;
+
+		std::thread               m_thread;
+		std::atomic<bool>         m_stop;
+		std::atomic<unsigned long long> m_numQueued;
+		std::atomic<unsigned long long> m_numWritten;
+
+		// Writer thread only
+		std::vector<LogRecord>        m_batch;
+		std::vector<const LogRecord*> m_order;
+		std::string                   m_line;
+		time_t                        m_dateSeconds;  // Second formatted in m_date
+		char                          m_date[32];
+
+		// Wall-clock time of a steady_clock reading, to date the records
+		long long m_steadyOrigin;
+		long long m_systemOrigin;
+	};
+
+
+	/// Retires the queue of a thread when the thread exits
+	struct ThreadQueueHolder
+	{
+		ThreadQueueHolder() : pQueue(NULL) { }
+		~ThreadQueueHolder()
+		{
+			if (pQueue != NULL)
+			{
+				AsyncWriter::Instance().Retire(pQueue);
+			}
+		}
+		ThreadQueue* pQueue;
+	};
+
+	thread_local ThreadQueueHolder t_queueHolder;
+
+
+	AsyncWriter::AsyncWriter()
+		: m_numThreads(0), m_stop(false), m_numQueued(0), m_numWritten(0), m_dateSeconds(-1)
+	{
+		m_date[0] = '\0';
+		m_steadyOrigin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		m_systemOrigin = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		m_thread = std::thread(&AsyncWriter::Run, this);
+	}
+
+
+	AsyncWriter::~AsyncWriter()
+	{
+		m_stop.store(true, std::memory_order_release);
+		m_thread.join();
+		for (size_t q = 0; q < m_queues.size(); q++)
+		{
+			delete m_queues[q];
+		}
+	}
+
+
+	ThreadQueue* AsyncWriter::GetThreadQueue()
+	{
+		if (t_queueHolder.pQueue == NULL)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			t_queueHolder.pQueue = new ThreadQueue(m_numThreads++);
+			m_queues.push_back(t_queueHolder.pQueue);
+		}
+		return t_queueHolder.pQueue;
+	}
+
+
+	void AsyncWriter::Enqueue(LogLevel level, long long timestamp, const std::string& message)
+	{
+		ThreadQueue* pQueue = GetThreadQueue();
+		size_t tail = pQueue->tail.load(std::memory_order_relaxed);
+		size_t next = tail + 1 == pQueue->slots.size() ? 0 : tail + 1;
+		// Full: wait for the writer rather than lose the message
+		while (next == pQueue->head.load(std::memory_order_acquire))
+		{
+			std::this_thread::yield();
+		}
+		LogRecord& record = pQueue->slots[tail];
+		record.timestamp = timestamp;
+		record.level = level;
+		record.threadIndex = pQueue->threadIndex;
+		record.message = message;
+		m_numQueued.fetch_add(1, std::memory_order_relaxed);
+		pQueue->tail.store(next, std::memory_order_release);
+	}
+
+
+	void AsyncWriter::Flush()
+	{
+		unsigned long long numQueued = m_numQueued.load(std::memory_order_acquire);
+		while (m_numWritten.load(std::memory_order_acquire) < numQueued)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+
+
+	size_t AsyncWriter::Drain()
+	{
+		size_t numTaken = 0;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t q = 0; q < m_queues.size(); )
+		{
+			ThreadQueue* pQueue = m_queues[q];
+			// Read before draining: a retired queue gets no more records
+			bool isRetired = pQueue->isRetired.load(std::memory_order_acquire);
+			size_t head = pQueue->head.load(std::memory_order_relaxed);
+			size_t tail = pQueue->tail.load(std::memory_order_acquire);
+			while (head != tail)
+			{
+				if (numTaken == m_batch.size())
+				{
+					m_batch.resize(numTaken + 1);
+				}
+				std::swap(m_batch[numTaken], pQueue->slots[head]);
+				numTaken++;
+				head = head + 1 == pQueue->slots.size() ? 0 : head + 1;
+			}
+			pQueue->head.store(head, std::memory_order_release);
+
+			if (isRetired)
+			{
+				delete pQueue;
+				m_queues.erase(m_queues.begin() + q);
+			}
+			else
+			{
+				q++;
+			}
+		}
+		return numTaken;
+	}
+
+
+	void AsyncWriter::WriteBatch(FILE* pStream)
+	{
+		static const char* levelNames[] = { "ERROR  ", "WARNING", "INFO   ", "DEBUG  ", "VERBOSE" };
+
+		// Merge the threads by time
+		std::stable_sort(m_order.begin(), m_order.end(), EarlierRecord);
+		for (size_t r = 0; r < m_order.size(); r++)
+		{
+			const LogRecord& record = *m_order[r];
+			long long wallTime = m_systemOrigin + (record.timestamp - m_steadyOrigin);
+			time_t seconds = static_cast<time_t>(wallTime / 1000000000LL);
+			long nanoseconds = static_cast<long>(wallTime % 1000000000LL);
+			if (nanoseconds < 0)
+			{
+				seconds--;
+				nanoseconds += 1000000000L;
+			}
+			if (seconds != m_dateSeconds)
+			{
+				// The time zone lookup is slow: once per second of log
+				struct tm ts;
+#ifdef _WIN32
+				localtime_s(&ts, &seconds);
+#else
+				localtime_r(&seconds, &ts);
+#endif
+				strftime(m_date, sizeof(m_date), "%d/%m/%y %H:%M:%S", &ts);
+				m_dateSeconds = seconds;
+			}
+			char prefix[96];
+			snprintf(prefix, sizeof(prefix), "%s.%09ld %s [%u] ", m_date, nanoseconds,
+				levelNames[record.level], record.threadIndex);
+			m_line.assign(prefix);
+			m_line.append(record.message);
+			fwrite(m_line.data(), 1, m_line.size(), pStream);
+		}
+		fflush(pStream);
+	}
+
+
+	void AsyncWriter::Run()
+	{
+		unsigned int numIdleRounds = 0;
+		while (true)
+		{
+			// Read the flag first: records queued before the stop are still written
+			bool stop = m_stop.load(std::memory_order_acquire);
+			size_t numTaken = Drain();
+			if (numTaken > 0)
+			{
+				FILE* pStream = OutputToFile::GetStream();
+				if (pStream != NULL)
+				{
+					m_order.resize(numTaken);
+					for (size_t r = 0; r < numTaken; r++)
+					{
+						m_order[r] = &m_batch[r];
+					}
+					WriteBatch(pStream);
+				}
+				m_numWritten.fetch_add(numTaken, std::memory_order_release);
+			}
+			if (stop)
+			{
+				return;
+			}
+			// Poll quickly while messages keep coming, slowly when the program is quiet
+			numIdleRounds = numTaken > 0 ? 0 : numIdleRounds + 1;
+			if (numIdleRounds > 0)
+			{
+				std::this_thread::sleep_for(numIdleRounds < 1000 ?
+					std::chrono::microseconds(20) : std::chrono::microseconds(1000));
+			}
+		}
+	}
+}
+
+
+void OutputToFile::SetStream(FILE* pStream)
+{
+	Flush();
+	m_pStream.store(pStream, std::memory_order_relaxed);
+}
+
+
+void OutputToFile::Output(LogLevel level, long long timestamp, const std::string& msg)
+{
+	AsyncWriter::Instance().Enqueue(level, timestamp, msg);
+}
+
+
+void OutputToFile::Flush()
+{
+	AsyncWriter::Instance().Flush();
+}
@@ -1,11 +1,11 @@
 /*
 * FILE:   Logger.hpp
 * AUTHOR: Jinchao Liu
-* DATE: 
+* DATE:
 * BRIEF:  A logger class which helps trace functions for debugging.
 * USAGE:
 *        In Logger.hpp:
-* 
+*
 *            // Enable the following line if logging into file is desired.
 *            //#define FILE_LOG_TO_FILE
 *
@@ -15,38 +15,50 @@
 *            //#define FILE_LOG_INFO
 *            #define FILE_LOG_DEBUG
 *            //#define FILE_LOG_VERBOSE
-* 
+*
 *        In your files:
 *
 *            returnValue YourFunc(inputValue)
 *	     {
-*	         FuncTraceBeginM(LOG_VERBOSE, "");                       
-*                // Do something             
+*	         FuncTraceBeginM(LOG_VERBOSE, "");
+*                // Do something
 *                FuncTraceEndM(LOG_VERBOSE, "");
 *            }
 *
 *        Typical Output:
-*            : dd/mm/yy hh:mm:ss DEBUG YourFunc() Begin
-*            : dd/mm/yy hh:mm:ss DEBUG YourFunc(), Elapsed time: xx seconds
-*            : dd/mm/yy hh:mm:ss DEBUG YourFunc() End
+*            : dd/mm/yy hh:mm:ss.nnnnnnnnn DEBUG   [thread] YourFunc() Begin
+*            : dd/mm/yy hh:mm:ss.nnnnnnnnn DEBUG   [thread] YourFunc(), Elapsed time: xx seconds
+*            : dd/mm/yy hh:mm:ss.nnnnnnnnn DEBUG   [thread] YourFunc() End
 *
+*        Messages are formatted into a string on the calling thread, then handed with
+*        their level and a std::chrono::steady_clock timestamp to a lock-free queue owned
+*        by that thread. A background thread drains the queues, merges the records by
+*        timestamp, adds the date and level and writes them. Call OutputToFile::Flush to
+*        wait until everything logged so far is written.
+*
+*        Levels above the one selected below are removed at compile time: their FILE_LOG
+*        statements are behind a constant false condition and generate no code.
 */
 #ifndef Util_Logger_Hpp
 #define Util_Logger_Hpp
 
 #include <stdio.h>
-#include <time.h>
-#include <string>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <sstream>
+#include <string>
+#ifdef _WIN32
 #include <Windows.h>
-#include <cstdio>
+#endif
 
 
 namespace Util
 {
 using namespace std;
 
-// Enable the following line if logging into file is desired. 
+// Enable the following line if logging into file is desired.
 //#define FILE_LOG_TO_FILE
 
 // Logging levels
@@ -57,8 +69,8 @@ using namespace std;
 //#define FILE_LOG_VERBOSE
 
 
-/// \brief Log levels. There are five basic levels: ERROR, WARNING, INFO, DEBUG, VERBOSE. 
-enum LogLevel 
+/// \brief Log levels. There are five basic levels: ERROR, WARNING, INFO, DEBUG, VERBOSE.
+enum LogLevel
 {
 	LOG_ERROR   = 0,  // Errors
 	LOG_WARNING = 1,  // Warings
@@ -67,106 +79,132 @@ enum LogLevel
 	LOG_VERBOSE = 4   // Everything
 };
 
+/// Most detailed level compiled in
+#if defined(FILE_LOG_VERBOSE)
+#define FILE_LOG_MAX_LEVEL 4
+#elif defined(FILE_LOG_DEBUG)
+#define FILE_LOG_MAX_LEVEL 3
+#elif defined(FILE_LOG_INFO)
+#define FILE_LOG_MAX_LEVEL 2
+#elif defined(FILE_LOG_WARNING)
+#define FILE_LOG_MAX_LEVEL 1
+#else
+#define FILE_LOG_MAX_LEVEL 0
+#endif
+
 
-/// \brief A lightweight timer class.
+/// \brief A lightweight timer class, nanosecond resolution.
 class Timer
 {
 public:
+	Timer() : m_elapsedTime(0) { }
+
 	/// \brief Start timer
 	inline void Start()
 	{
-		m_beginTime = GetTickCount();
+		m_beginTime = std::chrono::steady_clock::now();
 	}
 
 	/// \brief Stop timer
 	inline void Stop()
 	{
-		DWORD endTime = GetTickCount();
-		m_elapsedTime = endTime - m_beginTime;	
+		m_elapsedTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - m_beginTime).count();
+	}
+
+	/// \brief Get the elapsed time
+	/// \return elapsed time in seconds, double.
+	inline double GetElapsedTime() const
+	{
+		return m_elapsedTime / 1e9;
 	}
 
 	/// \brief Get the elapsed time
-	/// \return elapsed time, double.
-	inline double GetElapsedTime()
+	/// \return elapsed time in nanoseconds
+	inline long long GetElapsedNanoseconds() const
 	{
-		return m_elapsedTime/1000.0;	
+		return m_elapsedTime;
 	}
 
 private:
-	DWORD m_beginTime;
-	DWORD m_elapsedTime;
+	std::chrono::steady_clock::time_point m_beginTime;
+	long long                             m_elapsedTime;
 };
 
 
-/// \brief Output policy. 
-class OutputToFile 
+/// \brief Output policy. Records are queued by the calling thread and written to the
+///        stream by a background thread.
+class OutputToFile
 {
 public:
-    	inline static FILE* GetStream()
-    	{		
-		return m_pStream;
-    	}
-
-    	inline static void SetStream(FILE* pStream)
-    	{
-		m_pStream = pStream;
-    	}
-
-	    /// \brief Output a message string to the stream
-	    /// \param[in] message. std::string&.
-	    inline static void Output(const std::string& msg)
-	    {
-		if(!m_pStream)
-		{ 
-			m_pStream = stdout; 
-		}
-		fprintf(m_pStream, "%s", msg.c_str());
-	        fflush(m_pStream);
-	    }
+	/// \brief Get the stream written by the background thread
+	/// \return The stream, NULL if logging is off
+	inline static FILE* GetStream()
+	{
+		return m_pStream.load(std::memory_order_relaxed);
+	}
+
+	/// \brief Set the stream. Records queued so far are written to the previous one.
+	/// \param[in] pStream. Stream, not owned. NULL turns logging off.
+	static void SetStream(FILE* pStream);
+
+	/// \brief Queue a message. Never does I/O; waits only if the queue of the calling
+	///        thread is full.
+	/// \param[in] level. Log level
+	/// \param[in] timestamp. std::chrono::steady_clock time, in nanoseconds
+	/// \param[in] msg. Message string
+	static void Output(LogLevel level, long long timestamp, const std::string& msg);
+
+	/// \brief Wait until every queued message is written and the stream flushed
+	static void Flush();
+
 private:
-    	static FILE* m_pStream;
+	static std::atomic<FILE*> m_pStream;
 };
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Logger
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-/// \brief A class for logging and debugging.
+/// \brief A class for logging and debugging. One temporary per message: the message is
+///        queued when the Logger is destroyed, at the end of the FILE_LOG statement.
 template<typename OutputPolicy>
 class Logger
 {
 public:
-    	/// \brief Constructor 
+	/// \brief Constructor
 	Logger();
 
-    	/// \brief Destructor 
-    	virtual ~Logger();
+	/// \brief Destructor
+	virtual ~Logger();
 
-    	/// \brief Return a std::ostringstream
-    	/// \param[in] Desired log level
-    	/// \return std::ostringstream
-    	std::ostringstream& Get(LogLevel level = LOG_INFO);	
+	/// \brief Return a std::ostringstream
+	/// \param[in] Desired log level
+	/// \return std::ostringstream
+	std::ostringstream& Get(LogLevel level = LOG_INFO);
 
-    	/// \brief Report the current level.
-    	/// \return The current level
-    	inline static LogLevel& ReportingLevel(){ return m_reportingLevel; }
-	
-    	/// \brief Get the timer
-    	/// \return Timer
-    	inline static Timer& GetTimer(){ return m_timer; }
+	/// \brief Report the current level.
+	/// \return The current level
+	inline static LogLevel& ReportingLevel(){ return m_reportingLevel; }
+
+	/// \brief Get the timer
+	/// \return Timer
+	inline static Timer& GetTimer(){ return m_timer; }
 
 protected:
-    	std::ostringstream os;
+	std::ostringstream os;
 
 private:
-    	Logger(const Logger&){}
-    	Logger& operator =(const Logger&){}
-    	static const string GetCurrentTime();
+	Logger(const Logger&);
+	Logger& operator =(const Logger&);
 
 private:
-    	static Timer    m_timer;
-    	static LogLevel m_reportingLevel;
-    	static string   m_logLevelName[]; 
+	LogLevel  m_level;
+	long long m_timestamp;
+	bool      m_hasMessage;
+
+	static Timer    m_timer;
+	static LogLevel m_reportingLevel;
 };
 
 
@@ -174,65 +212,34 @@ private:
 // Implementation
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename OutputPolicy>
-std::string Logger<OutputPolicy>::m_logLevelName[] = {
-	"ERROR  ", "WARNING", "INFO   ", "DEBUG  ", "VERBOSE"
-};
-
-#ifdef FILE_LOG_ERROR
-template<typename OutputPolicy>
-LogLevel Logger<OutputPolicy>::m_reportingLevel = LogLevel::LOG_ERROR;
-#endif
-
-#ifdef FILE_LOG_WARNING
-template<typename OutputPolicy>
-LogLevel Logger<OutputPolicy>::m_reportingLevel = LogLevel::LOG_WARNING;
-#endif
-
-#ifdef FILE_LOG_INFO
-template<typename OutputPolicy>
-LogLevel Logger<OutputPolicy>::m_reportingLevel = LogLevel::LOG_INFO;
-#endif
-
-#ifdef FILE_LOG_DEBUG
-template<typename OutputPolicy>
-LogLevel Logger<OutputPolicy>::m_reportingLevel = LogLevel::LOG_DEBUG;
-#endif
-
-#ifdef FILE_LOG_VERBOSE
-template<typename OutputPolicy>
-LogLevel Logger<OutputPolicy>::m_reportingLevel = LogLevel::LOG_VERBOSE;
-#endif
+LogLevel Logger<OutputPolicy>::m_reportingLevel = static_cast<LogLevel>(FILE_LOG_MAX_LEVEL);
 
 template<typename OutputPolicy>
 Timer Logger<OutputPolicy>::m_timer = Timer();
 
 template<typename OutputPolicy>
-Logger<OutputPolicy>::Logger(){ }
+Logger<OutputPolicy>::Logger()
+	: m_level(LOG_INFO), m_timestamp(0), m_hasMessage(false)
+{ }
 
 template<typename OutputPolicy>
 Logger<OutputPolicy>::~Logger()
 {
-    OutputPolicy::Output(os.str());
-}
-
-/// WARNING!!! Not thread-safe. 
-template<typename OutputPolicy>
-const std::string Logger<OutputPolicy>::GetCurrentTime()
-{
-    time_t now = time(0);
-    struct tm  ts;
-    char buf[80];
-    ts = *localtime(&now);    
-    strftime(buf, sizeof(buf), "%d/%m/%y %X", &ts);
-    return buf;
+	if (m_hasMessage)
+	{
+		OutputPolicy::Output(m_level, m_timestamp, os.str());
+	}
 }
 
 template<typename OutputPolicy>
 std::ostringstream& Logger<OutputPolicy>::Get(LogLevel level)
 {
-    os << ""  << GetCurrentTime();
-    os << " " << m_logLevelName[level] << " ";
-    return os;
+	// Only the raw timestamp is taken here; the date is formatted by the writer thread
+	m_level = level;
+	m_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	m_hasMessage = true;
+	return os;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -241,37 +248,33 @@ std::ostringstream& Logger<OutputPolicy>::Get(LogLevel level)
 typedef Logger<OutputToFile> FileLogger;
 
 #define FILE_LOG(level) \
-if (level > FileLogger::ReportingLevel() || !OutputToFile::GetStream()) ; \
+if (level > FILE_LOG_MAX_LEVEL || level > FileLogger::ReportingLevel() || !OutputToFile::GetStream()) ; \
 else FileLogger().Get(level)
 
 #define FILE_LOG_START_TIMER(level) \
-if (level > FileLogger::ReportingLevel() || !OutputToFile::GetStream()) ; \
-else FileLogger().GetTimer().Start()
+if (level > FILE_LOG_MAX_LEVEL || level > FileLogger::ReportingLevel() || !OutputToFile::GetStream()) ; \
+else FileLogger::GetTimer().Start()
 
 #define FILE_LOG_STOP_TIMER(level) \
-if (level > FileLogger::ReportingLevel() || !OutputToFile::GetStream()) ; \
-else FileLogger().GetTimer().Stop()
+if (level > FILE_LOG_MAX_LEVEL || level > FileLogger::ReportingLevel() || !OutputToFile::GetStream()) ; \
+else FileLogger::GetTimer().Stop()
 
 #define FILE_LOG_ELAPSED_TIME \
-FileLogger().GetTimer().GetElapsedTime()
+FileLogger::GetTimer().GetElapsedTime()
 
 /// \brief Macro for logging function info, begin
-#ifndef NDEBUG
-
-#ifdef WIN32 
 #define FuncName __FUNCTION__
-#else 
-#define FuncName 
-#endif 
+
+#ifndef NDEBUG
 
 #define FuncTraceBeginM(LogLevel, Msg) \
 FILE_LOG(LogLevel) << FuncName << "(), Begin" << std::endl; \
 if(strcmp(Msg, "")!=0){FILE_LOG(LogLevel) << FuncName << "(), " << Msg << std::endl;}\
-FILE_LOG_START_TIMER(LogLevel); 
+FILE_LOG_START_TIMER(LogLevel);
 
 #else  // NDEBUG
-#define FuncTraceBeginM(Msg) 
-#endif 
+#define FuncTraceBeginM(LogLevel, Msg)
+#endif
 
 #ifndef NDEBUG
 
@@ -282,8 +285,8 @@ FILE_LOG(LogLevel) << FuncName << "(), Elapsed time : " << FILE_LOG_ELAPSED_TIME
 FILE_LOG(LogLevel) << FuncName << "(), End" << std::endl; \
 
 #else  // NDEBUG
-#define FuncTraceEndM(Msg) 
-#endif 
+#define FuncTraceEndM(LogLevel, Msg)
+#endif
 
 
 #ifndef NDEBUG
@@ -291,15 +294,19 @@ FILE_LOG(LogLevel) << FuncName << "(), End" << std::endl; \
 FILE_LOG(LogLevel) << FuncName << "(), Begin" << std::endl; \
 if(strcmp(Msg, "")!=0){FILE_LOG(LogLevel) << FuncName << "(), " << Msg << std::endl;}
 #else  // NDEBUG
-#define LogInfoM(LogLevel, Msg) 
-#endif 
+#define LogInfoM(LogLevel, Msg)
+#endif
 
 
 #ifndef Macro_ThrowMessageBox
 #define Macro_ThrowMessageBox
+#ifdef _WIN32
 #define Throw_MessageBox(msg, title) \
-	MessageBox(NULL, msg, title, MB_OK | MB_ICONWARNING | MB_HELP); 
+	MessageBox(NULL, msg, title, MB_OK | MB_ICONWARNING | MB_HELP);
+#else
+#define Throw_MessageBox(msg, title) \
+	fprintf(stderr, "%s: %s\n", title, msg);
+#endif
 #endif
 }
 #endif
-